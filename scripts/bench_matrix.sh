@@ -0,0 +1,32 @@
+#!/bin/sh
+# Run the app_bench benchmark on native_sim for a matrix of RX DMA block
+# sizes and numbers, and collect the "BENCH" JSON lines.
+#
+# usage: scripts/bench_matrix.sh [output file]
+#
+# Every line of the output is a JSON object. Configuration lines come first,
+# then one line per packet size and burst pattern.
+
+set -e
+
+OUT=${1:-bench_output.txt}
+BUILD_DIR=build_bench
+BLOCK_SIZES="32 64 128 256"
+BLOCK_NUMBERS="2 4 8"
+
+: > "$OUT"
+
+for size in $BLOCK_SIZES; do
+    for num in $BLOCK_NUMBERS; do
+        west build -p -d "$BUILD_DIR" -b native_sim -- \
+            -DCONF_FILE=prj_bench.conf \
+            -DCONFIG_APP_UART_RX_DMA_BLOCK_SIZE="$size" \
+            -DCONFIG_APP_UART_RX_DMA_BLOCK_NUMBER="$num" > /dev/null
+
+        "$BUILD_DIR"/zephyr/zephyr.exe -stop_at=600 | \
+            sed -n 's/^BENCH //p' | \
+            grep -v '^DONE' >> "$OUT"
+    done
+done
+
+echo "Results written to $OUT"
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Generate the slicing tables of src/app_crc.
+
+Run by src/app_crc/CMakeLists.txt at build time:
+
+    scripts/gen_crc_tables.py --slices 4 -o app_crc_tables.h
+
+Both CRCs are reflected, like crc16_ccitt() and crc32_ieee() of Zephyr:
+    CRC16-CCITT polynomial 0x1021, reflected 0x8408
+    CRC32-IEEE  polynomial 0x04C11DB7, reflected 0xEDB88320
+
+Table 0 is the classic byte table. Table k gives the CRC of a byte followed
+by k zero bytes, so k + 1 bytes are folded in with one lookup per byte:
+    table[k][n] = (table[k - 1][n] >> 8) ^ table[0][table[k - 1][n] & 0xFF]
+"""
+
+import argparse
+import sys
+
+CRCS = (
+    # name, C type, reflected polynomial, hex digits
+    ("app_crc16_ccitt_table", "uint16_t", 0x8408, 4),
+    ("app_crc32_ieee_table", "uint32_t", 0xEDB88320, 8),
+)
+
+
+def byte_table(poly):
+    table = []
+    for n in range(256):
+        crc = n
+        for _ in range(8):
+            crc = (crc >> 1) ^ (poly if crc & 1 else 0)
+        table.append(crc)
+    return table
+
+
+def sliced_tables(poly, slices):
+    tables = [byte_table(poly)]
+    for _ in range(1, slices):
+        prev = tables[-1]
+        tables.append([(v >> 8) ^ tables[0][v & 0xFF] for v in prev])
+    return tables
+
+
+def emit(out, name, ctype, poly, digits, slices):
+    out.write(f"static const {ctype} {name}[{slices}][256] = {{\n")
+    for table in sliced_tables(poly, slices):
+        out.write("    {\n")
+        for row in range(0, 256, 8):
+            words = ", ".join(f"0x{v:0{digits}X}" for v in table[row:row + 8])
+            out.write(f"        {words},\n")
+        out.write("    },\n")
+    out.write("};\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--slices", type=int, choices=(1, 4, 8), default=4,
+                        help="bytes folded in per step")
+    parser.add_argument("-o", "--output", default="-", help="header to write")
+    args = parser.parse_args()
+
+    out = sys.stdout if args.output == "-" else open(args.output, "w")
+    out.write("/* Generated by scripts/gen_crc_tables.py, do not edit */\n\n")
+    out.write(f"#define APP_CRC_TABLE_SLICES {args.slices}\n\n")
+    for i, crc in enumerate(CRCS):
+        if i:
+            out.write("\n")
+        emit(out, *crc, args.slices)
+    if out is not sys.stdout:
+        out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Decode the app_uart binary event trace.
+
+Capture the output of the "uart trace dump" shell command (RTT or serial
+log, other lines are ignored) and run:
+
+    scripts/uart_trace_decode.py capture.txt
+
+Every record is 8 bytes, little endian:
+    uint32 timestamp in cycles, uint8 event, uint8 port index, uint16 argument
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+# keep in sync with enum app_uart_trace_event in src/app_uart/app_uart_trace.h
+EVENTS = {
+    1: ("TX_START", "bytes"),
+    2: ("TX_DONE", "bytes"),
+    3: ("TX_ABORTED", "bytes"),
+    4: ("TX_ERROR", "bytes"),
+    5: ("RX_RDY", "bytes"),
+    6: ("RX_DROP", "bytes"),
+    7: ("RX_BUF_REQUEST", "block"),
+    8: ("RX_BUF_RELEASED", "block"),
+    9: ("RX_DISABLED", None),
+    10: ("RX_STOPPED", "reason"),
+    11: ("RX_DISPATCH", "bytes"),
+    12: ("RX_DISPATCHED", "bytes"),
+    13: ("RX_REARM", None),
+    14: ("PM_SUSPEND", None),
+    15: ("PM_RESUME", "rx"),
+    16: ("RX_POINT", "len"),
+    17: ("RX_FRAME_END", "late"),
+}
+
+RECORD = struct.Struct("<IBBH")
+BEGIN = re.compile(r"TRACE BEGIN v1 hz=(\d+) records=(\d+) lost=(\d+)")
+DATA = re.compile(r"TRACE ([0-9a-fA-F]+)\s*$")
+
+
+def parse(lines):
+    """Return (hz, lost, records) of the last complete dump."""
+    dumps = []
+    current = None
+
+    for line in lines:
+        m = BEGIN.search(line)
+        if m:
+            current = {"hz": int(m.group(1)), "lost": int(m.group(3)), "raw": bytearray()}
+            continue
+        if current is None:
+            continue
+        if "TRACE END" in line:
+            dumps.append(current)
+            current = None
+            continue
+        m = DATA.search(line)
+        if m:
+            current["raw"] += bytes.fromhex(m.group(1))
+
+    if not dumps:
+        raise ValueError("no complete trace dump found")
+
+    dump = dumps[-1]
+    raw = dump["raw"][: len(dump["raw"]) - len(dump["raw"]) % RECORD.size]
+    return dump["hz"], dump["lost"], list(RECORD.iter_unpack(raw))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="log capture with a \"uart trace dump\" output, stdin by default")
+    parser.add_argument("--csv", action="store_true", help="print CSV instead of a table")
+    args = parser.parse_args()
+
+    try:
+        hz, lost, records = parse(args.capture)
+    except ValueError as e:
+        sys.exit(f"error: {e}")
+
+    if not records:
+        print("empty trace")
+        return
+
+    if args.csv:
+        print("time_us,delta_us,port,event,arg")
+    else:
+        print(f"{len(records)} records, {lost} lost, {hz} Hz cycle counter")
+        print(f"{'time us':>12} {'delta us':>10} {'port':>4}  {'event':<16} arg")
+
+    # timestamps are 32 bit cycles, differences are taken modulo 2^32
+    t = 0
+    prev = records[0][0]
+    for ts, event, port, arg in records:
+        delta = ((ts - prev) & 0xFFFFFFFF) * 1e6 / hz
+        t += delta
+        prev = ts
+
+        name, unit = EVENTS.get(event, (f"UNKNOWN({event})", "arg"))
+        if unit is None:
+            value = ""
+        elif unit == "block" and arg == 0xFFFF:
+            value = "exhausted"
+        else:
+            value = f"{unit}={arg}"
+
+        if args.csv:
+            print(f"{t:.3f},{delta:.3f},{port},{name},{arg}")
+        else:
+            print(f"{t:12.3f} {delta:10.3f} {port:>4}  {name:<16} {value}")
+
+
+if __name__ == "__main__":
+    main()
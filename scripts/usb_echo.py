@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Echo everything received on a serial port back to it.
+
+Host side of the app_bench benchmark over USB CDC ACM (bench_usb.conf),
+which expects its TX looped back to RX:
+
+    scripts/usb_echo.py /dev/ttyACM0
+
+Needs pyserial. The baud rate doesn't matter for CDC ACM.
+"""
+
+import argparse
+import sys
+import time
+
+try:
+    import serial
+except ImportError:
+    sys.exit("error: pyserial is required, pip install pyserial")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("port", help="serial port, e.g. /dev/ttyACM0 or COM5")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    # wait for the device to enumerate after a reset
+    while True:
+        try:
+            ser = serial.Serial(args.port, args.baud, timeout=0.01)
+            break
+        except serial.SerialException:
+            time.sleep(0.2)
+
+    total = 0
+    with ser:
+        # DTR tells the device that the host is ready
+        ser.dtr = True
+        print(f"echoing on {args.port}, Ctrl+C to stop")
+        try:
+            while True:
+                data = ser.read(max(1, ser.in_waiting))
+                if data:
+                    ser.write(data)
+                    total += len(data)
+        except KeyboardInterrupt:
+            pass
+        except serial.SerialException as e:
+            print(f"port closed: {e}")
+
+    print(f"{total} bytes echoed")
+
+
+if __name__ == "__main__":
+    main()
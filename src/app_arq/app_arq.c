@@ -0,0 +1,548 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "app_arq.h"
+#include "app_crc.h"
+#include "app_framer.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_arq, CONFIG_APP_ARQ_LOG_LEVEL);
+
+/* Selective repeat over the frames of the app_framer in use:
+ * | APP_ARQ_TAG | type | seq | ack | payload | CRC16-CCITT of the rest (LE) |
+ * ack is the cumulative acknowledgement, the next sequence number expected
+ * from the peer, carried by every frame. An ACK frame has no payload but a
+ * 32 bit selective ACK: bit i set if seq ack + 1 + i is received already.
+ * The CRC makes the transport safe on framers without one.
+ */
+#define ARQ_HDR_LEN 4
+#define ARQ_CRC_LEN 2
+#define ARQ_CRC_SEED 0xFFFF
+#define ARQ_FRAME_MAX (ARQ_HDR_LEN + CONFIG_APP_ARQ_MAX_PAYLOAD + ARQ_CRC_LEN)
+#define ARQ_ACK_LEN (ARQ_HDR_LEN + 4 + ARQ_CRC_LEN)
+
+BUILD_ASSERT(ARQ_HDR_LEN + ARQ_CRC_LEN == APP_ARQ_OVERHEAD);
+
+#define ARQ_WINDOW CONFIG_APP_ARQ_WINDOW
+
+/* seq % ARQ_WINDOW picks the slot, the 8 bit seq must wrap onto the same slots */
+BUILD_ASSERT(IS_POWER_OF_TWO(ARQ_WINDOW), "CONFIG_APP_ARQ_WINDOW must be a power of two");
+
+/* the timeout doubles while the peer doesn't answer, up to this */
+#define ARQ_RTO_MAX_MS (8 * CONFIG_APP_ARQ_RTO_MS)
+
+/* an ACK goes out at once after this many frames in order */
+#define ARQ_ACK_EVERY MAX(1, ARQ_WINDOW / 4)
+
+enum arq_type {
+    ARQ_DATA,
+    ARQ_ACK,
+};
+
+struct arq_tx_slot {
+    uint32_t sent_ms;       // k_uptime_get_32() of the last transmission
+    uint16_t len;           // of the frame
+    bool acked;             // by a selective ACK, the cumulative one frees the slot
+    bool resend;            // a hole, sent again at once
+    bool fast_done;         // sent again for a hole since the last timeout
+    bool unsent;            // didn't fit the TX staging buffer, sent after the next TX done
+    uint8_t frame[ARQ_FRAME_MAX];
+};
+
+struct arq_rx_slot {
+    bool valid;
+    uint16_t len;
+    uint8_t data[CONFIG_APP_ARQ_MAX_PAYLOAD];
+};
+
+struct arq_port {
+    struct app_uart *uart;
+    app_arq_rx_cb_t cb;
+    struct k_spinlock lock;
+    struct k_mutex tx_mutex;    // one transmission at a time, a slot isn't reused meanwhile
+
+    /* TX, the slot of seq is tx[seq % ARQ_WINDOW] */
+    struct k_sem space;         // free slots
+    uint8_t tx_base;            // oldest frame not acknowledged
+    uint8_t tx_next;            // seq of the next new frame
+    uint32_t rto_ms;
+    struct arq_tx_slot tx[ARQ_WINDOW];
+    struct k_work_delayable rto_work;
+    bool tx_blocked;            // a frame waits for the TX done callback
+    bool ack_blocked;           // so does the ACK
+
+    /* RX, only the RX context writes the slots */
+    uint8_t rx_next;            // next seq to deliver
+    uint32_t ack_owed;          // frames received since the peer got rx_next
+    struct arq_rx_slot rx[ARQ_WINDOW];
+    struct k_work_delayable ack_work;
+
+    struct app_arq_stats stats;
+};
+
+static struct arq_port ports[APP_UART_NUM];
+
+static struct arq_port *arq_port_of(struct app_uart *uart)
+{
+    return &ports[app_uart_index(uart)];
+}
+
+static inline uint8_t arq_in_flight(const struct arq_port *ap)
+{
+    return (uint8_t)(ap->tx_next - ap->tx_base);
+}
+
+/* With tx_mutex held. The header is complete, the CRC goes after it.
+ * Never waits for the line: true if the staging buffer had no room, the
+ * caller leaves the frame to the TX done callback then. A frame that
+ * failed otherwise is sent again by the timer.
+ */
+static bool arq_xmit(struct arq_port *ap, uint8_t *frame, size_t len)
+{
+    int err;
+
+    sys_put_le16(app_crc16_ccitt(ARQ_CRC_SEED, frame, len - ARQ_CRC_LEN),
+                 &frame[len - ARQ_CRC_LEN]);
+
+    err = app_framer_send(ap->uart, frame, len);
+    if (err == -ENOMEM || err == -EBUSY) {
+        return true;
+    }
+    if (err) {
+        LOG_WRN("%s: failed to send a frame: %d", app_uart_name(ap->uart), err);
+    }
+    return false;
+}
+
+/* Must be called with the lock held: the frame carries the cumulative ACK */
+static void arq_ack_fill_locked(struct arq_port *ap, uint8_t *frame)
+{
+    frame[3] = ap->rx_next;
+    ap->ack_owed = 0;
+}
+
+static void arq_rto_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct arq_port *ap = CONTAINER_OF(dwork, struct arq_port, rto_work);
+    uint32_t wait = UINT32_MAX;
+    bool timed_out = false;
+
+    k_mutex_lock(&ap->tx_mutex, K_FOREVER);
+
+    // one frame per pass, the ACKs move tx_base meanwhile
+    while (true) {
+        struct arq_tx_slot *slot = NULL;
+
+        K_SPINLOCK(&ap->lock) {
+            uint32_t now = k_uptime_get_32();
+
+            wait = UINT32_MAX;
+            for (uint8_t seq = ap->tx_base; seq != ap->tx_next; seq++) {
+                struct arq_tx_slot *s = &ap->tx[seq % ARQ_WINDOW];
+                uint32_t age = now - s->sent_ms;
+
+                if (s->acked) {
+                    continue;
+                }
+                if (s->unsent) {
+                    s->unsent = false;
+                    slot = s;
+                    break;
+                }
+                if (s->resend) {
+                    s->resend = false;
+                    s->fast_done = true;
+                    ap->stats.fast_retransmits++;
+                    slot = s;
+                    break;
+                }
+                if (age >= ap->rto_ms) {
+                    s->fast_done = false;
+                    ap->stats.retransmits++;
+                    timed_out = true;
+                    slot = s;
+                    break;
+                }
+                wait = MIN(wait, ap->rto_ms - age);
+            }
+
+            if (slot != NULL) {
+                slot->sent_ms = now;
+                arq_ack_fill_locked(ap, slot->frame);
+            }
+        }
+
+        if (slot == NULL) {
+            break;
+        }
+        if (arq_xmit(ap, slot->frame, slot->len)) {
+            // the rest after the next TX done, the timer if it came already:
+            // arq_tx_done() reschedules after this, or saw no frame waiting
+            K_SPINLOCK(&ap->lock) {
+                slot->unsent = true;
+                ap->tx_blocked = true;
+                k_work_reschedule(&ap->rto_work, K_MSEC(ap->rto_ms));
+            }
+            wait = UINT32_MAX;
+            break;
+        }
+    }
+
+    if (timed_out) {
+        K_SPINLOCK(&ap->lock) {
+            ap->rto_ms = MIN(ap->rto_ms * 2, ARQ_RTO_MAX_MS);
+        }
+    }
+
+    k_mutex_unlock(&ap->tx_mutex);
+
+    if (wait != UINT32_MAX) {
+        k_work_reschedule(&ap->rto_work, K_MSEC(wait));
+    }
+}
+
+static void arq_ack_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct arq_port *ap = CONTAINER_OF(dwork, struct arq_port, ack_work);
+    uint8_t frame[ARQ_ACK_LEN] = { APP_ARQ_TAG, ARQ_ACK };
+
+    k_mutex_lock(&ap->tx_mutex, K_FOREVER);
+
+    K_SPINLOCK(&ap->lock) {
+        uint32_t sack = 0;
+
+        for (size_t i = 0; i + 1 < ARQ_WINDOW; i++) {
+            if (ap->rx[(uint8_t)(ap->rx_next + 1 + i) % ARQ_WINDOW].valid) {
+                sack |= BIT(i);
+            }
+        }
+        sys_put_le32(sack, &frame[ARQ_HDR_LEN]);
+        arq_ack_fill_locked(ap, frame);
+        ap->stats.acks_sent++;
+    }
+
+    if (arq_xmit(ap, frame, sizeof(frame))) {
+        // the next data frame carries the cumulative ACK meanwhile
+        K_SPINLOCK(&ap->lock) {
+            ap->ack_blocked = true;
+        }
+    }
+    k_mutex_unlock(&ap->tx_mutex);
+}
+
+/* from the UART ISR: room in the staging buffer for what didn't fit */
+static void arq_tx_done(struct app_uart *uart)
+{
+    struct arq_port *ap = arq_port_of(uart);
+    bool frames = false, ack = false;
+
+    K_SPINLOCK(&ap->lock) {
+        frames = ap->tx_blocked;
+        ack = ap->ack_blocked;
+        ap->tx_blocked = false;
+        ap->ack_blocked = false;
+    }
+
+    if (ack) {
+        k_work_reschedule(&ap->ack_work, K_NO_WAIT);
+    }
+    if (frames) {
+        k_work_reschedule(&ap->rto_work, K_NO_WAIT);
+    }
+}
+
+int app_arq_open(struct app_uart *uart, app_arq_rx_cb_t cb)
+{
+    struct arq_port *ap = arq_port_of(uart);
+
+    if (ap->cb != NULL) {
+        return -EALREADY;
+    }
+
+    if (APP_FRAMER_MAX_ENCODED_LEN(ARQ_FRAME_MAX) > app_uart_tx_buf_size(uart)) {
+        LOG_ERR("Frames of %u bytes exceed the TX buffer of %s", ARQ_FRAME_MAX,
+                app_uart_name(uart));
+        return -EMSGSIZE;
+    }
+
+    (void)app_uart_tx_done_cb_register(uart, arq_tx_done);
+    ap->cb = cb;
+    return 0;
+}
+
+int app_arq_send(struct app_uart *uart, const uint8_t *data, size_t len, k_timeout_t timeout)
+{
+    struct arq_port *ap = arq_port_of(uart);
+    struct arq_tx_slot *slot;
+    uint32_t rto_ms = 0;
+
+    if (ap->cb == NULL) {
+        return -ENOTCONN;
+    }
+    if (data == NULL || len == 0) {
+        return -EINVAL;
+    }
+    if (len > CONFIG_APP_ARQ_MAX_PAYLOAD) {
+        return -EMSGSIZE;
+    }
+
+    if (k_sem_take(&ap->space, timeout)) {
+        return -EAGAIN;
+    }
+
+    k_mutex_lock(&ap->tx_mutex, K_FOREVER);
+
+    // the slot of tx_next is free since a space was taken, nobody else writes it
+    slot = &ap->tx[ap->tx_next % ARQ_WINDOW];
+    slot->frame[0] = APP_ARQ_TAG;
+    slot->frame[1] = ARQ_DATA;
+    slot->frame[2] = ap->tx_next;
+    memcpy(&slot->frame[ARQ_HDR_LEN], data, len);
+    slot->len = ARQ_HDR_LEN + len + ARQ_CRC_LEN;
+    slot->acked = false;
+    slot->resend = false;
+    slot->fast_done = false;
+    slot->unsent = false;
+
+    K_SPINLOCK(&ap->lock) {
+        slot->sent_ms = k_uptime_get_32();
+        arq_ack_fill_locked(ap, slot->frame);
+        ap->tx_next++;
+        ap->stats.tx_frames++;
+        ap->stats.tx_bytes += len;
+        rto_ms = ap->rto_ms;
+    }
+
+    if (arq_xmit(ap, slot->frame, slot->len)) {
+        // the slot keeps the frame, no sender waits for the line
+        K_SPINLOCK(&ap->lock) {
+            slot->unsent = true;
+            ap->tx_blocked = true;
+        }
+    }
+    k_mutex_unlock(&ap->tx_mutex);
+
+    // a pending timer stays, it runs for an older frame
+    k_work_schedule(&ap->rto_work, K_MSEC(rto_ms));
+    return 0;
+}
+
+int app_arq_flush(struct app_uart *uart, k_timeout_t timeout)
+{
+    struct arq_port *ap = arq_port_of(uart);
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    uint8_t in_flight = 0;
+
+    while (true) {
+        K_SPINLOCK(&ap->lock) {
+            in_flight = arq_in_flight(ap);
+        }
+        if (in_flight == 0) {
+            return 0;
+        }
+        if (sys_timepoint_expired(end)) {
+            return -EAGAIN;
+        }
+        k_sleep(K_MSEC(1));
+    }
+}
+
+static void arq_on_ack(struct arq_port *ap, uint8_t cum, uint32_t sack, bool ack_frame)
+{
+    uint32_t freed = 0;
+    bool resend = false;
+
+    K_SPINLOCK(&ap->lock) {
+        if (ack_frame) {
+            ap->stats.acks_received++;
+        }
+
+        // an ACK older than tx_base came late
+        if ((uint8_t)(cum - ap->tx_base) > arq_in_flight(ap)) {
+            K_SPINLOCK_BREAK;
+        }
+        for (; ap->tx_base != cum; ap->tx_base++) {
+            freed++;
+        }
+        if (freed > 0) {
+            // the peer answers again
+            ap->rto_ms = CONFIG_APP_ARQ_RTO_MS;
+        }
+
+        if (sack == 0) {
+            K_SPINLOCK_BREAK;
+        }
+
+        // cum is missing, and every frame not marked before the last marked one
+        int last = 31 - __builtin_clz(sack);
+
+        for (int i = -1; i <= last; i++) {
+            uint8_t seq = cum + 1 + i;
+            struct arq_tx_slot *s = &ap->tx[seq % ARQ_WINDOW];
+
+            if ((uint8_t)(seq - ap->tx_base) >= arq_in_flight(ap)) {
+                break;
+            }
+            if (i >= 0 && (sack & BIT(i))) {
+                s->acked = true;
+            } else if (!s->acked && !s->fast_done) {
+                s->resend = true;
+                resend = true;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < freed; i++) {
+        k_sem_give(&ap->space);
+    }
+    if (resend) {
+        k_work_reschedule(&ap->rto_work, K_NO_WAIT);
+    }
+}
+
+static void arq_deliver(struct arq_port *ap, const uint8_t *data, size_t len)
+{
+    ap->cb(ap->uart, data, len);
+
+    K_SPINLOCK(&ap->lock) {
+        ap->rx_next++;
+        ap->stats.rx_frames++;
+        ap->stats.rx_bytes += len;
+    }
+}
+
+static void arq_on_data(struct arq_port *ap, uint8_t seq, const uint8_t *data, size_t len)
+{
+    struct arq_rx_slot *slot = &ap->rx[seq % ARQ_WINDOW];
+    uint8_t ahead = (uint8_t)(seq - ap->rx_next);
+    bool ack_now = true;
+    uint32_t owed = 0;
+
+    if (ahead >= 128) {
+        // delivered already, the peer missed the ACK
+        K_SPINLOCK(&ap->lock) {
+            ap->stats.rx_duplicates++;
+        }
+    } else if (ahead >= ARQ_WINDOW) {
+        K_SPINLOCK(&ap->lock) {
+            ap->stats.rx_out_of_window++;
+        }
+    } else if (ahead > 0) {
+        // kept until the frames before it arrive, the ACK reports the hole
+        if (slot->valid) {
+            K_SPINLOCK(&ap->lock) {
+                ap->stats.rx_duplicates++;
+            }
+        } else {
+            memcpy(slot->data, data, len);
+            slot->len = len;
+            K_SPINLOCK(&ap->lock) {
+                slot->valid = true;
+                ap->stats.rx_out_of_order++;
+            }
+        }
+    } else {
+        // in order, straight from the frame, then what was kept behind it
+        arq_deliver(ap, data, len);
+
+        while ((slot = &ap->rx[ap->rx_next % ARQ_WINDOW])->valid) {
+            arq_deliver(ap, slot->data, slot->len);
+            K_SPINLOCK(&ap->lock) {
+                slot->valid = false;
+            }
+        }
+        ack_now = false;
+    }
+
+    K_SPINLOCK(&ap->lock) {
+        owed = ++ap->ack_owed;
+    }
+
+    if (ack_now || owed >= ARQ_ACK_EVERY) {
+        k_work_reschedule(&ap->ack_work, K_NO_WAIT);
+    } else {
+        k_work_schedule(&ap->ack_work, K_MSEC(CONFIG_APP_ARQ_ACK_DELAY_MS));
+    }
+}
+
+bool app_arq_frame(struct app_uart *uart, const uint8_t *frame, size_t len)
+{
+    struct arq_port *ap = arq_port_of(uart);
+
+    if (ap->cb == NULL || len < ARQ_HDR_LEN + ARQ_CRC_LEN || frame[0] != APP_ARQ_TAG) {
+        return false;
+    }
+
+    if (app_crc16_ccitt(ARQ_CRC_SEED, frame, len - ARQ_CRC_LEN) !=
+        sys_get_le16(&frame[len - ARQ_CRC_LEN])) {
+        // damaged on the wire, the sender times out or learns it from the next ACK
+        K_SPINLOCK(&ap->lock) {
+            ap->stats.rx_bad_crc++;
+        }
+        return true;
+    }
+
+    switch (frame[1]) {
+    case ARQ_DATA:
+        if (len == ARQ_HDR_LEN + ARQ_CRC_LEN) {
+            break;
+        }
+        arq_on_ack(ap, frame[3], 0, false);
+        arq_on_data(ap, frame[2], &frame[ARQ_HDR_LEN], len - ARQ_HDR_LEN - ARQ_CRC_LEN);
+        break;
+
+    case ARQ_ACK:
+        if (len == ARQ_ACK_LEN) {
+            arq_on_ack(ap, frame[3], sys_get_le32(&frame[ARQ_HDR_LEN]), true);
+        }
+        break;
+
+    default:
+        LOG_WRN("%s: unknown frame type %u", app_uart_name(uart), frame[1]);
+        break;
+    }
+    return true;
+}
+
+void app_arq_stats_get(struct app_uart *uart, struct app_arq_stats *stats)
+{
+    struct arq_port *ap = arq_port_of(uart);
+
+    K_SPINLOCK(&ap->lock) {
+        *stats = ap->stats;
+        stats->rto_ms = ap->rto_ms;
+        stats->in_flight = arq_in_flight(ap);
+    }
+}
+
+void app_arq_stats_reset(struct app_uart *uart)
+{
+    struct arq_port *ap = arq_port_of(uart);
+
+    K_SPINLOCK(&ap->lock) {
+        memset(&ap->stats, 0, sizeof(ap->stats));
+    }
+}
+
+static int app_arq_init(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(ports); i++) {
+        struct arq_port *ap = &ports[i];
+
+        ap->uart = app_uart_at(i);
+        ap->rto_ms = CONFIG_APP_ARQ_RTO_MS;
+        k_mutex_init(&ap->tx_mutex);
+        k_sem_init(&ap->space, ARQ_WINDOW, ARQ_WINDOW);
+        k_work_init_delayable(&ap->rto_work, arq_rto_handler);
+        k_work_init_delayable(&ap->ack_work, arq_ack_handler);
+    }
+    return 0;
+}
+
+SYS_INIT(app_arq_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,112 @@
+#ifndef __APP_ARQ_H
+#define __APP_ARQ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys_clock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct app_uart;
+
+/* First byte of every transport frame, tells them from the other frames of the port */
+#define APP_ARQ_TAG 0xA7
+
+/* Header and CRC16 around the payload of a data frame */
+#define APP_ARQ_OVERHEAD 6
+
+/**
+ * @brief Payload delivered in order, called from the RX context
+ *
+ * Every payload is delivered once, in the order it was sent. The data is
+ * only valid until the callback returns.
+ */
+typedef void (*app_arq_rx_cb_t)(struct app_uart *uart, const uint8_t *data, size_t len);
+
+struct app_arq_stats {
+    uint32_t tx_frames;         // first transmissions
+    uint32_t tx_bytes;          // payload
+    uint32_t retransmits;       // after the retransmit timeout
+    uint32_t fast_retransmits;  // holes reported by a selective ACK
+    uint32_t acks_sent;
+    uint32_t acks_received;
+    uint32_t rx_frames;         // delivered
+    uint32_t rx_bytes;          // payload delivered
+    uint32_t rx_out_of_order;   // kept until the frames before them arrive
+    uint32_t rx_duplicates;
+    uint32_t rx_bad_crc;
+    uint32_t rx_out_of_window;
+    uint32_t rto_ms;            // retransmit timeout now
+    uint32_t in_flight;         // frames sent and not acknowledged now
+};
+
+/**
+ * @brief Run the reliable transport on a port
+ *
+ * Both sides open the port before the first frame, the sequence numbers
+ * start at 0 on both. Hand every received frame to app_arq_frame().
+ * The transport takes the TX done callback of the port, see
+ * app_uart_tx_done_cb_register().
+ * @param uart Port
+ * @param cb Callback for the received payloads
+ * @return 0 on success, -EALREADY if the transport runs on the port,
+ *         -EMSGSIZE if a frame doesn't fit the TX buffer of the port
+ */
+int app_arq_open(struct app_uart *uart, app_arq_rx_cb_t cb);
+
+/**
+ * @brief Send a payload reliably, from thread context
+ *
+ * The payload is copied into a slot of the send window and sent. It is
+ * sent again until the peer acknowledges it: after the retransmit timeout,
+ * or as soon as a selective ACK shows that later frames came through.
+ * It doesn't wait for the line: a frame that doesn't fit the TX staging
+ * buffer is sent from the TX done callback, so the RX context may send.
+ * @param uart Port
+ * @param data Payload
+ * @param len Payload length, 1 .. CONFIG_APP_ARQ_MAX_PAYLOAD
+ * @param timeout How long to wait while CONFIG_APP_ARQ_WINDOW frames are
+ *        not acknowledged
+ * @return 0 once the payload is in the window, -EAGAIN on timeout,
+ *         -EMSGSIZE or -EINVAL if @p len is out of range, -ENOTCONN if the
+ *         transport doesn't run on the port
+ */
+int app_arq_send(struct app_uart *uart, const uint8_t *data, size_t len, k_timeout_t timeout);
+
+/**
+ * @brief Wait until the peer acknowledged every payload sent
+ * @param uart Port
+ * @param timeout How long to wait
+ * @return 0 once nothing is in flight, -EAGAIN on timeout
+ */
+int app_arq_flush(struct app_uart *uart, k_timeout_t timeout);
+
+/**
+ * @brief Hand a received frame to the transport, from the frame callback
+ * @param uart Port the frame was received on
+ * @param frame Decoded payload of the app_framer
+ * @param len Length
+ * @return true if the frame was a transport frame and is consumed
+ */
+bool app_arq_frame(struct app_uart *uart, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Read the counters of a port
+ * @param uart Port
+ * @param stats Set to the counters
+ */
+void app_arq_stats_get(struct app_uart *uart, struct app_arq_stats *stats);
+
+/**
+ * @brief Reset the counters of a port
+ */
+void app_arq_stats_reset(struct app_uart *uart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_ARQ_H
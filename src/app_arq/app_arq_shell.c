@@ -0,0 +1,39 @@
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "app_arq.h"
+#include "app_uart.h"
+
+static int cmd_arq(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_arq_stats st;
+
+    shell_print(sh, "%-16s %8s %8s %8s %8s %8s %8s %8s %8s %6s %6s", "port", "tx", "retx",
+                "fast", "rx", "ooo", "dup", "bad_crc", "acks", "rto", "flight");
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        struct app_uart *uart = app_uart_at(i);
+
+        app_arq_stats_get(uart, &st);
+        shell_print(sh, "%-16s %8u %8u %8u %8u %8u %8u %8u %8u %6u %6u", app_uart_name(uart),
+                    st.tx_frames, st.retransmits, st.fast_retransmits, st.rx_frames,
+                    st.rx_out_of_order, st.rx_duplicates, st.rx_bad_crc, st.acks_sent,
+                    st.rto_ms, st.in_flight);
+    }
+    return 0;
+}
+
+static int cmd_arq_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        app_arq_stats_reset(app_uart_at(i));
+    }
+    shell_print(sh, "Statistics reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_arq,
+    SHELL_CMD(reset, NULL, "Reset the counters", cmd_arq_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(arq, &sub_arq, "Reliable transport counters per port", cmd_arq);
@@ -0,0 +1,444 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_baud.h"
+#include "app_framer.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_baud, CONFIG_APP_BAUD_LOG_LEVEL);
+
+#define BAUD_PREFIX "$BAUD "
+#define BAUD_MSG_MAX 64
+
+/* a rate mismatch garbles the alternating bits first, the rest covers every nibble */
+#define BAUD_PROBE_PATTERN "UUUU0123456789ABCDEFuuuu"
+
+#define AUTO_SYNC_BYTE 0x55
+
+/* ascending, app_baud_auto() walks it backwards */
+static const uint32_t rates[] = {
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 1000000,
+};
+
+enum baud_state {
+    BAUD_IDLE,
+    /* initiator */
+    BAUD_PROPOSED,      // waiting for ACCEPT
+    BAUD_SWITCHING,     // ACCEPT received, switch_work or probe_work pending
+    BAUD_PROBING,       // switched, waiting for PROBE_ACK
+    /* responder */
+    BAUD_WAIT_PROBE,    // ACCEPT sent, switching and waiting for PROBE
+};
+
+struct baud_port {
+    struct app_uart *uart;
+    struct k_spinlock lock;
+    enum baud_state state;
+    uint32_t rate;          // rate being negotiated
+    uint32_t fallback;      // rate before the negotiation
+    struct k_work switch_work;
+    struct k_work_delayable probe_work;
+    struct k_work_delayable timeout_work;
+};
+
+static struct baud_port ports[APP_UART_NUM];
+
+/* A switch drains TX and waits for RX to stop, for up to a second, which
+ * neither the system workqueue nor the RX context may spend.
+ */
+static struct k_work_q baud_work_q;
+static K_THREAD_STACK_DEFINE(baud_work_q_stack, CONFIG_APP_BAUD_WORKQ_STACK_SIZE);
+static app_baud_cb_t result_cb;
+
+static struct {
+    atomic_t busy;
+    atomic_t run;           // consecutive sync bytes
+    struct k_sem locked;
+} autob;
+
+static struct baud_port *baud_port_of(struct app_uart *uart)
+{
+    return &ports[app_uart_index(uart)];
+}
+
+static void baud_report(struct baud_port *bp, uint32_t baudrate, int result)
+{
+    if (result) {
+        LOG_WRN("%s: %u baud not negotiated: %d, running at %u", app_uart_name(bp->uart),
+                bp->rate, result, baudrate);
+    } else {
+        LOG_INF("%s: switched to %u baud", app_uart_name(bp->uart), baudrate);
+    }
+
+    if (result_cb != NULL) {
+        result_cb(bp->uart, baudrate, result);
+    }
+}
+
+static int baud_send(struct baud_port *bp, const char *cmd, uint32_t rate, bool pattern)
+{
+    char msg[BAUD_MSG_MAX];
+    int len = snprintk(msg, sizeof(msg), BAUD_PREFIX "%s %u%s", cmd, rate,
+                       pattern ? " " BAUD_PROBE_PATTERN : "");
+
+    return app_framer_send(bp->uart, (const uint8_t *)msg, len);
+}
+
+/* Move from one state to another, false if the port is not in the expected
+ * state any more: the RX context and the timeout race for the same transitions.
+ */
+static bool baud_transition(struct baud_port *bp, enum baud_state from, uint32_t rate,
+                            enum baud_state to)
+{
+    bool ok = false;
+
+    K_SPINLOCK(&bp->lock) {
+        if (bp->state == from && bp->rate == rate) {
+            bp->state = to;
+            ok = true;
+        }
+    }
+    return ok;
+}
+
+static void baud_timeout_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct baud_port *bp = CONTAINER_OF(dwork, struct baud_port, timeout_work);
+    enum baud_state state = BAUD_IDLE;
+
+    K_SPINLOCK(&bp->lock) {
+        state = bp->state;
+        bp->state = BAUD_IDLE;
+    }
+
+    switch (state) {
+    case BAUD_PROPOSED:
+        baud_report(bp, bp->fallback, -ETIMEDOUT);
+        break;
+
+    case BAUD_PROBING:
+    case BAUD_WAIT_PROBE:
+        // the peer does the same on its side
+        (void)app_uart_set_baudrate(bp->uart, bp->fallback);
+        baud_report(bp, app_uart_baudrate(bp->uart), -ETIMEDOUT);
+        break;
+
+    default:
+        // completed meanwhile
+        break;
+    }
+}
+
+/* On baud_work_q: the switch drains TX and waits for RX to stop */
+static void baud_switch_handler(struct k_work *work)
+{
+    struct baud_port *bp = CONTAINER_OF(work, struct baud_port, switch_work);
+    bool initiator = false;
+    int err;
+
+    K_SPINLOCK(&bp->lock) {
+        initiator = (bp->state == BAUD_SWITCHING);
+    }
+
+    // the responder's ACCEPT goes out at the old rate, app_uart drains it first
+    err = app_uart_set_baudrate(bp->uart, bp->rate);
+    if (err) {
+        K_SPINLOCK(&bp->lock) {
+            bp->state = BAUD_IDLE;
+        }
+        k_work_cancel_delayable(&bp->timeout_work);
+        baud_report(bp, app_uart_baudrate(bp->uart), err);
+        return;
+    }
+
+    if (!initiator) {
+        // the timeout is running since the ACCEPT
+        return;
+    }
+
+    // the responder switches once its ACCEPT is out, give it the time
+    k_work_reschedule_for_queue(&baud_work_q, &bp->probe_work,
+                                K_MSEC(CONFIG_APP_BAUD_SETTLE_MS));
+}
+
+static void baud_probe_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct baud_port *bp = CONTAINER_OF(dwork, struct baud_port, probe_work);
+    int err;
+
+    if (!baud_transition(bp, BAUD_SWITCHING, bp->rate, BAUD_PROBING)) {
+        return;
+    }
+    k_work_reschedule_for_queue(&baud_work_q, &bp->timeout_work,
+                                K_MSEC(CONFIG_APP_BAUD_TIMEOUT_MS));
+
+    err = baud_send(bp, "PROBE", bp->rate, true);
+    if (err) {
+        LOG_WRN("%s: failed to send the probe: %d", app_uart_name(bp->uart), err);
+    }
+}
+
+bool app_baud_supported(uint32_t baudrate)
+{
+    if (baudrate > CONFIG_APP_BAUD_MAX) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(rates); i++) {
+        if (rates[i] == baudrate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void app_baud_cb_register(app_baud_cb_t cb)
+{
+    result_cb = cb;
+}
+
+int app_baud_propose(struct app_uart *uart, uint32_t baudrate)
+{
+    struct baud_port *bp = baud_port_of(uart);
+    uint32_t current = app_uart_baudrate(uart);
+    int err = 0;
+
+    if (!app_baud_supported(baudrate)) {
+        return -EINVAL;
+    }
+
+    K_SPINLOCK(&bp->lock) {
+        if (bp->state != BAUD_IDLE) {
+            err = -EBUSY;
+            K_SPINLOCK_BREAK;
+        }
+        bp->state = BAUD_PROPOSED;
+        bp->rate = baudrate;
+        bp->fallback = current;
+    }
+    if (err) {
+        return err;
+    }
+
+    k_work_reschedule_for_queue(&baud_work_q, &bp->timeout_work,
+                                K_MSEC(CONFIG_APP_BAUD_TIMEOUT_MS));
+
+    err = baud_send(bp, "PROPOSE", baudrate, false);
+    if (err) {
+        k_work_cancel_delayable(&bp->timeout_work);
+        K_SPINLOCK(&bp->lock) {
+            bp->state = BAUD_IDLE;
+        }
+    }
+    return err;
+}
+
+static void baud_on_propose(struct baud_port *bp, uint32_t rate)
+{
+    uint32_t current = app_uart_baudrate(bp->uart);
+    bool accept = app_baud_supported(rate) && current != 0;
+
+    if (accept) {
+        K_SPINLOCK(&bp->lock) {
+            // a proposal of our own crossed this one, both are rejected
+            if (bp->state != BAUD_IDLE) {
+                accept = false;
+                K_SPINLOCK_BREAK;
+            }
+            bp->state = BAUD_WAIT_PROBE;
+            bp->rate = rate;
+            bp->fallback = current;
+        }
+    }
+
+    if (!accept) {
+        LOG_INF("%s: rejecting %u baud", app_uart_name(bp->uart), rate);
+        (void)baud_send(bp, "REJECT", rate, false);
+        return;
+    }
+
+    if (baud_send(bp, "ACCEPT", rate, false)) {
+        // the initiator times out on its side
+        K_SPINLOCK(&bp->lock) {
+            bp->state = BAUD_IDLE;
+        }
+        return;
+    }
+
+    k_work_reschedule_for_queue(&baud_work_q, &bp->timeout_work,
+                                K_MSEC(CONFIG_APP_BAUD_TIMEOUT_MS + CONFIG_APP_BAUD_SETTLE_MS));
+    k_work_submit_to_queue(&baud_work_q, &bp->switch_work);
+}
+
+static void baud_on_accept(struct baud_port *bp, uint32_t rate)
+{
+    if (baud_transition(bp, BAUD_PROPOSED, rate, BAUD_SWITCHING)) {
+        k_work_cancel_delayable(&bp->timeout_work);
+        k_work_submit_to_queue(&baud_work_q, &bp->switch_work);
+    }
+}
+
+static void baud_on_reject(struct baud_port *bp, uint32_t rate)
+{
+    if (baud_transition(bp, BAUD_PROPOSED, rate, BAUD_IDLE)) {
+        k_work_cancel_delayable(&bp->timeout_work);
+        baud_report(bp, bp->fallback, -ECONNREFUSED);
+    }
+}
+
+static void baud_on_probe(struct baud_port *bp, uint32_t rate, const char *pattern)
+{
+    // a damaged probe is ignored, the timeout falls back
+    if (strcmp(pattern, BAUD_PROBE_PATTERN) != 0) {
+        LOG_WRN("%s: damaged probe", app_uart_name(bp->uart));
+        return;
+    }
+
+    if (baud_transition(bp, BAUD_WAIT_PROBE, rate, BAUD_IDLE)) {
+        k_work_cancel_delayable(&bp->timeout_work);
+        (void)baud_send(bp, "PROBE_ACK", rate, false);
+        baud_report(bp, rate, 0);
+    }
+}
+
+static void baud_on_probe_ack(struct baud_port *bp, uint32_t rate)
+{
+    if (baud_transition(bp, BAUD_PROBING, rate, BAUD_IDLE)) {
+        k_work_cancel_delayable(&bp->timeout_work);
+        baud_report(bp, rate, 0);
+    }
+}
+
+bool app_baud_frame(struct app_uart *uart, const uint8_t *frame, size_t len)
+{
+    struct baud_port *bp = baud_port_of(uart);
+    char msg[BAUD_MSG_MAX];
+    char *cmd, *arg, *end;
+    uint32_t rate;
+
+    if (len < sizeof(BAUD_PREFIX) - 1 || memcmp(frame, BAUD_PREFIX, sizeof(BAUD_PREFIX) - 1)) {
+        return false;
+    }
+    if (len >= sizeof(msg)) {
+        LOG_WRN("%s: oversized baud message", app_uart_name(uart));
+        return true;
+    }
+
+    memcpy(msg, frame, len);
+    msg[len] = '\0';
+
+    cmd = msg + sizeof(BAUD_PREFIX) - 1;
+    arg = strchr(cmd, ' ');
+    if (arg == NULL) {
+        return true;
+    }
+    *arg++ = '\0';
+    rate = strtoul(arg, &end, 10);
+
+    if (strcmp(cmd, "PROPOSE") == 0) {
+        baud_on_propose(bp, rate);
+    } else if (strcmp(cmd, "ACCEPT") == 0) {
+        baud_on_accept(bp, rate);
+    } else if (strcmp(cmd, "REJECT") == 0) {
+        baud_on_reject(bp, rate);
+    } else if (strcmp(cmd, "PROBE") == 0) {
+        baud_on_probe(bp, rate, (*end == ' ') ? end + 1 : end);
+    } else if (strcmp(cmd, "PROBE_ACK") == 0) {
+        baud_on_probe_ack(bp, rate);
+    } else {
+        LOG_WRN("%s: unknown baud message %s", app_uart_name(uart), cmd);
+    }
+    return true;
+}
+
+static void auto_rx_callback(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (byte[i] != AUTO_SYNC_BYTE) {
+            atomic_clear(&autob.run);
+        } else if (atomic_inc(&autob.run) + 1 == CONFIG_APP_BAUD_AUTO_SYNC) {
+            k_sem_give(&autob.locked);
+        }
+    }
+}
+
+int app_baud_auto(struct app_uart *uart, k_timeout_t timeout, uint32_t *baudrate)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    uint32_t initial = app_uart_baudrate(uart);
+    int err;
+
+    if (!atomic_cas(&autob.busy, 0, 1)) {
+        return -EBUSY;
+    }
+
+    err = app_uart_rx_cb_register(uart, auto_rx_callback);
+    if (err) {
+        goto out;
+    }
+
+    err = -ETIMEDOUT;
+    while (err == -ETIMEDOUT && !sys_timepoint_expired(end)) {
+        // the fastest rates first, a slow dwell there costs the least
+        for (size_t i = ARRAY_SIZE(rates); i-- > 0;) {
+            if (!app_baud_supported(rates[i])) {
+                continue;
+            }
+
+            int set_err = app_uart_set_baudrate(uart, rates[i]);
+
+            if (set_err) {
+                err = set_err;
+                break;
+            }
+
+            // whatever came in at the previous rate doesn't count
+            atomic_clear(&autob.run);
+            k_sem_reset(&autob.locked);
+
+            if (k_sem_take(&autob.locked, K_MSEC(CONFIG_APP_BAUD_AUTO_DWELL_MS)) == 0) {
+                LOG_INF("%s: detected %u baud", app_uart_name(uart), rates[i]);
+                *baudrate = rates[i];
+                err = 0;
+                break;
+            }
+            if (sys_timepoint_expired(end)) {
+                break;
+            }
+        }
+    }
+
+    if (err == -ETIMEDOUT && initial != 0) {
+        (void)app_uart_set_baudrate(uart, initial);
+    }
+
+out:
+    atomic_clear(&autob.busy);
+    return err;
+}
+
+static int app_baud_init(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(ports); i++) {
+        ports[i].uart = app_uart_at(i);
+        k_work_init(&ports[i].switch_work, baud_switch_handler);
+        k_work_init_delayable(&ports[i].probe_work, baud_probe_handler);
+        k_work_init_delayable(&ports[i].timeout_work, baud_timeout_handler);
+    }
+    k_sem_init(&autob.locked, 0, 1);
+
+    k_work_queue_start(&baud_work_q, baud_work_q_stack,
+                       K_THREAD_STACK_SIZEOF(baud_work_q_stack), CONFIG_APP_BAUD_WORKQ_PRIORITY,
+                       &(struct k_work_queue_config){ .name = "app_baud" });
+    return 0;
+}
+
+SYS_INIT(app_baud_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
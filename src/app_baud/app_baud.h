@@ -0,0 +1,89 @@
+#ifndef __APP_BAUD_H
+#define __APP_BAUD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys_clock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct app_uart;
+
+/**
+ * @brief Result of a baud rate negotiation, on both sides
+ *
+ * Called from the baud work queue (CONFIG_APP_BAUD_WORKQ_*) or the RX context.
+ * @param uart Port
+ * @param baudrate Rate the port runs at now
+ * @param result 0 if the proposed rate is in use, -ECONNREFUSED if the peer
+ *        rejected it, -ETIMEDOUT if the peer didn't answer or the probe
+ *        didn't come through, the port is back at the previous rate then,
+ *        other negative error code if the port couldn't be switched
+ */
+typedef void (*app_baud_cb_t)(struct app_uart *uart, uint32_t baudrate, int result);
+
+/**
+ * @brief Set the negotiation result callback, shared by every port
+ * @param cb Callback, NULL for none
+ */
+void app_baud_cb_register(app_baud_cb_t cb);
+
+/**
+ * @brief Check a rate against the supported ones
+ * @return true if the rate is one of the standard rates up to CONFIG_APP_BAUD_MAX
+ */
+bool app_baud_supported(uint32_t baudrate);
+
+/**
+ * @brief Propose a new baud rate to the peer
+ *
+ * The exchange, all messages are frames of the app_framer in use:
+ *   initiator                      responder
+ *   "$BAUD PROPOSE <rate>"  --->
+ *                           <---   "$BAUD ACCEPT <rate>"   (or REJECT)
+ *   both drain TX and switch to <rate>
+ *   "$BAUD PROBE <rate> <pattern>"  --->
+ *                           <---   "$BAUD PROBE_ACK <rate>"
+ * A side that doesn't get the next message within CONFIG_APP_BAUD_TIMEOUT_MS
+ * goes back to the previous rate. The result is reported on both sides
+ * through the app_baud_cb_register() callback.
+ * @param uart Port
+ * @param baudrate Proposed rate, see app_baud_supported()
+ * @return 0 if the proposal was sent, -EBUSY if a negotiation runs on the
+ *         port, -EINVAL if the rate is not supported, or an app_framer_send() error
+ */
+int app_baud_propose(struct app_uart *uart, uint32_t baudrate);
+
+/**
+ * @brief Hand a received frame to the negotiation, from the frame callback
+ * @param uart Port the frame was received on
+ * @param frame Decoded payload
+ * @param len Payload length
+ * @return true if the frame was a "$BAUD" message and is consumed
+ */
+bool app_baud_frame(struct app_uart *uart, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Detect the baud rate of the peer from a run of 'U' (0x55)
+ *
+ * Tries the supported rates from the highest down until
+ * CONFIG_APP_BAUD_AUTO_SYNC consecutive 'U' are received at one of them.
+ * The peer sends the 'U' run before its first frame, the alternating bits
+ * only decode as 0x55 at the right rate. Takes over the RX callback of the
+ * port: call it before app_uart_rx_cb_register(), from thread context.
+ * @param uart Port
+ * @param timeout How long to keep trying
+ * @param baudrate Set to the detected rate, the port runs at it
+ * @return 0 on success, -ETIMEDOUT if no rate matched in time, the port is
+ *         back at its initial rate then, other negative error code on failure
+ */
+int app_baud_auto(struct app_uart *uart, k_timeout_t timeout, uint32_t *baudrate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_BAUD_H
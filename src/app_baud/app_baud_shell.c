@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "app_baud.h"
+#include "app_uart.h"
+
+static struct app_uart *port_find(const struct shell *sh, const char *name)
+{
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        if (strcmp(name, app_uart_name(app_uart_at(i))) == 0) {
+            return app_uart_at(i);
+        }
+    }
+
+    shell_error(sh, "Unknown port %s", name);
+    return NULL;
+}
+
+static int cmd_baud(const struct shell *sh, size_t argc, char **argv)
+{
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        struct app_uart *uart = app_uart_at(i);
+
+        shell_print(sh, "%-16s %u", app_uart_name(uart), app_uart_baudrate(uart));
+    }
+    return 0;
+}
+
+static int cmd_baud_set(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_uart *uart = port_find(sh, argv[1]);
+    int err;
+
+    if (uart == NULL) {
+        return -EINVAL;
+    }
+
+    err = app_uart_set_baudrate(uart, strtoul(argv[2], NULL, 10));
+    if (err) {
+        shell_error(sh, "Failed to set the baud rate: %d", err);
+    }
+    return err;
+}
+
+static int cmd_baud_propose(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_uart *uart = port_find(sh, argv[1]);
+    int err;
+
+    if (uart == NULL) {
+        return -EINVAL;
+    }
+
+    err = app_baud_propose(uart, strtoul(argv[2], NULL, 10));
+    if (err) {
+        shell_error(sh, "Failed to propose the baud rate: %d", err);
+        return err;
+    }
+    shell_print(sh, "Proposed, the result is logged");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_baud,
+    SHELL_CMD_ARG(set, NULL, "Switch this side only <port> <rate>", cmd_baud_set, 3, 0),
+    SHELL_CMD_ARG(propose, NULL, "Negotiate with the peer <port> <rate>", cmd_baud_propose, 3, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(baud, &sub_baud, "Baud rate of every port", cmd_baud);
@@ -0,0 +1,617 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/byteorder.h>
+
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && (CONFIG_HEAP_MEM_POOL_SIZE > 0)
+#include <zephyr/sys/sys_heap.h>
+#endif
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#include <native_rtc.h>
+#endif
+
+#include "app_bench.h"
+#include "app_framer.h"
+#include "app_uart.h"
+#include "app_uart_stats.h"
+
+#if IS_ENABLED(CONFIG_APP_POOL)
+#include "app_pool.h"
+#endif
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+/* packet: | seq (32 bit) | send time in us (32 bit) | filler | */
+#define BENCH_HDR_LEN 8
+
+static const uint16_t packet_sizes[] = { 8, 32, 128, 240 };
+
+/* packets sent back to back, then a pause */
+struct burst_pattern {
+    const char *name;
+    uint16_t burst;
+    uint16_t gap_ms;
+};
+
+static const struct burst_pattern patterns[] = {
+    { "stream", 0, 0 },
+    { "burst16", 16, 1 },
+    { "single", 1, 1 },
+};
+
+/* every port runs the same case at the same time */
+struct bench_port {
+    struct app_uart *uart;
+    struct app_framer framer;
+    uint8_t frame_buf[CONFIG_APP_FRAMER_MAX_FRAME_LEN];
+    atomic_t rx_packets;
+    atomic_t rx_bytes;
+    atomic_t corrupt;
+
+    /* counters at the start of the case */
+    struct app_uart_rx_ring_stats ring;
+    struct app_framer_stats framer_stats;
+    uint32_t exhausted;
+    uint32_t rearms;
+    uint32_t chunks;
+};
+
+static struct bench_port ports[APP_UART_NUM];
+
+/* latency samples written by the RX callbacks, see bench_lat_close() */
+struct bench_lat {
+    atomic_t count;     // samples claimed
+    atomic_t done;      // samples written
+    uint32_t us[CONFIG_APP_BENCH_LATENCY_SAMPLES];
+};
+
+static struct {
+    struct bench_lat lat;   // send to frame callback, bench_now_us()
+    struct bench_lat isr;   // UART_RX_RDY to RX callback, k_cycle_get_32()
+    uint64_t last_rx_us;
+} bench;
+
+static uint8_t tx_packet[CONFIG_APP_FRAMER_MAX_FRAME_LEN];
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* simulated time doesn't advance while the CPU is busy, use the host clock */
+uint64_t bench_now_us(void)
+{
+    return native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+}
+#else
+uint64_t bench_now_us(void)
+{
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+#endif
+
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && (CONFIG_HEAP_MEM_POOL_SIZE > 0)
+extern struct k_heap _system_heap;
+#endif
+
+/* The high-water mark starts over at the allocated bytes, returns them */
+static size_t bench_heap_mark(void)
+{
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && (CONFIG_HEAP_MEM_POOL_SIZE > 0)
+    struct sys_memory_stats stats;
+
+    sys_heap_runtime_stats_get(&_system_heap.heap, &stats);
+    (void)sys_heap_runtime_stats_reset_max(&_system_heap.heap);
+    return stats.allocated_bytes;
+#else
+    return 0;
+#endif
+}
+
+static size_t bench_heap_max(void)
+{
+#if defined(CONFIG_SYS_HEAP_RUNTIME_STATS) && (CONFIG_HEAP_MEM_POOL_SIZE > 0)
+    struct sys_memory_stats stats;
+
+    sys_heap_runtime_stats_get(&_system_heap.heap, &stats);
+    return stats.max_allocated_bytes;
+#else
+    return 0;
+#endif
+}
+
+static void bench_lat_add(struct bench_lat *lat, uint32_t us)
+{
+    atomic_val_t idx = atomic_inc(&lat->count);
+
+    if (idx < ARRAY_SIZE(lat->us)) {
+        lat->us[idx] = us;
+        atomic_inc(&lat->done);
+    }
+}
+
+static void bench_lat_reset(struct bench_lat *lat)
+{
+    atomic_clear(&lat->count);
+    atomic_clear(&lat->done);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* A late RX callback may still add a sample: the count is closed first, so
+ * no slot is claimed any more, and the slots claimed before are waited for.
+ * Returns the number of samples, sorted.
+ */
+static size_t bench_lat_close(struct bench_lat *lat)
+{
+    size_t n = MIN((size_t)atomic_set(&lat->count, ARRAY_SIZE(lat->us)), ARRAY_SIZE(lat->us));
+
+    while ((size_t)atomic_get(&lat->done) < n) {
+        // the RX context may have a lower priority
+        k_sleep(K_TICKS(1));
+    }
+
+    qsort(lat->us, n, sizeof(lat->us[0]), cmp_u32);
+    return n;
+}
+
+static void bench_lat_percentiles(struct bench_lat *lat, uint32_t *p50, uint32_t *p99,
+                                  uint32_t *max)
+{
+    size_t n = bench_lat_close(lat);
+
+    *p50 = (n > 0) ? lat->us[n / 2] : 0;
+    *p99 = (n > 0) ? lat->us[(n * 99) / 100] : 0;
+    *max = (n > 0) ? lat->us[n - 1] : 0;
+}
+
+static void bench_frame_handler(struct app_framer *framer, uint8_t *frame, size_t len)
+{
+    struct bench_port *port = framer->user_data;
+    uint64_t now = bench_now_us();
+
+    if (len < BENCH_HDR_LEN) {
+        atomic_inc(&port->corrupt);
+        return;
+    }
+
+    uint32_t seq = sys_get_le32(&frame[0]);
+    uint32_t sent = sys_get_le32(&frame[4]);
+
+    for (size_t i = BENCH_HDR_LEN; i < len; i++) {
+        if (frame[i] != (uint8_t)(seq + i)) {
+            atomic_inc(&port->corrupt);
+            return;
+        }
+    }
+
+    bench_lat_add(&bench.lat, (uint32_t)now - sent);
+
+    atomic_inc(&port->rx_packets);
+    atomic_add(&port->rx_bytes, len);
+    bench.last_rx_us = now;
+}
+
+static void bench_rx_callback(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    struct app_framer *framer = &ports[app_uart_index(uart)].framer;
+    uint32_t rdy;
+
+    // the ISR to callback part of the latency, CONFIG_APP_UART_STATS stamps UART_RX_RDY
+    if (app_uart_rx_rdy_ts(uart, &rdy) == 0) {
+        bench_lat_add(&bench.isr, k_cyc_to_us_floor32(k_cycle_get_32() - rdy));
+    }
+
+    if (app_uart_rx_frame_end(uart)) {
+        app_framer_feed_end(framer, byte, len);
+    } else {
+        app_framer_feed(framer, byte, len);
+    }
+
+    if (CONFIG_APP_BENCH_RX_DELAY_US > 0) {
+        k_busy_wait(CONFIG_APP_BENCH_RX_DELAY_US);
+    }
+}
+
+static void bench_uart_counters(struct bench_port *port, uint32_t *exhausted, uint32_t *rearms,
+                                uint32_t *chunks)
+{
+#if IS_ENABLED(CONFIG_APP_UART_STATS)
+    struct app_uart_stats stats;
+
+    app_uart_stats_get(app_uart_index(port->uart), &stats);
+    *exhausted = stats.counters[APP_UART_CNT_RX_SLAB_EXHAUSTED];
+    *rearms = stats.counters[APP_UART_CNT_RX_REARMS];
+    // every UART_RX_RDY chunk queued for the RX context
+    *chunks = stats.stages[APP_UART_STAGE_RX_ISR].count;
+#else
+    *exhausted = 0;
+    *rearms = 0;
+    *chunks = 0;
+#endif
+}
+
+static void bench_ring_stats(struct bench_port *port, struct app_uart_rx_ring_stats *ring)
+{
+#if !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    app_uart_rx_ring_stats_get(port->uart, ring);
+#else
+    *ring = (struct app_uart_rx_ring_stats) {0};
+#endif
+}
+
+static uint32_t bench_rx_packets(void)
+{
+    uint32_t total = 0;
+
+    for (size_t p = 0; p < ARRAY_SIZE(ports); p++) {
+        total += atomic_get(&ports[p].rx_packets);
+    }
+    return total;
+}
+
+static void bench_send(struct bench_port *port, uint32_t seq, uint16_t size, uint32_t *tx_full)
+{
+    sys_put_le32(seq, &tx_packet[0]);
+    for (size_t i = BENCH_HDR_LEN; i < size; i++) {
+        tx_packet[i] = (uint8_t)(seq + i);
+    }
+
+    while (1) {
+        // stamp as late as possible
+        sys_put_le32((uint32_t)bench_now_us(), &tx_packet[4]);
+
+        int err = app_framer_send(port->uart, tx_packet, size);
+        if (err != -ENOMEM && err != -EBUSY) {
+            if (err) {
+                LOG_ERR("Failed to send packet %u on %s: %d", seq,
+                        app_uart_name(port->uart), err);
+            }
+            return;
+        }
+
+        // TX buffer full, let the line drain
+        (*tx_full)++;
+        k_sleep(K_TICKS(1));
+    }
+}
+
+static void bench_case(uint16_t size, const struct burst_pattern *pattern)
+{
+    const uint32_t sent = CONFIG_APP_BENCH_PACKETS * ARRAY_SIZE(ports);
+    uint32_t tx_full = 0;
+    uint64_t start, end;
+    size_t heap_start;
+
+    for (size_t p = 0; p < ARRAY_SIZE(ports); p++) {
+        struct bench_port *port = &ports[p];
+
+        bench_ring_stats(port, &port->ring);
+        bench_uart_counters(port, &port->exhausted, &port->rearms, &port->chunks);
+        port->framer_stats = port->framer.stats;
+        atomic_clear(&port->rx_packets);
+        atomic_clear(&port->rx_bytes);
+        atomic_clear(&port->corrupt);
+    }
+    bench_lat_reset(&bench.lat);
+    bench_lat_reset(&bench.isr);
+    // nothing on the RX path may allocate, whatever the number of chunks
+    heap_start = bench_heap_mark();
+
+    start = bench_now_us();
+    bench.last_rx_us = start;
+
+    for (uint32_t seq = 0; seq < CONFIG_APP_BENCH_PACKETS; seq++) {
+        for (size_t p = 0; p < ARRAY_SIZE(ports); p++) {
+            bench_send(&ports[p], seq, size, &tx_full);
+        }
+
+        if (pattern->burst != 0 && (seq + 1) % pattern->burst == 0) {
+            k_msleep(pattern->gap_ms);
+        }
+    }
+
+    // operating point the traffic of the case settled on, before the tail
+    struct app_uart_rx_point point;
+
+    app_uart_rx_point_get(ports[0].uart, &point);
+
+    // wait for the tail
+    while (bench_rx_packets() < sent &&
+           bench_now_us() - bench.last_rx_us < CONFIG_APP_BENCH_IDLE_TIMEOUT_MS * 1000ULL) {
+        k_msleep(1);
+    }
+    end = MAX(bench.last_rx_us, start + 1);
+
+    // aggregate over the ports
+    uint32_t rx_packets = 0, rx_bytes = 0, corrupt = 0;
+    uint32_t overflows = 0, high_watermark = 0;
+    uint32_t framer_errors = 0, framer_overflows = 0;
+    uint32_t exhausted = 0, rearms = 0, chunks = 0;
+    size_t heap_max = bench_heap_max();
+
+    for (size_t p = 0; p < ARRAY_SIZE(ports); p++) {
+        struct bench_port *port = &ports[p];
+        struct app_uart_rx_ring_stats ring;
+        uint32_t port_exhausted, port_rearms, port_chunks;
+
+        bench_ring_stats(port, &ring);
+        bench_uart_counters(port, &port_exhausted, &port_rearms, &port_chunks);
+
+        rx_packets += atomic_get(&port->rx_packets);
+        rx_bytes += atomic_get(&port->rx_bytes);
+        corrupt += atomic_get(&port->corrupt);
+        overflows += ring.overflows - port->ring.overflows;
+        high_watermark = MAX(high_watermark, ring.high_watermark);
+        framer_errors += port->framer.stats.errors - port->framer_stats.errors;
+        framer_overflows += port->framer.stats.overflows - port->framer_stats.overflows;
+        exhausted += port_exhausted - port->exhausted;
+        rearms += port_rearms - port->rearms;
+        chunks += port_chunks - port->chunks;
+    }
+
+    uint64_t bytes_per_sec = (uint64_t)rx_bytes * 1000000ULL / (end - start);
+    uint32_t p50, p99, max;
+    uint32_t isr_p50, isr_p99, isr_max;
+
+    bench_lat_percentiles(&bench.lat, &p50, &p99, &max);
+    bench_lat_percentiles(&bench.isr, &isr_p50, &isr_p99, &isr_max);
+
+    printk("BENCH {\"case\":\"%s\",\"size\":%u,\"ports\":%u,\"sent\":%u,\"received\":%u,"
+           "\"lost\":%u,\"corrupt\":%u,\"bytes_per_sec\":%u,\"mb_per_s\":%u.%03u,"
+           "\"lat_p50_us\":%u,\"lat_p99_us\":%u,\"lat_max_us\":%u,"
+           "\"isr_lat_p50_us\":%u,\"isr_lat_p99_us\":%u,\"isr_lat_max_us\":%u,"
+           "\"tx_full\":%u,\"rx_ring_overflows\":%u,\"rx_ring_high_watermark\":%u,"
+           "\"framer_errors\":%u,\"framer_overflows\":%u,\"heap_max\":%u,"
+           "\"rx_chunks\":%u,\"heap_grown\":%u,"
+           "\"rx_slab_exhausted\":%u,\"rx_rearms\":%u,"
+           "\"rx_len\":%u,\"rx_timeout_us\":%u,\"rx_events_per_sec\":%u}\n",
+           pattern->name, size, (uint32_t)ARRAY_SIZE(ports), sent, rx_packets,
+           sent - MIN(rx_packets, sent), corrupt, (uint32_t)bytes_per_sec,
+           (uint32_t)(bytes_per_sec / 1000000), (uint32_t)(bytes_per_sec / 1000 % 1000),
+           p50, p99, max,
+           isr_p50, isr_p99, isr_max,
+           tx_full, overflows, high_watermark,
+           framer_errors, framer_overflows,
+           (uint32_t)heap_max,
+           chunks, (uint32_t)(heap_max - MIN(heap_start, heap_max)),
+           exhausted, rearms,
+           point.rx_len, point.timeout_us, point.events_per_sec);
+}
+
+#if IS_ENABLED(CONFIG_APP_POOL)
+/* true if every class a packet of len bytes may come from is full */
+static bool bench_pool_full(size_t len)
+{
+    struct app_pool_stats stats;
+
+    for (size_t i = 0; i < APP_POOL_CLASS_NUM; i++) {
+        app_pool_stats_get(i, &stats);
+        if (len > stats.block_size) {
+            continue;
+        }
+        if (stats.used < stats.block_num) {
+            return false;
+        }
+        if (!IS_ENABLED(CONFIG_APP_POOL_FALLBACK)) {
+            break;
+        }
+    }
+    return true;
+}
+
+/* Randomized soak of the packet pool, random sizes freed in random order.
+ * An allocation may only fail when every class it fits in is full,
+ * any other failure is counted as fragmentation. */
+static void bench_pool_soak(void)
+{
+    static struct {
+        uint8_t *buf;
+        uint16_t len;
+    } live[CONFIG_APP_POOL_CLASS0_COUNT + CONFIG_APP_POOL_CLASS1_COUNT +
+           CONFIG_APP_POOL_CLASS2_COUNT];
+    static const uint16_t class_sizes[] = {
+        CONFIG_APP_POOL_CLASS0_SIZE, CONFIG_APP_POOL_CLASS1_SIZE, CONFIG_APP_POOL_CLASS2_SIZE,
+    };
+    struct app_pool_stats stats[APP_POOL_CLASS_NUM];
+    uint32_t rng = 0x2545f491;
+    uint32_t allocs = 0, full = 0, fragmented = 0, corrupt = 0;
+    size_t used = 0;
+
+    app_pool_stats_reset();
+
+    for (uint32_t r = 0; r < CONFIG_APP_BENCH_POOL_SOAK_ROUNDS; r++) {
+        // xorshift32
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+
+        // allocate two steps out of three, the pool stays mostly busy
+        if (used < ARRAY_SIZE(live) && (used == 0 || rng % 3 != 0)) {
+            uint16_t len = 1 + (rng >> 8) % class_sizes[(rng >> 4) % ARRAY_SIZE(class_sizes)];
+            uint8_t *buf = app_pool_alloc(len);
+
+            if (buf == NULL) {
+                if (bench_pool_full(len)) {
+                    full++;
+                } else {
+                    fragmented++;
+                }
+                continue;
+            }
+            if (app_pool_block_size(buf) < len) {
+                corrupt++;
+            }
+
+            memset(buf, (uint8_t)len, len);
+            live[used].buf = buf;
+            live[used].len = len;
+            used++;
+            allocs++;
+        } else {
+            size_t idx = (rng >> 8) % used;
+
+            // a block that overlaps another one shows up here
+            for (size_t i = 0; i < live[idx].len; i++) {
+                if (live[idx].buf[i] != (uint8_t)live[idx].len) {
+                    corrupt++;
+                    break;
+                }
+            }
+            app_pool_free(live[idx].buf);
+            live[idx] = live[--used];
+        }
+    }
+
+    while (used > 0) {
+        app_pool_free(live[--used].buf);
+    }
+
+    for (size_t i = 0; i < APP_POOL_CLASS_NUM; i++) {
+        app_pool_stats_get(i, &stats[i]);
+    }
+
+    printk("BENCH {\"case\":\"pool_soak\",\"rounds\":%u,\"allocs\":%u,\"full\":%u,"
+           "\"fragmentation_failures\":%u,\"corrupt\":%u,\"leaked\":%u,"
+           "\"max_used\":[%u,%u,%u],\"fallbacks\":[%u,%u,%u]}\n",
+           CONFIG_APP_BENCH_POOL_SOAK_ROUNDS, allocs, full, fragmented, corrupt,
+           stats[0].used + stats[1].used + stats[2].used,
+           stats[0].max_used, stats[1].max_used, stats[2].max_used,
+           stats[0].fallbacks, stats[1].fallbacks, stats[2].fallbacks);
+}
+#endif /* CONFIG_APP_POOL */
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_THREAD)
+/* K_THREAD_DEFINE() in app_uart.c */
+extern const k_tid_t app_uart_rx_id;
+#endif
+
+/* RAM of the RX context: the thread object and stack only the RX thread
+ * takes, and the peak stack use of the thread the RX callbacks ran on,
+ * the system workqueue shares its stack with every other work item. */
+static void bench_rx_ram(void)
+{
+#if IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_THREAD)
+    k_tid_t tid = app_uart_rx_id;
+    uint32_t own = sizeof(struct k_thread) + CONFIG_APP_UART_RX_THREAD_STACK_SIZE;
+#else
+    k_tid_t tid = &k_sys_work_q.thread;
+    uint32_t own = 0;
+#endif
+    uint32_t stack_size = 0, stack_used = 0;
+
+#if defined(CONFIG_THREAD_STACK_INFO) && defined(CONFIG_INIT_STACKS)
+    size_t unused;
+
+    if (k_thread_stack_space_get(tid, &unused) == 0) {
+        stack_size = tid->stack_info.size;
+        stack_used = stack_size - unused;
+    }
+#else
+    ARG_UNUSED(tid);
+#endif
+
+    printk("BENCH {\"case\":\"rx_ram\",\"rx_context\":\"%s\",\"own_bytes\":%u,"
+           "\"thread_bytes\":%u,\"stack_size\":%u,\"stack_used\":%u}\n",
+           IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_WORKQUEUE) ? "workqueue" : "thread", own,
+           (uint32_t)sizeof(struct k_thread), stack_size, stack_used);
+}
+
+int bench_throughput_run(void)
+{
+    int err;
+
+    for (size_t p = 0; p < ARRAY_SIZE(ports); p++) {
+        struct bench_port *port = &ports[p];
+
+        port->uart = app_uart_at(p);
+        app_framer_init(&port->framer, port->frame_buf, sizeof(port->frame_buf),
+                        bench_frame_handler, port);
+
+        err = app_uart_rx_cb_register(port->uart, bench_rx_callback);
+        if (err) {
+            LOG_ERR("Failed to register RX callback: %d", err);
+            return err;
+        }
+    }
+
+    printk("BENCH {\"config\":{\"rx_block_size\":%u,\"rx_block_number\":%u,"
+           "\"rx_zero_copy\":%u,\"rx_ring_size\":%u,\"tx_buf_size\":%u,\"packets\":%u,"
+           "\"rx_delay_us\":%u,\"ports\":%u,\"rx_context\":\"%s\",\"rx_thread_stack\":%u,\"usb_backend\":\"%s\","
+           "\"rx_adaptive\":\"%s\"}}\n",
+           CONFIG_APP_UART_RX_DMA_BLOCK_SIZE, CONFIG_APP_UART_RX_DMA_BLOCK_NUMBER,
+           IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY),
+           COND_CODE_1(CONFIG_APP_UART_RX_ZERO_COPY, (0), (CONFIG_APP_UART_RX_RING_SIZE)),
+           CONFIG_APP_UART_TX_BUF_SIZE, CONFIG_APP_BENCH_PACKETS, CONFIG_APP_BENCH_RX_DELAY_US,
+           (uint32_t)ARRAY_SIZE(ports),
+           IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_WORKQUEUE) ? "workqueue" : "thread",
+           COND_CODE_1(CONFIG_APP_UART_RX_CONTEXT_THREAD, (CONFIG_APP_UART_RX_THREAD_STACK_SIZE), (0)),
+           IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE) ? "native" :
+           IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER) ? "adapter" : "none",
+           IS_ENABLED(CONFIG_APP_UART_RX_ADAPT_LATENCY) ? "latency" :
+           IS_ENABLED(CONFIG_APP_UART_RX_ADAPT_ISR_RATE) ? "isr_rate" : "off");
+
+#if IS_ENABLED(CONFIG_APP_POOL)
+    bench_pool_soak();
+#endif
+
+    for (size_t p = 0; p < ARRAY_SIZE(patterns); p++) {
+        for (size_t s = 0; s < ARRAY_SIZE(packet_sizes); s++) {
+            if (packet_sizes[s] > sizeof(tx_packet)) {
+                continue;
+            }
+            bench_case(packet_sizes[s], &patterns[p]);
+        }
+    }
+
+    // after the cases, for the deepest stack the RX callbacks reached
+    bench_rx_ram();
+
+    printk("BENCH DONE\n");
+    return 0;
+}
+
+int app_bench_run(void)
+{
+    if (CONFIG_APP_BENCH_START_DELAY_MS > 0) {
+        // time for the host to open the port, e.g. scripts/usb_echo.py
+        k_sleep(K_MSEC(CONFIG_APP_BENCH_START_DELAY_MS));
+    }
+
+#if IS_ENABLED(CONFIG_APP_BENCH_BAUD)
+    /* negotiation cases between two wired ports instead of the loopback cases */
+    return bench_baud_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_ARQ)
+    /* reliable transport cases between two ports wired through a lossy wire */
+    return bench_arq_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_CRC)
+    /* CPU cost of the CRC variants, the UART isn't used */
+    return bench_crc_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_CRLF)
+    /* CPU cost of the CRLF framer against the per-byte state machine */
+    return bench_crlf_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_FRAMER)
+    /* fuzz and CPU cost of the framing engine, the UART isn't used */
+    return bench_framer_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_LZ)
+    /* compression ratio and CPU cost, the UART isn't used */
+    return bench_lz_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_MUX)
+    /* channel scheduling cases instead of the raw throughput cases */
+    return bench_mux_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_TX)
+    /* pipelined TX against a transfer per packet */
+    return bench_tx_run();
+#elif IS_ENABLED(CONFIG_APP_BENCH_SUB)
+    /* RX views shared by subscribers, slab usage and drops per policy */
+    return bench_sub_run();
+#else
+    /* framed packets over the looped back ports */
+    return bench_throughput_run();
+#endif
+}
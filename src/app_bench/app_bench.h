@@ -0,0 +1,184 @@
+#ifndef __APP_BENCH_H
+#define __APP_BENCH_H
+
+#include <stdint.h>
+#if defined(CONFIG_TIMING_FUNCTIONS)
+#include <zephyr/timing/timing.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run the throughput and latency benchmark over the app_uart link
+ *
+ * The TX line must be looped back to RX: the loopback property of
+ * zephyr,uart-emul on native_sim, or a wire on a DK.
+ * Results are printed as one JSON object per line, prefixed with "BENCH ".
+ * @return 0 on success, negative error code on failure
+ */
+int app_bench_run(void);
+
+/**
+ * @brief Run the throughput and latency cases, called by app_bench_run()
+ *
+ * Framed packets of every size and burst pattern over the looped back
+ * ports, CONFIG_APP_BENCH_THROUGHPUT, the default.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_throughput_run(void);
+
+/**
+ * @brief Run the baud rate negotiation cases, called by app_bench_run()
+ *
+ * Two zephyr,uart-emul ports of bench_baud.overlay are wired to each other,
+ * the wire garbles the bytes while their rates differ.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_baud_run(void);
+
+/**
+ * @brief Run the reliable transport cases, called by app_bench_run()
+ *
+ * Two zephyr,uart-emul ports of bench_arq.overlay are wired to each other,
+ * the wire drops bytes and flips bits at the rates of each case.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_arq_run(void);
+
+/**
+ * @brief Run the multiplexer cases, called by app_bench_run()
+ *
+ * Bulk frames saturate two channels of the looped back port while
+ * commands go on a third one, with and without priority and weights.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_mux_run(void);
+
+/**
+ * @brief Run the CRC engine cases, called by app_bench_run()
+ *
+ * No UART involved: every CRC variant over buffers of several lengths.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_crc_run(void);
+
+/**
+ * @brief Run the compression cases, called by app_bench_run()
+ *
+ * No UART involved: text and random data through the app_lz codec.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_lz_run(void);
+
+/**
+ * @brief Run the CRLF framer cases, called by app_bench_run()
+ *
+ * No UART involved: text lines through the CRLF framer and through the
+ * per-byte state machine it replaced, and the contract they share.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_crlf_run(void);
+
+/**
+ * @brief Run the framing engine cases, called by app_bench_run()
+ *
+ * No UART involved: random payloads through the encoder and the decoder
+ * of the engine picked by CONFIG_APP_FRAMER_*, and their CPU cost.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_framer_run(void);
+
+/**
+ * @brief Run the TX engine cases, called by app_bench_run()
+ *
+ * Packets of several sizes over the looped back port, a transfer per
+ * packet as the TX thread used to, and packed into the staging buffers.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_tx_run(void);
+
+/**
+ * @brief Run the RX subscriber cases, called by app_bench_run()
+ *
+ * Packets over the looped back port to several subscribers of its RX
+ * views, one of them slow, under both subscriber policies.
+ * @return 0 once the cases ran, their results are in the "BENCH " lines
+ */
+int bench_sub_run(void);
+
+/**
+ * @brief Time base of the latencies, the host clock on native_sim
+ */
+uint64_t bench_now_us(void);
+
+/* CPU cycles of the CPU bound cases, "cycles" in their config line */
+#if defined(CONFIG_BOARD_NATIVE_SIM) && (defined(__x86_64__) || defined(__i386__))
+/* time stamp counter of the host, at its nominal clock */
+#define BENCH_CYCLES_SOURCE "tsc"
+typedef uint64_t bench_stamp_t;
+
+static inline void bench_cycles_start(void) {}
+static inline void bench_cycles_stop(void) {}
+
+static inline bench_stamp_t bench_stamp(void)
+{
+    return __builtin_ia32_rdtsc();
+}
+
+static inline uint64_t bench_cycles_since(bench_stamp_t *start)
+{
+    return bench_stamp() - *start;
+}
+#elif defined(CONFIG_TIMING_FUNCTIONS)
+/* CPU cycles, DWT on Cortex-M */
+#define BENCH_CYCLES_SOURCE "timing"
+typedef timing_t bench_stamp_t;
+
+static inline void bench_cycles_start(void)
+{
+    timing_init();
+    timing_start();
+}
+
+static inline void bench_cycles_stop(void)
+{
+    timing_stop();
+}
+
+static inline bench_stamp_t bench_stamp(void)
+{
+    return timing_counter_get();
+}
+
+static inline uint64_t bench_cycles_since(bench_stamp_t *start)
+{
+    timing_t now = timing_counter_get();
+
+    return timing_cycles_get(start, &now);
+}
+#else
+/* no cycle counter, the cases print the time only */
+#define BENCH_CYCLES_SOURCE "none"
+typedef uint64_t bench_stamp_t;
+
+static inline void bench_cycles_start(void) {}
+static inline void bench_cycles_stop(void) {}
+
+static inline bench_stamp_t bench_stamp(void)
+{
+    return 0;
+}
+
+static inline uint64_t bench_cycles_since(bench_stamp_t *start)
+{
+    return 0;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_BENCH_H
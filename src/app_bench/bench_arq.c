@@ -0,0 +1,270 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_arq.h"
+#include "app_bench.h"
+#include "app_framer.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+/* two emulated UARTs without loopback, wired to each other below, see bench_arq.overlay */
+#define ARQ_A_NODE DT_NODELABEL(arq_a)
+#define ARQ_B_NODE DT_NODELABEL(arq_b)
+
+BUILD_ASSERT(DT_NODE_HAS_STATUS(ARQ_A_NODE, okay) && DT_NODE_HAS_STATUS(ARQ_B_NODE, okay),
+             "The reliable transport test needs bench_arq.overlay");
+
+#define FLUSH_TIMEOUT K_SECONDS(10)
+
+/* payload: | seq (32 bit) | filler | */
+#define PAYLOAD_HDR_LEN 4
+
+/* per byte on the wire, in parts per million, both directions */
+struct lossy_case {
+    const char *name;
+    uint32_t drop_ppm;
+    uint32_t corrupt_ppm;
+};
+
+static const struct lossy_case cases[] = {
+    { "arq_clean", 0, 0 },
+    { "arq_corrupt_1e-4", 0, 100 },
+    { "arq_corrupt_1e-3", 0, 1000 },
+    { "arq_drop_1e-4", 100, 0 },
+    { "arq_mixed_1e-3", 500, 500 },
+    { "arq_mixed_1e-2", 5000, 5000 },
+};
+
+enum { SIDE_A, SIDE_B, SIDE_COUNT };
+
+struct arq_side {
+    struct app_uart *uart;
+    const struct device *dev;
+    struct arq_side *peer;
+    struct app_framer framer;
+    uint8_t frame_buf[CONFIG_APP_FRAMER_MAX_FRAME_LEN];
+};
+
+static struct arq_side sides[SIDE_COUNT] = {
+    [SIDE_A] = { .peer = &sides[SIDE_B] },
+    [SIDE_B] = { .peer = &sides[SIDE_A] },
+};
+
+/* the wire, changed between the cases only */
+static struct {
+    uint32_t drop_ppm;
+    uint32_t corrupt_ppm;
+    uint32_t rng;
+    atomic_t bytes;
+    atomic_t dropped;
+    atomic_t corrupted;
+} wire = { .rng = 0x2545f491 };
+
+/* what B got from A */
+static struct {
+    uint32_t next_seq;
+    atomic_t delivered;
+    atomic_t bytes;
+    atomic_t out_of_order;
+    atomic_t corrupt;
+} sink;
+
+static uint8_t payload[CONFIG_APP_ARQ_MAX_PAYLOAD];
+
+static uint32_t wire_rand_ppm(void)
+{
+    // xorshift32
+    wire.rng ^= wire.rng << 13;
+    wire.rng ^= wire.rng >> 17;
+    wire.rng ^= wire.rng << 5;
+    return wire.rng % 1000000;
+}
+
+/* The wire: what one side sends is received by the other one, with bytes
+ * dropped and bits flipped at the rates of the case.
+ */
+static void wire_tx_ready(const struct device *dev, size_t size, void *user_data)
+{
+    struct arq_side *from = user_data;
+    uint8_t buf[64];
+    uint8_t out[64];
+    uint32_t len;
+
+    while ((len = uart_emul_get_tx_data(dev, buf, sizeof(buf))) > 0) {
+        size_t n = 0;
+
+        atomic_add(&wire.bytes, len);
+        for (uint32_t i = 0; i < len; i++) {
+            if (wire.drop_ppm > 0 && wire_rand_ppm() < wire.drop_ppm) {
+                atomic_inc(&wire.dropped);
+                continue;
+            }
+            out[n] = buf[i];
+            if (wire.corrupt_ppm > 0 && wire_rand_ppm() < wire.corrupt_ppm) {
+                out[n] ^= BIT(wire.rng % 8);
+                atomic_inc(&wire.corrupted);
+            }
+            n++;
+        }
+        uart_emul_put_rx_data(from->peer->dev, out, n);
+    }
+}
+
+static void arq_frame_handler(struct app_framer *framer, uint8_t *frame, size_t len)
+{
+    struct arq_side *side = framer->user_data;
+
+    // anything else is a frame damaged beyond the tag
+    (void)app_arq_frame(side->uart, frame, len);
+}
+
+static void arq_rx_callback(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    struct arq_side *side = (uart == sides[SIDE_A].uart) ? &sides[SIDE_A] : &sides[SIDE_B];
+
+    if (app_uart_rx_frame_end(uart)) {
+        app_framer_feed_end(&side->framer, byte, len);
+    } else {
+        app_framer_feed(&side->framer, byte, len);
+    }
+}
+
+static void arq_sink(struct app_uart *uart, const uint8_t *data, size_t len)
+{
+    if (uart != sides[SIDE_B].uart) {
+        return;
+    }
+
+    uint32_t seq = sys_get_le32(data);
+
+    if (len != sizeof(payload) || seq != sink.next_seq) {
+        atomic_inc(&sink.out_of_order);
+    }
+    sink.next_seq = seq + 1;
+
+    for (size_t i = PAYLOAD_HDR_LEN; i < len; i++) {
+        if (data[i] != (uint8_t)(seq + i)) {
+            atomic_inc(&sink.corrupt);
+            break;
+        }
+    }
+
+    atomic_inc(&sink.delivered);
+    atomic_add(&sink.bytes, len);
+}
+
+static void arq_case(const struct lossy_case *lc)
+{
+    struct app_arq_stats tx, rx;
+    uint32_t sent = 0;
+
+    wire.drop_ppm = lc->drop_ppm;
+    wire.corrupt_ppm = lc->corrupt_ppm;
+    atomic_clear(&wire.bytes);
+    atomic_clear(&wire.dropped);
+    atomic_clear(&wire.corrupted);
+
+    // the sequence of the transport goes on, the payload counts from 0
+    sink.next_seq = 0;
+    atomic_clear(&sink.delivered);
+    atomic_clear(&sink.bytes);
+    atomic_clear(&sink.out_of_order);
+    atomic_clear(&sink.corrupt);
+    app_arq_stats_reset(sides[SIDE_A].uart);
+    app_arq_stats_reset(sides[SIDE_B].uart);
+
+    uint64_t start = bench_now_us();
+
+    for (uint32_t seq = 0; seq < CONFIG_APP_BENCH_PACKETS; seq++) {
+        sys_put_le32(seq, payload);
+        for (size_t i = PAYLOAD_HDR_LEN; i < sizeof(payload); i++) {
+            payload[i] = (uint8_t)(seq + i);
+        }
+
+        int err = app_arq_send(sides[SIDE_A].uart, payload, sizeof(payload), FLUSH_TIMEOUT);
+
+        if (err) {
+            LOG_ERR("Failed to send payload %u: %d", seq, err);
+            break;
+        }
+        sent++;
+    }
+
+    int flushed = app_arq_flush(sides[SIDE_A].uart, FLUSH_TIMEOUT);
+    uint64_t us = MAX(bench_now_us() - start, 1);
+
+    // the last ACKs and retransmissions settle before the next case
+    k_sleep(K_MSEC(2 * CONFIG_APP_ARQ_RTO_MS));
+    app_framer_reset(&sides[SIDE_A].framer);
+    app_framer_reset(&sides[SIDE_B].framer);
+
+    app_arq_stats_get(sides[SIDE_A].uart, &tx);
+    app_arq_stats_get(sides[SIDE_B].uart, &rx);
+
+    uint32_t delivered = atomic_get(&sink.delivered);
+    uint32_t bytes = atomic_get(&sink.bytes);
+    uint32_t wire_bytes = MAX((uint32_t)atomic_get(&wire.bytes), 1);
+
+    printk("BENCH {\"case\":\"%s\",\"drop_ppm\":%u,\"corrupt_ppm\":%u,\"sent\":%u,"
+           "\"delivered\":%u,\"out_of_order\":%u,\"corrupt\":%u,\"flushed\":%u,"
+           "\"goodput_bytes_per_sec\":%u,\"efficiency_permille\":%u,"
+           "\"wire_dropped\":%u,\"wire_corrupted\":%u,\"retransmits\":%u,"
+           "\"fast_retransmits\":%u,\"rx_bad_crc\":%u,\"rx_out_of_order\":%u,"
+           "\"rx_duplicates\":%u,\"acks\":%u,\"pass\":%u}\n",
+           lc->name, lc->drop_ppm, lc->corrupt_ppm, sent, delivered,
+           (uint32_t)atomic_get(&sink.out_of_order), (uint32_t)atomic_get(&sink.corrupt),
+           flushed == 0, (uint32_t)((uint64_t)bytes * 1000000 / us),
+           (uint32_t)((uint64_t)bytes * 1000 / wire_bytes),
+           (uint32_t)atomic_get(&wire.dropped), (uint32_t)atomic_get(&wire.corrupted),
+           tx.retransmits, tx.fast_retransmits, rx.rx_bad_crc, rx.rx_out_of_order,
+           rx.rx_duplicates, rx.acks_sent,
+           delivered == sent && atomic_get(&sink.out_of_order) == 0 &&
+           atomic_get(&sink.corrupt) == 0);
+}
+
+int bench_arq_run(void)
+{
+    sides[SIDE_A].uart = app_uart_get(ARQ_A_NODE);
+    sides[SIDE_A].dev = DEVICE_DT_GET(ARQ_A_NODE);
+    sides[SIDE_B].uart = app_uart_get(ARQ_B_NODE);
+    sides[SIDE_B].dev = DEVICE_DT_GET(ARQ_B_NODE);
+
+    for (size_t i = 0; i < SIDE_COUNT; i++) {
+        struct arq_side *side = &sides[i];
+        int err;
+
+        app_framer_init(&side->framer, side->frame_buf, sizeof(side->frame_buf),
+                        arq_frame_handler, side);
+        uart_emul_callback_tx_data_ready_set(side->dev, wire_tx_ready, side);
+
+        err = app_arq_open(side->uart, arq_sink);
+        if (err) {
+            LOG_ERR("Failed to open the reliable transport: %d", err);
+            return err;
+        }
+
+        err = app_uart_rx_cb_register(side->uart, arq_rx_callback);
+        if (err) {
+            LOG_ERR("Failed to register RX callback: %d", err);
+            return err;
+        }
+    }
+
+    printk("BENCH {\"config\":{\"arq_window\":%u,\"arq_max_payload\":%u,\"arq_rto_ms\":%u,"
+           "\"arq_ack_delay_ms\":%u,\"packets\":%u}}\n",
+           CONFIG_APP_ARQ_WINDOW, CONFIG_APP_ARQ_MAX_PAYLOAD, CONFIG_APP_ARQ_RTO_MS,
+           CONFIG_APP_ARQ_ACK_DELAY_MS, CONFIG_APP_BENCH_PACKETS);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        arq_case(&cases[i]);
+    }
+
+    printk("BENCH DONE\n");
+    return 0;
+}
@@ -0,0 +1,262 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "app_baud.h"
+#include "app_framer.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+/* two emulated UARTs without loopback, wired to each other below, see bench_baud.overlay */
+#define BAUD_A_NODE DT_NODELABEL(baud_a)
+#define BAUD_B_NODE DT_NODELABEL(baud_b)
+
+BUILD_ASSERT(DT_NODE_HAS_STATUS(BAUD_A_NODE, okay) && DT_NODE_HAS_STATUS(BAUD_B_NODE, okay),
+             "The baud rate test needs bench_baud.overlay");
+
+#define RESULT_TIMEOUT K_MSEC(4 * CONFIG_APP_BAUD_TIMEOUT_MS)
+#define AUTO_TIMEOUT K_SECONDS(5)
+
+/* the peer's 'U' run for auto-baud, repeated until a rate is detected */
+#define SYNC_PERIOD K_MSEC(20)
+static const uint8_t sync_run[] = "UUUUUUUU";
+
+enum { SIDE_A, SIDE_B, SIDE_COUNT };
+
+struct baud_side {
+    struct app_uart *uart;
+    const struct device *dev;
+    struct baud_side *peer;
+    struct app_framer framer;
+    uint8_t frame_buf[CONFIG_APP_FRAMER_MAX_FRAME_LEN];
+    atomic_t unexpected;
+
+    /* last negotiation result */
+    int result;
+    struct k_sem done;
+};
+
+static struct baud_side sides[SIDE_COUNT] = {
+    [SIDE_A] = { .peer = &sides[SIDE_B] },
+    [SIDE_B] = { .peer = &sides[SIDE_A] },
+};
+
+/* bytes faster than this are garbled on the wire, as by a long cable */
+static uint32_t wire_max_baud = UINT32_MAX;
+
+/* bytes stay in the TX FIFOs meanwhile, see wire_release() */
+static atomic_t wire_hold;
+
+static void sync_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(sync_work, sync_handler);
+
+/* The wire: what one side sends is received by the other one, unless their
+ * rates differ, then every byte arrives damaged as a real UART would see it.
+ */
+static void wire_tx_ready(const struct device *dev, size_t size, void *user_data)
+{
+    struct baud_side *from = user_data;
+    uint32_t rate = app_uart_baudrate(from->uart);
+    bool garble = (rate != app_uart_baudrate(from->peer->uart)) || (rate > wire_max_baud);
+    uint8_t buf[64];
+    uint32_t len;
+
+    if (atomic_get(&wire_hold)) {
+        return;
+    }
+
+    while ((len = uart_emul_get_tx_data(dev, buf, sizeof(buf))) > 0) {
+        if (garble) {
+            for (uint32_t i = 0; i < len; i++) {
+                buf[i] ^= 0xA5;
+            }
+        }
+        uart_emul_put_rx_data(from->peer->dev, buf, len);
+    }
+}
+
+static void wire_release(void)
+{
+    atomic_clear(&wire_hold);
+    for (size_t i = 0; i < SIDE_COUNT; i++) {
+        wire_tx_ready(sides[i].dev, 0, &sides[i]);
+    }
+}
+
+static void baud_frame_handler(struct app_framer *framer, uint8_t *frame, size_t len)
+{
+    struct baud_side *side = framer->user_data;
+
+    if (!app_baud_frame(side->uart, frame, len)) {
+        atomic_inc(&side->unexpected);
+    }
+}
+
+static void baud_rx_callback(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    struct baud_side *side = (uart == sides[SIDE_A].uart) ? &sides[SIDE_A] : &sides[SIDE_B];
+
+    app_framer_feed(&side->framer, byte, len);
+}
+
+static void baud_result(struct app_uart *uart, uint32_t baudrate, int result)
+{
+    struct baud_side *side = (uart == sides[SIDE_A].uart) ? &sides[SIDE_A] : &sides[SIDE_B];
+
+    side->result = result;
+    k_sem_give(&side->done);
+}
+
+static void sync_handler(struct k_work *work)
+{
+    (void)app_uart_tx(sides[SIDE_A].uart, sync_run, sizeof(sync_run) - 1);
+    k_work_reschedule(&sync_work, SYNC_PERIOD);
+}
+
+static void baud_results_reset(void)
+{
+    for (size_t i = 0; i < SIDE_COUNT; i++) {
+        sides[i].result = -EINPROGRESS;
+        k_sem_reset(&sides[i].done);
+    }
+}
+
+/* Both sides report, the peer of the initiator as well */
+static void baud_print(const char *name, int64_t start_ms, int expected, uint32_t expected_rate)
+{
+    struct baud_side *a = &sides[SIDE_A];
+    struct baud_side *b = &sides[SIDE_B];
+
+    (void)k_sem_take(&a->done, RESULT_TIMEOUT);
+    (void)k_sem_take(&b->done, RESULT_TIMEOUT);
+
+    uint32_t rate_a = app_uart_baudrate(a->uart);
+    uint32_t rate_b = app_uart_baudrate(b->uart);
+    bool pass = a->result == expected && b->result == expected &&
+                rate_a == expected_rate && rate_b == expected_rate;
+
+    printk("BENCH {\"case\":\"baud_%s\",\"result_a\":%d,\"result_b\":%d,"
+           "\"rate_a\":%u,\"rate_b\":%u,\"expected_rate\":%u,\"ms\":%u,\"pass\":%u}\n",
+           name, a->result, b->result, rate_a, rate_b, expected_rate,
+           (uint32_t)(k_uptime_get() - start_ms), pass);
+
+    // garbled bytes left in the framers are not the start of the next frame
+    k_sleep(K_MSEC(10));
+    app_framer_reset(&a->framer);
+    app_framer_reset(&b->framer);
+}
+
+static void baud_case_switch(void)
+{
+    int64_t start = k_uptime_get();
+
+    baud_results_reset();
+    (void)app_baud_propose(sides[SIDE_A].uart, 921600);
+    baud_print("switch", start, 0, 921600);
+}
+
+static void baud_case_fallback(void)
+{
+    uint32_t before = app_uart_baudrate(sides[SIDE_A].uart);
+    int64_t start = k_uptime_get();
+
+    // the proposal goes through at the old rate, the probe doesn't
+    wire_max_baud = before;
+    baud_results_reset();
+    (void)app_baud_propose(sides[SIDE_B].uart, 1000000);
+    baud_print("fallback", start, -ETIMEDOUT, before);
+    wire_max_baud = UINT32_MAX;
+}
+
+static void baud_case_collision(void)
+{
+    uint32_t before = app_uart_baudrate(sides[SIDE_A].uart);
+    int64_t start = k_uptime_get();
+
+    // crossing proposals, both on the wire before either side sees the other one
+    baud_results_reset();
+    atomic_set(&wire_hold, 1);
+    (void)app_baud_propose(sides[SIDE_A].uart, 460800);
+    (void)app_baud_propose(sides[SIDE_B].uart, 230400);
+    (void)app_uart_tx_drain(sides[SIDE_A].uart, K_MSEC(100));
+    (void)app_uart_tx_drain(sides[SIDE_B].uart, K_MSEC(100));
+    wire_release();
+    baud_print("collision", start, -ECONNREFUSED, before);
+}
+
+static void baud_case_auto(void)
+{
+    struct baud_side *b = &sides[SIDE_B];
+    uint32_t expected = app_uart_baudrate(sides[SIDE_A].uart);
+    uint32_t detected = 0;
+    int64_t start = k_uptime_get();
+    int err;
+
+    // B lost track of the rate, A keeps sending its 'U' run
+    (void)app_uart_set_baudrate(b->uart, 9600);
+    k_work_reschedule(&sync_work, K_NO_WAIT);
+
+    err = app_baud_auto(b->uart, AUTO_TIMEOUT, &detected);
+
+    struct k_work_sync sync;
+
+    k_work_cancel_delayable_sync(&sync_work, &sync);
+    (void)app_uart_rx_cb_register(b->uart, baud_rx_callback);
+
+    printk("BENCH {\"case\":\"baud_auto\",\"result\":%d,\"detected\":%u,\"expected_rate\":%u,"
+           "\"ms\":%u,\"pass\":%u}\n",
+           err, detected, expected, (uint32_t)(k_uptime_get() - start),
+           err == 0 && detected == expected);
+
+    // the 'U' runs left in B's framer are not a frame
+    (void)app_uart_tx_drain(sides[SIDE_A].uart, K_MSEC(100));
+    k_sleep(K_MSEC(10));
+    app_framer_reset(&b->framer);
+}
+
+int bench_baud_run(void)
+{
+    sides[SIDE_A].uart = app_uart_get(BAUD_A_NODE);
+    sides[SIDE_A].dev = DEVICE_DT_GET(BAUD_A_NODE);
+    sides[SIDE_B].uart = app_uart_get(BAUD_B_NODE);
+    sides[SIDE_B].dev = DEVICE_DT_GET(BAUD_B_NODE);
+
+    for (size_t i = 0; i < SIDE_COUNT; i++) {
+        struct baud_side *side = &sides[i];
+
+        k_sem_init(&side->done, 0, 1);
+        app_framer_init(&side->framer, side->frame_buf, sizeof(side->frame_buf),
+                        baud_frame_handler, side);
+        uart_emul_callback_tx_data_ready_set(side->dev, wire_tx_ready, side);
+
+        int err = app_uart_rx_cb_register(side->uart, baud_rx_callback);
+
+        if (err) {
+            LOG_ERR("Failed to register RX callback: %d", err);
+            return err;
+        }
+    }
+    app_baud_cb_register(baud_result);
+
+    printk("BENCH {\"config\":{\"baud_timeout_ms\":%u,\"baud_settle_ms\":%u,\"baud_max\":%u,"
+           "\"auto_dwell_ms\":%u,\"auto_sync\":%u,\"initial_rate\":%u}}\n",
+           CONFIG_APP_BAUD_TIMEOUT_MS, CONFIG_APP_BAUD_SETTLE_MS, CONFIG_APP_BAUD_MAX,
+           CONFIG_APP_BAUD_AUTO_DWELL_MS, CONFIG_APP_BAUD_AUTO_SYNC,
+           app_uart_baudrate(sides[SIDE_A].uart));
+
+    baud_case_switch();
+    baud_case_fallback();
+    baud_case_collision();
+    baud_case_auto();
+
+    printk("BENCH {\"case\":\"baud_unexpected\",\"a\":%u,\"b\":%u}\n",
+           (uint32_t)atomic_get(&sides[SIDE_A].unexpected),
+           (uint32_t)atomic_get(&sides[SIDE_B].unexpected));
+    printk("BENCH DONE\n");
+    return 0;
+}
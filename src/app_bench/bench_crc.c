@@ -0,0 +1,160 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "app_crc.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+/* lengths of a short command, a typical frame, and a long one */
+static const size_t lens[] = { 16, 64, 256, 1024 };
+
+static uint8_t data[1024];
+
+/* bit at a time, what the tables replace */
+static uint16_t crc16_bitwise(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x8408 : 0);
+        }
+    }
+    return crc;
+}
+
+static uint32_t crc32_bitwise(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+    return ~crc;
+}
+
+static uint16_t crc16_slice1(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    return app_crc16_ccitt_sliced(crc, buf, len, 1);
+}
+
+static uint32_t crc32_slice1(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    return app_crc32_ieee_update_sliced(crc, buf, len, 1);
+}
+
+#if CONFIG_APP_CRC_SLICES >= 4
+static uint16_t crc16_slice4(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    return app_crc16_ccitt_sliced(crc, buf, len, 4);
+}
+
+static uint32_t crc32_slice4(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    return app_crc32_ieee_update_sliced(crc, buf, len, 4);
+}
+#endif
+
+#if CONFIG_APP_CRC_SLICES >= 8
+static uint16_t crc16_slice8(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    return app_crc16_ccitt_sliced(crc, buf, len, 8);
+}
+
+static uint32_t crc32_slice8(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    return app_crc32_ieee_update_sliced(crc, buf, len, 8);
+}
+#endif
+
+struct crc_variant {
+    const char *name;
+    uint16_t (*crc16)(uint16_t crc, const uint8_t *buf, size_t len);
+    uint32_t (*crc32)(uint32_t crc, const uint8_t *buf, size_t len);
+};
+
+static const struct crc_variant variants[] = {
+    { "bitwise", crc16_bitwise, crc32_bitwise },
+    { "zephyr", crc16_ccitt, crc32_ieee_update },
+    { "slice1", crc16_slice1, crc32_slice1 },
+#if CONFIG_APP_CRC_SLICES >= 4
+    { "slice4", crc16_slice4, crc32_slice4 },
+#endif
+#if CONFIG_APP_CRC_SLICES >= 8
+    { "slice8", crc16_slice8, crc32_slice8 },
+#endif
+};
+
+static void crc_case(const struct crc_variant *v, bool wide, size_t len)
+{
+    uint32_t rounds = CONFIG_APP_BENCH_PACKETS;
+    uint32_t expected, crc;
+
+    // every variant must agree with the bitwise reference
+    if (wide) {
+        expected = crc32_bitwise(0, data, len);
+        crc = v->crc32(0, data, len);
+    } else {
+        expected = crc16_bitwise(0xFFFF, data, len);
+        crc = v->crc16(0xFFFF, data, len);
+    }
+    bool match = (crc == expected);
+
+    uint64_t start_us = bench_now_us();
+    bench_stamp_t start = bench_stamp();
+
+    // chained, so no round can be skipped or hoisted
+    for (uint32_t r = 0; r < rounds; r++) {
+        if (wide) {
+            crc = v->crc32(crc, data, len);
+        } else {
+            crc = v->crc16((uint16_t)crc, data, len);
+        }
+    }
+
+    uint64_t cycles = bench_cycles_since(&start);
+    uint64_t us = MAX(bench_now_us() - start_us, 1);
+    uint64_t bytes = (uint64_t)rounds * len;
+
+    printk("BENCH {\"case\":\"crc\",\"crc\":\"%s\",\"variant\":\"%s\",\"len\":%u,"
+           "\"bytes\":%llu,\"kbytes_per_sec\":%u,\"bytes_per_kcycle\":%u,"
+           "\"result\":\"0x%08x\",\"match\":%u}\n",
+           wide ? "crc32" : "crc16", v->name, (uint32_t)len, (unsigned long long)bytes,
+           (uint32_t)(bytes * 1000 / us),
+           cycles ? (uint32_t)(bytes * 1000 / cycles) : 0, crc, match);
+}
+
+int bench_crc_run(void)
+{
+    bench_cycles_start();
+
+    // xorshift32, the same data and results on every run
+    uint32_t x = 0x2545f491;
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (uint8_t)x;
+    }
+
+    printk("BENCH {\"config\":{\"crc_slices\":%u,\"rounds\":%u,\"cycles\":\"%s\"}}\n",
+           CONFIG_APP_CRC_SLICES, CONFIG_APP_BENCH_PACKETS, BENCH_CYCLES_SOURCE);
+
+    for (int wide = 0; wide <= 1; wide++) {
+        for (size_t l = 0; l < ARRAY_SIZE(lens); l++) {
+            for (size_t v = 0; v < ARRAY_SIZE(variants); v++) {
+                crc_case(&variants[v], wide, lens[l]);
+            }
+        }
+    }
+
+    bench_cycles_stop();
+
+    printk("BENCH DONE\n");
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "app_framer.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+#define FRAME_LEN CONFIG_APP_FRAMER_MAX_FRAME_LEN
+
+/* spans the framer gets at once: byte by byte, an RX DMA block, a whole burst */
+static const size_t chunks[] = { 1, 64, 1024 };
+
+/* "\r\n" terminated lines of 4 to 63 printable characters */
+static uint8_t lines[4096];
+
+/* what a frame callback saw, FNV-1a over the lengths and the payloads */
+struct crlf_seen {
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t hash;
+};
+
+static void seen_add(struct crlf_seen *seen, const uint8_t *frame, size_t len, bool hash)
+{
+    seen->frames++;
+    seen->bytes += len;
+    if (!hash) {
+        return;
+    }
+    seen->hash = (seen->hash ^ (uint32_t)len) * 16777619u;
+    for (size_t i = 0; i < len; i++) {
+        seen->hash = (seen->hash ^ frame[i]) * 16777619u;
+    }
+}
+
+/* The per-byte state machine main.c had before app_framer, without its logs */
+struct crlf_ref {
+    uint8_t buf[FRAME_LEN];
+    uint32_t len;
+    bool cr;
+    uint32_t overflows;
+    uint32_t errors;
+    struct crlf_seen seen;
+    bool hash;
+};
+
+static void crlf_ref_byte(struct crlf_ref *ref, uint8_t byte)
+{
+    if (ref->len >= sizeof(ref->buf)) {
+        ref->overflows++;
+        ref->len = 0;
+        ref->cr = false;
+        return;
+    }
+
+    ref->buf[ref->len++] = byte;
+
+    if (!ref->cr) {
+        if ('\r' == byte) {
+            ref->cr = true;
+        }
+        return;
+    }
+
+    if ('\n' == byte) {
+        // app_framer hands the frame over without the "\r\n"
+        seen_add(&ref->seen, ref->buf, ref->len - 2, ref->hash);
+    } else {
+        ref->errors++;
+    }
+    ref->len = 0;
+    ref->cr = false;
+}
+
+static void crlf_ref_feed(struct crlf_ref *ref, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crlf_ref_byte(ref, data[i]);
+    }
+}
+
+static struct crlf_ref ref;
+static struct app_framer framer;
+static uint8_t framer_buf[FRAME_LEN];
+static struct crlf_seen framer_seen;
+static bool framer_hash;
+
+static void crlf_frame(struct app_framer *f, uint8_t *frame, size_t len)
+{
+    seen_add(&framer_seen, frame, len, framer_hash);
+}
+
+static void crlf_reset(bool hash)
+{
+    memset(&ref, 0, sizeof(ref));
+    ref.hash = hash;
+    app_framer_init(&framer, framer_buf, sizeof(framer_buf), crlf_frame, NULL);
+    memset(&framer_seen, 0, sizeof(framer_seen));
+    framer_hash = hash;
+}
+
+static void crlf_feed_both(const uint8_t *data, size_t len)
+{
+    crlf_ref_feed(&ref, data, len);
+    app_framer_feed(&framer, data, len);
+}
+
+static bool crlf_same(void)
+{
+    return framer_seen.frames == ref.seen.frames && framer_seen.hash == ref.seen.hash &&
+           framer.stats.overflows == ref.overflows && framer.stats.errors == ref.errors;
+}
+
+/* The contract of the per-byte state machine, in both implementations */
+static void crlf_contract(void)
+{
+    static uint8_t long_line[FRAME_LEN + 1];
+    bool overflow, fits, bare_cr, spans;
+
+    // a byte into the full buffer is dropped and resets the frame
+    crlf_reset(true);
+    memset(long_line, 'a', sizeof(long_line));
+    crlf_feed_both(long_line, sizeof(long_line));
+    crlf_feed_both((const uint8_t *)"ok\r\n", 4);
+    overflow = crlf_same() && framer.stats.overflows == 1 && framer_seen.frames == 1 &&
+               framer_seen.bytes == 2;
+
+    // a line filling the buffer with its "\r\n" still fits
+    crlf_reset(true);
+    memset(long_line, 'b', FRAME_LEN - 2);
+    long_line[FRAME_LEN - 2] = '\r';
+    long_line[FRAME_LEN - 1] = '\n';
+    crlf_feed_both(long_line, FRAME_LEN);
+    fits = crlf_same() && framer.stats.overflows == 0 && framer_seen.frames == 1 &&
+           framer_seen.bytes == FRAME_LEN - 2;
+
+    // '\r' not followed by '\n' resets the frame, and drops that byte
+    crlf_reset(true);
+    crlf_feed_both((const uint8_t *)"ab\rcd\r\n", 7);
+    bare_cr = crlf_same() && framer.stats.errors == 1 && framer_seen.frames == 1 &&
+              framer_seen.bytes == 1;
+
+    // the same frames however the lines are split, "\r" | "\n" included
+    crlf_reset(true);
+    uint32_t x = 0x2545f491;
+
+    for (size_t i = 0; i < sizeof(lines);) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+
+        size_t n = MIN(1 + x % 97, sizeof(lines) - i);
+
+        crlf_feed_both(&lines[i], n);
+        i += n;
+    }
+    spans = crlf_same() && framer.stats.errors == 0 && framer_seen.frames > 0;
+
+    printk("BENCH {\"case\":\"crlf_contract\",\"overflow_reset\":%u,\"full_line_fits\":%u,"
+           "\"bare_cr_reset\":%u,\"random_spans\":%u,\"frames\":%u}\n",
+           overflow, fits, bare_cr, spans, framer_seen.frames);
+}
+
+static uint64_t crlf_run(bool byte_machine, size_t chunk, uint32_t rounds)
+{
+    bench_stamp_t start = bench_stamp();
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < sizeof(lines); i += chunk) {
+            size_t n = MIN(chunk, sizeof(lines) - i);
+
+            if (byte_machine) {
+                crlf_ref_feed(&ref, &lines[i], n);
+            } else {
+                app_framer_feed(&framer, &lines[i], n);
+            }
+        }
+    }
+    return bench_cycles_since(&start);
+}
+
+static void crlf_case(size_t chunk)
+{
+    uint32_t rounds = MAX(CONFIG_APP_BENCH_PACKETS / 10, 1);
+    uint64_t bytes = (uint64_t)rounds * sizeof(lines);
+    uint64_t us[2], cycles[2];
+
+    crlf_reset(false);
+
+    for (int swar = 0; swar <= 1; swar++) {
+        uint64_t start_us = bench_now_us();
+
+        cycles[swar] = crlf_run(!swar, chunk, rounds);
+        us[swar] = MAX(bench_now_us() - start_us, 1);
+    }
+
+    // cycles per byte in hundredths
+    uint32_t cpb[2];
+
+    for (int i = 0; i <= 1; i++) {
+        cpb[i] = (uint32_t)(cycles[i] * 100 / bytes);
+    }
+
+    printk("BENCH {\"case\":\"crlf\",\"chunk\":%u,\"bytes\":%llu,"
+           "\"byte_machine_cycles_per_byte\":%u.%02u,\"framer_cycles_per_byte\":%u.%02u,"
+           "\"byte_machine_kbytes_per_sec\":%u,\"framer_kbytes_per_sec\":%u,"
+           "\"frames_match\":%u}\n",
+           (uint32_t)chunk, (unsigned long long)bytes, cpb[0] / 100, cpb[0] % 100,
+           cpb[1] / 100, cpb[1] % 100, (uint32_t)(bytes * 1000 / us[0]),
+           (uint32_t)(bytes * 1000 / us[1]), framer_seen.frames == ref.seen.frames);
+}
+
+int bench_crlf_run(void)
+{
+    // xorshift32, the same lines on every run
+    uint32_t x = 0x2545f491;
+    size_t i = 0;
+
+    while (i + 2 <= sizeof(lines)) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+
+        size_t n = MIN(4 + x % 60, sizeof(lines) - i - 2);
+
+        for (size_t k = 0; k < n; k++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            lines[i++] = ' ' + x % 95;
+        }
+        lines[i++] = '\r';
+        lines[i++] = '\n';
+    }
+    memset(&lines[i], ' ', sizeof(lines) - i);
+
+    bench_cycles_start();
+
+    printk("BENCH {\"config\":{\"max_frame_len\":%u,\"rounds\":%u,\"cycles\":\"%s\"}}\n",
+           FRAME_LEN, MAX(CONFIG_APP_BENCH_PACKETS / 10, 1), BENCH_CYCLES_SOURCE);
+
+    crlf_contract();
+
+    for (size_t c = 0; c < ARRAY_SIZE(chunks); c++) {
+        crlf_case(chunks[c]);
+    }
+
+    bench_cycles_stop();
+
+    printk("BENCH DONE\n");
+    return 0;
+}
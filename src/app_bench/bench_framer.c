@@ -0,0 +1,299 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "app_framer.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+#define FRAME_LEN CONFIG_APP_FRAMER_MAX_FRAME_LEN
+
+#if defined(CONFIG_APP_FRAMER_COBS)
+#define ENGINE "cobs"
+#elif defined(CONFIG_APP_FRAMER_SLIP)
+#define ENGINE "slip"
+#elif defined(CONFIG_APP_FRAMER_LENPFX)
+#define ENGINE "lenpfx"
+#elif defined(CONFIG_APP_FRAMER_GAP)
+#define ENGINE "gap"
+#else
+#define ENGINE "crlf"
+#endif
+
+#if defined(CONFIG_APP_FRAMER_CRLF)
+/* the "\r\n" goes into the frame buffer too, and no '\r' in the payload */
+#define PAYLOAD_MAX (FRAME_LEN - 2)
+#define TEXT_ONLY   1
+#else
+#define PAYLOAD_MAX FRAME_LEN
+#define TEXT_ONLY   0
+#endif
+
+/* an RX DMA block, the span app_uart reports at most */
+#define RX_CHUNK 64
+
+static const uint16_t payload_sizes[] = { 16, 64, 240 };
+
+static struct app_framer framer;
+static uint8_t framer_buf[FRAME_LEN];
+
+/* the last frame the callback got */
+static struct {
+    uint32_t frames;
+    size_t len;
+    bool too_long;
+    uint8_t frame[FRAME_LEN];
+} got;
+
+static uint8_t payload[PAYLOAD_MAX];
+static uint8_t encoded[APP_FRAMER_MAX_ENCODED_LEN(PAYLOAD_MAX)];
+
+/* encoded frames back to back, and where each one ends */
+static uint8_t stream[4096];
+static uint16_t stream_ends[sizeof(stream) / 16];
+
+/* xorshift32, the same bytes on every run */
+static uint32_t rnd_state = 0x2545f491;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static void rnd_payload(uint8_t *buf, size_t len, bool worst)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (TEXT_ONLY) {
+            buf[i] = ' ' + rnd() % 95;
+        } else if (worst) {
+            // every byte a delimiter or an escape
+            buf[i] = (rnd() & 1) ? 0xC0 : ((rnd() & 1) ? 0xDB : 0x00);
+        } else {
+            buf[i] = (uint8_t)rnd();
+        }
+    }
+}
+
+static void framer_frame(struct app_framer *f, uint8_t *frame, size_t len)
+{
+    got.frames++;
+    if (len > sizeof(got.frame)) {
+        got.too_long = true;
+        return;
+    }
+    got.len = len;
+    memcpy(got.frame, frame, len);
+}
+
+static void got_reset(void)
+{
+    got.frames = 0;
+    got.len = 0;
+}
+
+/* the encoded bytes as app_uart reports them, the line going idle after the last span */
+static void feed_spans(const uint8_t *data, size_t len, bool random)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        size_t n = random ? 1 + rnd() % RX_CHUNK : RX_CHUNK;
+
+        n = MIN(n, len - i);
+
+        if (i + n == len) {
+            app_framer_feed_end(&framer, &data[i], n);
+        } else {
+            app_framer_feed(&framer, &data[i], n);
+        }
+        i += n;
+    }
+}
+
+/* What a receiver does to find the next frame after line noise */
+static void framer_resync(void)
+{
+#if defined(CONFIG_APP_FRAMER_COBS)
+    app_framer_feed(&framer, (const uint8_t *)"\x00", 1);
+#elif defined(CONFIG_APP_FRAMER_SLIP)
+    // END before every frame, as RFC 1055 suggests
+    app_framer_feed(&framer, (const uint8_t *)"\xc0", 1);
+#elif defined(CONFIG_APP_FRAMER_CRLF)
+    // a '\r' on a full buffer is dropped, the second "\r\n" ends the line then
+    app_framer_feed(&framer, (const uint8_t *)"\r\n\r\n", 4);
+#elif defined(CONFIG_APP_FRAMER_GAP)
+    // the line goes idle
+    app_framer_feed_end(&framer, NULL, 0);
+#else
+    // a length field may be noise, no in band boundary to wait for
+    app_framer_reset(&framer);
+#endif
+}
+
+/*
+ * Every payload encodes within APP_FRAMER_MAX_ENCODED_LEN(), not in one
+ * byte less, and decodes to itself however the line splits it. Random
+ * bytes before a frame never hand over more than the buffer, and the
+ * frame after them decodes once the receiver resynchronized.
+ */
+static void framer_fuzz(void)
+{
+    uint32_t frames = CONFIG_APP_BENCH_PACKETS;
+    uint32_t mismatches = 0, enospc_misses = 0, resync_failures = 0;
+    uint32_t garbage_bytes = 0;
+
+    app_framer_init(&framer, framer_buf, sizeof(framer_buf), framer_frame, NULL);
+
+    for (uint32_t n = 0; n < frames; n++) {
+        size_t len = 1 + rnd() % PAYLOAD_MAX;
+        bool garbage = (n % 4) == 3;
+
+        rnd_payload(payload, len, (n % 8) == 5);
+
+        int ret = app_framer_encode(payload, len, encoded, sizeof(encoded));
+
+        if (ret < 0 || ret > APP_FRAMER_MAX_ENCODED_LEN(len)) {
+            mismatches++;
+            continue;
+        }
+        if (app_framer_encode(payload, len, encoded, ret - 1) != -ENOSPC) {
+            enospc_misses++;
+            // the short encode may have written less, encode again
+            (void)app_framer_encode(payload, len, encoded, sizeof(encoded));
+        }
+
+        if (garbage) {
+            static uint8_t noise[FRAME_LEN * 2];
+            size_t noise_len = 1 + rnd() % sizeof(noise);
+
+            for (size_t i = 0; i < noise_len; i++) {
+                noise[i] = (uint8_t)rnd();
+            }
+            feed_spans(noise, noise_len, true);
+            framer_resync();
+            garbage_bytes += noise_len;
+        }
+
+        got_reset();
+        feed_spans(encoded, ret, true);
+
+        bool same = got.frames == 1 && got.len == len && memcmp(got.frame, payload, len) == 0;
+
+        if (!same) {
+            if (garbage) {
+                resync_failures++;
+            } else {
+                mismatches++;
+            }
+            framer_resync();
+        }
+    }
+
+    printk("BENCH {\"case\":\"framer_fuzz\",\"frames\":%u,\"mismatches\":%u,"
+           "\"enospc_misses\":%u,\"resync_failures\":%u,\"garbage_bytes\":%u,"
+           "\"too_long\":%u,\"errors\":%u,\"overflows\":%u}\n",
+           frames, mismatches, enospc_misses, resync_failures, garbage_bytes, got.too_long,
+           framer.stats.errors, framer.stats.overflows);
+}
+
+/* Frames of len random bytes into stream, returns how many fit */
+static size_t stream_fill(size_t len, size_t *bytes)
+{
+    size_t count = 0;
+    size_t o = 0;
+
+    while (count < ARRAY_SIZE(stream_ends)) {
+        rnd_payload(payload, len, false);
+
+        int ret = app_framer_encode(payload, len, &stream[o], sizeof(stream) - o);
+
+        if (ret < 0) {
+            break;
+        }
+        o += ret;
+        stream_ends[count++] = o;
+    }
+    *bytes = o;
+    return count;
+}
+
+static void framer_case(size_t len)
+{
+    uint32_t rounds = MAX(CONFIG_APP_BENCH_PACKETS / 10, 1);
+    size_t stream_bytes;
+    size_t count = stream_fill(len, &stream_bytes);
+    uint64_t payload_bytes = (uint64_t)rounds * count * len;
+    uint64_t cycles[2], us[2];
+    uint64_t start_us;
+    bench_stamp_t start;
+
+    if (count == 0) {
+        return;
+    }
+
+    // encode the last payload of the stream over and over
+    start_us = bench_now_us();
+    start = bench_stamp();
+    for (uint32_t r = 0; r < rounds * count; r++) {
+        (void)app_framer_encode(payload, len, encoded, sizeof(encoded));
+    }
+    cycles[0] = bench_cycles_since(&start);
+    us[0] = MAX(bench_now_us() - start_us, 1);
+
+    // decode the stream in RX DMA blocks, the line idle after every frame
+    app_framer_init(&framer, framer_buf, sizeof(framer_buf), framer_frame, NULL);
+    got_reset();
+    start_us = bench_now_us();
+    start = bench_stamp();
+    for (uint32_t r = 0; r < rounds; r++) {
+        size_t from = 0;
+
+        for (size_t f = 0; f < count; f++) {
+            feed_spans(&stream[from], stream_ends[f] - from, false);
+            from = stream_ends[f];
+        }
+    }
+    cycles[1] = bench_cycles_since(&start);
+    us[1] = MAX(bench_now_us() - start_us, 1);
+
+    // per payload byte, in hundredths
+    uint32_t cpb[2];
+
+    for (int i = 0; i <= 1; i++) {
+        cpb[i] = (uint32_t)(cycles[i] * 100 / payload_bytes);
+    }
+    uint32_t overhead = (uint32_t)(((uint64_t)stream_bytes - count * len) * 10000 / (count * len));
+
+    printk("BENCH {\"case\":\"framer\",\"size\":%u,\"frames\":%u,\"overhead_pct\":%u.%02u,"
+           "\"encode_cycles_per_byte\":%u.%02u,\"decode_cycles_per_byte\":%u.%02u,"
+           "\"encode_kbytes_per_sec\":%u,\"decode_kbytes_per_sec\":%u,\"frames_match\":%u}\n",
+           (uint32_t)len, (uint32_t)(rounds * count), overhead / 100, overhead % 100,
+           cpb[0] / 100, cpb[0] % 100, cpb[1] / 100, cpb[1] % 100,
+           (uint32_t)(payload_bytes * 1000 / us[0]), (uint32_t)(payload_bytes * 1000 / us[1]),
+           got.frames == rounds * count && framer.stats.errors == 0);
+}
+
+int bench_framer_run(void)
+{
+    bench_cycles_start();
+
+    printk("BENCH {\"config\":{\"engine\":\"%s\",\"max_frame_len\":%u,\"cycles\":\"%s\"}}\n",
+           ENGINE, FRAME_LEN, BENCH_CYCLES_SOURCE);
+
+    framer_fuzz();
+
+    for (size_t s = 0; s < ARRAY_SIZE(payload_sizes); s++) {
+        framer_case(MIN(payload_sizes[s], PAYLOAD_MAX));
+    }
+
+    bench_cycles_stop();
+
+    printk("BENCH DONE\n");
+    return 0;
+}
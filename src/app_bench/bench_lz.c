@@ -0,0 +1,246 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "lz_codec.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+#define CORPUS_LEN 16384
+#define ROUNDS 20
+
+/* 115200 baud, 8N1 */
+#define LINE_BYTES_PER_SEC 11520
+
+/* frame header of app_lz */
+#define FRAME_HDR_LEN 2
+
+/* packed blocks: | length (16 bit LE) | flags | block | */
+#define PACK_HDR_LEN 3
+#define PACK_STORED BIT(0)
+#define PACK_RESET BIT(1)
+
+enum corpus_kind { CORPUS_LOG, CORPUS_TELEMETRY, CORPUS_RANDOM };
+
+struct lz_case {
+    const char *name;
+    enum corpus_kind corpus;
+    bool batch;     // frames of CONFIG_APP_LZ_MAX_PAYLOAD bytes instead of one per line
+};
+
+static const struct lz_case cases[] = {
+    { "lz_log_line", CORPUS_LOG, false },
+    { "lz_log_batch", CORPUS_LOG, true },
+    { "lz_telemetry_line", CORPUS_TELEMETRY, false },
+    { "lz_telemetry_batch", CORPUS_TELEMETRY, true },
+    { "lz_random_line", CORPUS_RANDOM, false },
+};
+
+static uint8_t corpus[CORPUS_LEN];
+static uint16_t line_len[CORPUS_LEN / 16];
+static size_t lines;
+static uint8_t packed[CORPUS_LEN + CORPUS_LEN / 4];
+
+static struct lz_encoder enc;
+static struct lz_decoder dec;
+
+static uint32_t rng = 0x2545f491;
+
+static uint32_t bench_rand(void)
+{
+    // xorshift32, the same corpus on every run
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static const char *const modules[] = { "app_uart", "app_framer", "app_mux", "app_arq" };
+static const char *const levels[] = { "inf", "wrn", "err", "dbg" };
+
+static size_t corpus_line(enum corpus_kind kind, uint32_t i, char *line, size_t size)
+{
+    uint32_t r = bench_rand();
+
+    switch (kind) {
+    case CORPUS_LOG:
+        return snprintk(line, size, "[%08u] <%s> %s: uart@%x rx %u bytes, %u dropped\n",
+                        i * 37 + (r & 0x1F), levels[r % 4], modules[(r >> 2) % 4],
+                        0x40002000 + ((r >> 4) % 4) * 0x1000, (r >> 8) % 256, (r >> 16) % 3);
+    case CORPUS_TELEMETRY:
+        return snprintk(line, size,
+                        "{\"t\":%u,\"temp\":%u.%u,\"hum\":%u,\"bat\":%u,\"rssi\":-%u}\n",
+                        1000 + i, 21 + (r % 3), (r >> 2) % 10, 40 + (r >> 6) % 5,
+                        3700 - i / 16, 60 + (r >> 10) % 8);
+    case CORPUS_RANDOM:
+    default:
+        for (size_t b = 0; b < 48; b++) {
+            line[b] = (char)bench_rand();
+        }
+        return 48;
+    }
+}
+
+static void corpus_fill(enum corpus_kind kind)
+{
+    char line[96];
+    size_t pos = 0;
+
+    lines = 0;
+    while (lines < ARRAY_SIZE(line_len)) {
+        size_t len = corpus_line(kind, lines, line, sizeof(line));
+
+        if (pos + len > sizeof(corpus)) {
+            break;
+        }
+        memcpy(&corpus[pos], line, len);
+        line_len[lines++] = len;
+        pos += len;
+    }
+}
+
+/* Compresses the corpus as app_lz does, into packed. Returns the packed length. */
+static size_t lz_pack(bool batch, uint32_t *frames, uint32_t *stored)
+{
+    uint32_t since_reset = CONFIG_APP_LZ_RESET_INTERVAL;
+    size_t pos = 0;
+    size_t out = 0;
+
+    *frames = 0;
+    *stored = 0;
+    lz_encoder_init(&enc);
+
+    for (size_t l = 0; l <= lines; l++) {
+        const uint8_t *data = &corpus[pos];
+        size_t len = (l < lines) ? line_len[l] : 0;
+
+        pos += len;
+        do {
+            size_t n = lz_encoder_write(&enc, data, len);
+
+            data += n;
+            len -= n;
+
+            size_t pending = lz_encoder_pending(&enc);
+            bool flush = (l == lines) || (!batch && len == 0);
+
+            if (pending == 0 || (pending < CONFIG_APP_LZ_MAX_PAYLOAD && !flush)) {
+                continue;
+            }
+
+            uint8_t flags = 0;
+            bool raw;
+
+            if (since_reset >= CONFIG_APP_LZ_RESET_INTERVAL) {
+                lz_encoder_reset(&enc);
+                since_reset = 0;
+                flags |= PACK_RESET;
+            }
+            since_reset++;
+
+            int blen = lz_compress(&enc, &packed[out + PACK_HDR_LEN],
+                                   sizeof(packed) - out - PACK_HDR_LEN, &raw);
+
+            if (blen < 0) {
+                LOG_ERR("Failed to compress: %d", blen);
+                return out;
+            }
+            flags |= raw ? PACK_STORED : 0;
+            sys_put_le16(blen, &packed[out]);
+            packed[out + 2] = flags;
+            out += PACK_HDR_LEN + blen;
+            *frames += 1;
+            *stored += raw;
+        } while (len > 0);
+    }
+    return out;
+}
+
+/* Decompresses packed, and compares it with the corpus if check is set */
+static bool lz_unpack(size_t packed_len, bool check)
+{
+    size_t pos = 0;
+
+    lz_decoder_init(&dec);
+
+    for (size_t in = 0; in < packed_len;) {
+        size_t blen = sys_get_le16(&packed[in]);
+        uint8_t flags = packed[in + 2];
+        const uint8_t *data;
+
+        if (flags & PACK_RESET) {
+            lz_decoder_reset(&dec);
+        }
+
+        int n = lz_decompress(&dec, &packed[in + PACK_HDR_LEN], blen, flags & PACK_STORED,
+                              &data);
+
+        if (n < 0) {
+            return false;
+        }
+        if (check && (pos + n > sizeof(corpus) || memcmp(&corpus[pos], data, n) != 0)) {
+            return false;
+        }
+        pos += n;
+        in += PACK_HDR_LEN + blen;
+    }
+    return true;
+}
+
+static void lz_case(const struct lz_case *lc)
+{
+    uint32_t frames = 0, stored = 0;
+    size_t packed_len = 0;
+    size_t in_len = 0;
+
+    corpus_fill(lc->corpus);
+    for (size_t l = 0; l < lines; l++) {
+        in_len += line_len[l];
+    }
+
+    uint64_t start = bench_now_us();
+
+    for (int r = 0; r < ROUNDS; r++) {
+        packed_len = lz_pack(lc->batch, &frames, &stored);
+    }
+
+    uint64_t pack_us = MAX(bench_now_us() - start, 1);
+
+    start = bench_now_us();
+    for (int r = 0; r < ROUNDS; r++) {
+        (void)lz_unpack(packed_len, false);
+    }
+
+    uint64_t unpack_us = MAX(bench_now_us() - start, 1);
+    bool match = lz_unpack(packed_len, true);
+
+    // what goes into the framer: the blocks and the app_lz header of every frame
+    size_t wire = packed_len - frames * PACK_HDR_LEN + frames * FRAME_HDR_LEN;
+    uint64_t total = (uint64_t)in_len * ROUNDS;
+
+    printk("BENCH {\"case\":\"%s\",\"in_bytes\":%u,\"out_bytes\":%u,\"frames\":%u,"
+           "\"stored\":%u,\"ratio_permille\":%u,\"compress_kbytes_per_sec\":%u,"
+           "\"decompress_kbytes_per_sec\":%u,\"bytes_per_sec_at_115200\":%u,\"match\":%u}\n",
+           lc->name, (uint32_t)in_len, (uint32_t)wire, frames, stored,
+           (uint32_t)(wire * 1000 / MAX(in_len, 1)),
+           (uint32_t)(total * 1000 / pack_us), (uint32_t)(total * 1000 / unpack_us),
+           (uint32_t)((uint64_t)LINE_BYTES_PER_SEC * in_len / MAX(wire, 1)), match);
+}
+
+int bench_lz_run(void)
+{
+    printk("BENCH {\"config\":{\"lz_window\":%u,\"lz_max_payload\":%u,\"lz_hash_bits\":%u,"
+           "\"lz_reset_interval\":%u,\"corpus_bytes\":%u,\"rounds\":%u}}\n",
+           CONFIG_APP_LZ_WINDOW, CONFIG_APP_LZ_MAX_PAYLOAD, CONFIG_APP_LZ_HASH_BITS,
+           CONFIG_APP_LZ_RESET_INTERVAL, CORPUS_LEN, ROUNDS);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        lz_case(&cases[i]);
+    }
+
+    printk("BENCH DONE\n");
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "app_framer.h"
+#include "app_mux.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+enum { CH_CMD, CH_BULK, CH_BULK2, CH_COUNT };
+
+BUILD_ASSERT(CONFIG_APP_MUX_CHANNELS >= CH_COUNT, "The multiplexer cases need 3 channels");
+
+#define CASE_MS 2000
+#define CMD_PERIOD K_MSEC(10)
+#define CMD_SAMPLES (CASE_MS / 10)
+#define DRAIN_MS 500
+
+/* command: | send time in us (32 bit) | */
+#define CMD_LEN 4
+
+struct mux_case {
+    const char *name;
+    uint8_t cmd_priority;
+    uint8_t bulk2_weight;
+};
+
+static const struct mux_case cases[] = {
+    { "mux_fair", 1, 1 },       // the commands wait their turn among the bulk frames
+    { "mux_priority", 0, 1 },   // the commands go first
+    { "mux_weighted", 0, 3 },   // and the second bulk channel gets 3 times the first one's share
+};
+
+static struct {
+    struct app_uart *uart;
+    struct app_framer framer;
+    uint8_t frame_buf[CONFIG_APP_FRAMER_MAX_FRAME_LEN];
+    atomic_t cmd_sent;
+    atomic_t cmd_rx;
+    uint32_t cmd_lat_us[CMD_SAMPLES];
+    atomic_t bulk_bytes[CH_COUNT];
+} mb;
+
+static uint8_t bulk_payload[CONFIG_APP_MUX_MAX_PAYLOAD];
+
+static void cmd_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(cmd_work, cmd_handler);
+
+static void mux_bench_frame(struct app_framer *framer, uint8_t *frame, size_t len)
+{
+    (void)app_mux_frame(mb.uart, frame, len);
+}
+
+static void mux_bench_rx(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    if (app_uart_rx_frame_end(uart)) {
+        app_framer_feed_end(&mb.framer, byte, len);
+    } else {
+        app_framer_feed(&mb.framer, byte, len);
+    }
+}
+
+static void cmd_rx(uint8_t ch, const uint8_t *data, size_t len, void *user_data)
+{
+    if (len != CMD_LEN) {
+        return;
+    }
+
+    atomic_val_t idx = atomic_inc(&mb.cmd_rx);
+
+    if (idx < ARRAY_SIZE(mb.cmd_lat_us)) {
+        mb.cmd_lat_us[idx] = (uint32_t)bench_now_us() - sys_get_le32(data);
+    }
+}
+
+static void bulk_rx(uint8_t ch, const uint8_t *data, size_t len, void *user_data)
+{
+    atomic_add(&mb.bulk_bytes[ch], len);
+}
+
+static void cmd_handler(struct k_work *work)
+{
+    uint8_t cmd[CMD_LEN];
+
+    sys_put_le32((uint32_t)bench_now_us(), cmd);
+    if (app_mux_send(CH_CMD, cmd, sizeof(cmd), K_NO_WAIT) == 0) {
+        atomic_inc(&mb.cmd_sent);
+    }
+    k_work_reschedule(&cmd_work, CMD_PERIOD);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static int mux_case_open(const struct mux_case *mc)
+{
+    const struct app_mux_chan_cfg cfgs[CH_COUNT] = {
+        [CH_CMD] = { .priority = mc->cmd_priority, .weight = 1, .cb = cmd_rx },
+        [CH_BULK] = { .priority = 1, .weight = 1, .cb = bulk_rx },
+        [CH_BULK2] = { .priority = 1, .weight = mc->bulk2_weight, .cb = bulk_rx },
+    };
+
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++) {
+        int err = app_mux_open(ch, &cfgs[ch]);
+
+        if (err) {
+            return err;
+        }
+    }
+    return 0;
+}
+
+static void mux_case(const struct mux_case *mc)
+{
+    struct app_mux_chan_stats cmd_stats;
+    uint32_t stalls = 0, lost = 0;
+    int64_t end;
+
+    if (mux_case_open(mc)) {
+        LOG_ERR("Failed to open the channels of %s", mc->name);
+        return;
+    }
+
+    app_mux_stats_reset();
+    atomic_clear(&mb.cmd_sent);
+    atomic_clear(&mb.cmd_rx);
+    for (size_t ch = 0; ch < CH_COUNT; ch++) {
+        atomic_clear(&mb.bulk_bytes[ch]);
+    }
+
+    k_work_reschedule(&cmd_work, K_NO_WAIT);
+
+    // keep both bulk channels full
+    end = k_uptime_get() + CASE_MS;
+    while (k_uptime_get() < end) {
+        while (app_mux_send(CH_BULK, bulk_payload, sizeof(bulk_payload), K_NO_WAIT) == 0) {
+        }
+        while (app_mux_send(CH_BULK2, bulk_payload, sizeof(bulk_payload), K_NO_WAIT) == 0) {
+        }
+        k_sleep(K_TICKS(1));
+    }
+
+    // bytes of the case only, the tail doesn't count
+    uint32_t bulk = atomic_get(&mb.bulk_bytes[CH_BULK]);
+    uint32_t bulk2 = atomic_get(&mb.bulk_bytes[CH_BULK2]);
+
+    struct k_work_sync sync;
+
+    k_work_cancel_delayable_sync(&cmd_work, &sync);
+    k_sleep(K_MSEC(DRAIN_MS));
+
+    (void)app_mux_stats_get(CH_CMD, &cmd_stats);
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++) {
+        struct app_mux_chan_stats st;
+
+        (void)app_mux_stats_get(ch, &st);
+        stalls += st.credit_stalls;
+        lost += st.rx_lost;
+    }
+
+    size_t n = MIN((size_t)atomic_get(&mb.cmd_rx), ARRAY_SIZE(mb.cmd_lat_us));
+    uint32_t p50 = 0, p99 = 0, max = 0;
+
+    if (n > 0) {
+        qsort(mb.cmd_lat_us, n, sizeof(mb.cmd_lat_us[0]), cmp_u32);
+        p50 = mb.cmd_lat_us[n / 2];
+        p99 = mb.cmd_lat_us[(n * 99) / 100];
+        max = mb.cmd_lat_us[n - 1];
+    }
+
+    printk("BENCH {\"case\":\"%s\",\"cmd_sent\":%u,\"cmd_received\":%u,"
+           "\"cmd_p50_us\":%u,\"cmd_p99_us\":%u,\"cmd_max_us\":%u,\"cmd_queue_max_us\":%u,"
+           "\"bulk_bytes\":%u,\"bulk2_bytes\":%u,\"bulk2_weight\":%u,\"bytes_per_sec\":%u,"
+           "\"credit_stalls\":%u,\"rx_lost\":%u}\n",
+           mc->name, (uint32_t)atomic_get(&mb.cmd_sent), (uint32_t)atomic_get(&mb.cmd_rx),
+           p50, p99, max, cmd_stats.lat_max_us,
+           bulk, bulk2, mc->bulk2_weight, (uint32_t)((uint64_t)(bulk + bulk2) * 1000 / CASE_MS),
+           stalls, lost);
+}
+
+int bench_mux_run(void)
+{
+    int err;
+
+    mb.uart = app_uart_get(APP_UART_DEFAULT_NODE);
+    app_framer_init(&mb.framer, mb.frame_buf, sizeof(mb.frame_buf), mux_bench_frame, NULL);
+
+    for (size_t i = 0; i < sizeof(bulk_payload); i++) {
+        bulk_payload[i] = (uint8_t)i;
+    }
+
+    err = app_mux_attach(mb.uart);
+    if (err) {
+        LOG_ERR("Failed to attach the multiplexer: %d", err);
+        return err;
+    }
+
+    err = app_uart_rx_cb_register(mb.uart, mux_bench_rx);
+    if (err) {
+        LOG_ERR("Failed to register RX callback: %d", err);
+        return err;
+    }
+
+    printk("BENCH {\"config\":{\"channels\":%u,\"max_payload\":%u,\"window\":%u,\"quantum\":%u,"
+           "\"tx_depth\":%u,\"tx_buf_size\":%u,\"cmd_period_ms\":10,\"case_ms\":%u}}\n",
+           CONFIG_APP_MUX_CHANNELS, CONFIG_APP_MUX_MAX_PAYLOAD, CONFIG_APP_MUX_WINDOW,
+           CONFIG_APP_MUX_QUANTUM, CONFIG_APP_MUX_TX_DEPTH,
+           (uint32_t)app_uart_tx_buf_size(mb.uart), CASE_MS);
+
+    for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        mux_case(&cases[i]);
+    }
+
+    printk("BENCH DONE\n");
+    return 0;
+}
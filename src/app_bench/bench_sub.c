@@ -0,0 +1,204 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+#define TX_DONE_TIMEOUT K_MSEC(100)
+#define PACKET_SIZE     240
+#define SUB_DEPTH       2
+#define CONSUMER_STACK  1024
+#define CONSUMER_PRIO   7
+
+/* how long the slow subscriber works on each view it gets */
+#define SLOW_VIEW_MS 1
+
+static const uint8_t sub_counts[] = { 0, 1, 2, 4 };
+
+static struct {
+    struct app_uart *uart;
+    atomic_t rx_bytes;
+    uint64_t last_rx_us;
+    uint32_t tx_errors;
+} sb;
+
+static K_SEM_DEFINE(tx_done, 0, 1);
+
+static uint8_t tx_packet[PACKET_SIZE];
+
+static void sub_consumer(void *p1, void *p2, void *p3)
+{
+    struct app_uart_rx_sub *sub = p1;
+    bool slow = (bool)(uintptr_t)p2;
+    struct app_uart_rx_view view;
+
+    while (true) {
+        if (app_uart_rx_sub_get(sub, &view, K_FOREVER)) {
+            continue;
+        }
+        if (slow) {
+            k_msleep(SLOW_VIEW_MS);
+        }
+        app_uart_rx_view_release(&view);
+    }
+}
+
+/* A subscriber and the thread consuming its views */
+#define BENCH_SUB_DEFINE(_name, _slow)                                                     \
+    APP_UART_RX_SUB_DEFINE(_name, SUB_DEPTH, APP_UART_RX_SUB_DROP_OLDEST);                 \
+    K_THREAD_DEFINE(_name##_id, CONSUMER_STACK, sub_consumer, &_name, (void *)(_slow),     \
+                    NULL, CONSUMER_PRIO, 0, 0)
+
+BENCH_SUB_DEFINE(sub_a, false);
+BENCH_SUB_DEFINE(sub_b, false);
+BENCH_SUB_DEFINE(sub_c, false);
+/* subscribed last, only in the 4 subscriber cases */
+BENCH_SUB_DEFINE(sub_slow, true);
+
+static struct app_uart_rx_sub *const subs[] = { &sub_a, &sub_b, &sub_c, &sub_slow };
+
+BUILD_ASSERT(ARRAY_SIZE(subs) <= CONFIG_APP_UART_RX_SUBSCRIBERS_MAX,
+             "every subscriber of the bench must fit on the port");
+
+/* the RX context, before the subscribers get the view */
+static void sub_bench_rx(const struct app_uart_rx_view *view)
+{
+    atomic_add(&sb.rx_bytes, view->len);
+    sb.last_rx_us = bench_now_us();
+}
+
+/* from the UART ISR */
+static void sub_bench_tx_done(struct app_uart *uart)
+{
+    k_sem_give(&tx_done);
+}
+
+static void sub_send(void)
+{
+    for (uint32_t i = 0; i < CONFIG_APP_BENCH_PACKETS; i++) {
+        int err;
+
+        while ((err = app_uart_tx(sb.uart, tx_packet, sizeof(tx_packet))) == -ENOMEM) {
+            (void)k_sem_take(&tx_done, TX_DONE_TIMEOUT);
+        }
+        if (err) {
+            sb.tx_errors++;
+        }
+    }
+}
+
+static void sub_unsubscribe(size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        (void)app_uart_rx_unsubscribe(subs[i]);
+    }
+}
+
+static int sub_case(enum app_uart_rx_sub_policy policy, size_t count)
+{
+    struct app_uart_rx_block_stats blocks;
+    uint32_t delivered = 0, dropped = 0, slow_dropped = 0;
+    uint32_t idle_used;
+    int err;
+
+    // the blocks the driver holds between cases
+    app_uart_rx_block_stats_get(sb.uart, &blocks);
+    idle_used = blocks.used;
+
+    for (size_t i = 0; i < count; i++) {
+        subs[i]->policy = policy;
+        err = app_uart_rx_subscribe(sb.uart, subs[i], NULL, NULL);
+        if (err) {
+            LOG_ERR("Failed to subscribe %s: %d", subs[i]->name, err);
+            sub_unsubscribe(i);
+            return err;
+        }
+    }
+
+    atomic_set(&sb.rx_bytes, 0);
+    sb.tx_errors = 0;
+    sb.last_rx_us = bench_now_us();
+    app_uart_rx_block_stats_reset(sb.uart);
+
+    sub_send();
+
+    uint32_t sent = (CONFIG_APP_BENCH_PACKETS - sb.tx_errors) * sizeof(tx_packet);
+
+    while ((uint32_t)atomic_get(&sb.rx_bytes) < sent &&
+           bench_now_us() - sb.last_rx_us < CONFIG_APP_BENCH_IDLE_TIMEOUT_MS * 1000ULL) {
+        k_msleep(1);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        struct app_uart_rx_sub_stats stats;
+
+        if (app_uart_rx_sub_stats_get(sb.uart, i, &stats) == 0) {
+            delivered += stats.delivered;
+            dropped += stats.dropped;
+            if (subs[i] == &sub_slow) {
+                slow_dropped = stats.dropped;
+            }
+        }
+    }
+    app_uart_rx_block_stats_get(sb.uart, &blocks);
+
+    uint32_t rx_bytes = atomic_get(&sb.rx_bytes);
+    uint32_t blocks_peak = blocks.high_watermark;
+
+    sub_unsubscribe(count);
+
+    // the consumers release the views they work on
+    k_msleep(10 * SLOW_VIEW_MS + 10);
+    app_uart_rx_block_stats_get(sb.uart, &blocks);
+
+    printk("BENCH {\"case\":\"rx_sub\",\"policy\":\"%s\",\"subscribers\":%u,"
+           "\"rx_blocks\":%u,\"rx_block_size\":%u,\"blocks_peak\":%u,"
+           "\"sent_bytes\":%u,\"rx_bytes\":%u,\"rx_lost\":%u,\"delivered\":%u,"
+           "\"dropped\":%u,\"slow_dropped\":%u,\"blocks_leaked\":%d}\n",
+           policy == APP_UART_RX_SUB_BLOCK ? "block" : "drop_oldest", (uint32_t)count,
+           blocks.block_num, blocks.block_size, blocks_peak, sent, rx_bytes,
+           sent > rx_bytes ? sent - rx_bytes : 0, delivered, dropped, slow_dropped,
+           (int32_t)(blocks.used - idle_used));
+    return 0;
+}
+
+int bench_sub_run(void)
+{
+    static const enum app_uart_rx_sub_policy policies[] = {
+        APP_UART_RX_SUB_DROP_OLDEST,
+        APP_UART_RX_SUB_BLOCK,
+    };
+    int err;
+
+    sb.uart = app_uart_get(APP_UART_DEFAULT_NODE);
+
+    for (size_t i = 0; i < sizeof(tx_packet); i++) {
+        tx_packet[i] = (uint8_t)i;
+    }
+
+    err = app_uart_rx_view_cb_register(sb.uart, sub_bench_rx);
+    if (err) {
+        LOG_ERR("Failed to register RX view callback: %d", err);
+        return err;
+    }
+    (void)app_uart_tx_done_cb_register(sb.uart, sub_bench_tx_done);
+
+    printk("BENCH {\"config\":{\"packets\":%u,\"packet_size\":%u,\"sub_depth\":%u,"
+           "\"slow_view_ms\":%u,\"block_timeout_ms\":%u}}\n",
+           CONFIG_APP_BENCH_PACKETS, PACKET_SIZE, SUB_DEPTH, SLOW_VIEW_MS,
+           CONFIG_APP_UART_RX_SUB_BLOCK_TIMEOUT_MS);
+
+    for (size_t p = 0; p < ARRAY_SIZE(policies) && !err; p++) {
+        for (size_t c = 0; c < ARRAY_SIZE(sub_counts) && !err; c++) {
+            err = sub_case(policies[p], MIN(sub_counts[c], ARRAY_SIZE(subs)));
+        }
+    }
+
+    (void)app_uart_tx_done_cb_register(sb.uart, NULL);
+
+    printk("BENCH DONE\n");
+    return err;
+}
@@ -0,0 +1,124 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "app_bench.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_bench, CONFIG_APP_BENCH_LOG_LEVEL);
+
+#define TX_DONE_TIMEOUT K_MSEC(100)
+
+static const uint16_t packet_sizes[] = { 8, 32, 128, 240 };
+
+static struct {
+    struct app_uart *uart;
+    atomic_t rx_bytes;
+    uint32_t tx_errors;
+} tb;
+
+static K_SEM_DEFINE(tx_done, 0, 1);
+
+static uint8_t tx_packet[240];
+
+static void tx_bench_rx(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    // only keeps the loopback drained
+    atomic_add(&tb.rx_bytes, len);
+}
+
+/* from the UART ISR */
+static void tx_bench_done(struct app_uart *uart)
+{
+    k_sem_give(&tx_done);
+}
+
+/* What the TX thread did before the staging buffers: one transfer per
+ * packet, the next one only after its UART_TX_DONE.
+ */
+static void tx_per_packet(uint16_t size)
+{
+    for (uint32_t i = 0; i < CONFIG_APP_BENCH_PACKETS; i++) {
+        k_sem_reset(&tx_done);
+        if (app_uart_tx(tb.uart, tx_packet, size)) {
+            tb.tx_errors++;
+            continue;
+        }
+        (void)k_sem_take(&tx_done, TX_DONE_TIMEOUT);
+    }
+}
+
+/* Back to back, packed into the staging buffer while the other one is on the wire */
+static void tx_pipelined(uint16_t size)
+{
+    for (uint32_t i = 0; i < CONFIG_APP_BENCH_PACKETS; i++) {
+        int err;
+
+        while ((err = app_uart_tx(tb.uart, tx_packet, size)) == -ENOMEM) {
+            (void)k_sem_take(&tx_done, TX_DONE_TIMEOUT);
+        }
+        if (err) {
+            tb.tx_errors++;
+        }
+    }
+}
+
+static uint32_t tx_case(void (*send)(uint16_t size), uint16_t size)
+{
+    uint64_t start = bench_now_us();
+
+    send(size);
+
+    // the last staging buffer is on the wire
+    while (app_uart_tx_drain(tb.uart, K_NO_WAIT)) {
+        (void)k_sem_take(&tx_done, TX_DONE_TIMEOUT);
+    }
+
+    uint64_t us = MAX(bench_now_us() - start, 1);
+
+    return (uint32_t)((uint64_t)CONFIG_APP_BENCH_PACKETS * size * 1000000ULL / us);
+}
+
+int bench_tx_run(void)
+{
+    int err;
+
+    tb.uart = app_uart_get(APP_UART_DEFAULT_NODE);
+
+    for (size_t i = 0; i < sizeof(tx_packet); i++) {
+        tx_packet[i] = (uint8_t)i;
+    }
+
+    err = app_uart_rx_cb_register(tb.uart, tx_bench_rx);
+    if (err) {
+        LOG_ERR("Failed to register RX callback: %d", err);
+        return err;
+    }
+    (void)app_uart_tx_done_cb_register(tb.uart, tx_bench_done);
+
+    // 10 bits per byte on the wire
+    uint32_t line = app_uart_baudrate(tb.uart) / 10;
+
+    printk("BENCH {\"config\":{\"tx_buf_size\":%u,\"packets\":%u,\"line_bytes_per_sec\":%u}}\n",
+           (uint32_t)app_uart_tx_buf_size(tb.uart), CONFIG_APP_BENCH_PACKETS, line);
+
+    for (size_t s = 0; s < ARRAY_SIZE(packet_sizes); s++) {
+        uint16_t size = MIN(packet_sizes[s], app_uart_tx_buf_size(tb.uart));
+
+        tb.tx_errors = 0;
+        uint32_t per_packet = tx_case(tx_per_packet, size);
+        uint32_t pipelined = tx_case(tx_pipelined, size);
+
+        printk("BENCH {\"case\":\"tx\",\"size\":%u,\"per_packet_bytes_per_sec\":%u,"
+               "\"pipelined_bytes_per_sec\":%u,\"gain_pct\":%d,\"line_use_pct\":%u,"
+               "\"tx_errors\":%u}\n",
+               size, per_packet, pipelined,
+               per_packet ? (int32_t)(((int64_t)pipelined - per_packet) * 100 / per_packet) : 0,
+               line ? (uint32_t)((uint64_t)pipelined * 100 / line) : 0, tb.tx_errors);
+    }
+
+    (void)app_uart_tx_done_cb_register(tb.uart, NULL);
+
+    printk("BENCH DONE\n");
+    return 0;
+}
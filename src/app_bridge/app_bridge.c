@@ -0,0 +1,183 @@
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app_bridge.h"
+#include "app_uart.h"
+#include "spsc_ring.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_bridge, CONFIG_APP_BRIDGE_LOG_LEVEL);
+
+#define BRIDGE_USB_NODE DT_ALIAS(my_usb_serial)
+#define BRIDGE_UART_NODE DT_ALIAS(learning_serial)
+
+#define BRIDGE_USB app_uart_get(BRIDGE_USB_NODE)
+#define BRIDGE_UART app_uart_get(BRIDGE_UART_NODE)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_APP_BRIDGE_BUF_SIZE),
+             "CONFIG_APP_BRIDGE_BUF_SIZE must be a power of two");
+
+static struct {
+    atomic_t bytes;
+    atomic_t dropped;
+    atomic_t waits;
+} dirs[APP_BRIDGE_DIR_COUNT];
+
+/* One ring per direction, the RX callback of one port produces and the
+ * bridge thread consumes into the TX staging buffer of the other one.
+ */
+static uint8_t ring_bufs[APP_BRIDGE_DIR_COUNT][CONFIG_APP_BRIDGE_BUF_SIZE];
+static struct spsc_ring rings[APP_BRIDGE_DIR_COUNT] = {
+    [APP_BRIDGE_USB_TO_UART] = { .buf = ring_bufs[APP_BRIDGE_USB_TO_UART],
+                                 .size = CONFIG_APP_BRIDGE_BUF_SIZE },
+    [APP_BRIDGE_UART_TO_USB] = { .buf = ring_bufs[APP_BRIDGE_UART_TO_USB],
+                                 .size = CONFIG_APP_BRIDGE_BUF_SIZE },
+};
+
+static K_SEM_DEFINE(kick, 0, 1);    // data queued or TX done
+
+static int64_t reset_ms;
+
+/* In the RX context, which must not wait for the other side: what doesn't
+ * fit in the ring is dropped and counted.
+ */
+static void bridge_queue(enum app_bridge_dir dir, const uint8_t *data, size_t len)
+{
+    if (spsc_ring_put(&rings[dir], data, len)) {
+        atomic_add(&dirs[dir].dropped, len);
+    }
+    k_sem_give(&kick);
+}
+
+/* Moves what the TX staging buffer of the other side takes, false once it is full */
+static bool bridge_forward(enum app_bridge_dir dir, struct app_uart *to)
+{
+    size_t max = app_uart_tx_buf_size(to);
+    uint8_t *data;
+    uint32_t len;
+
+    while ((len = spsc_ring_peek(&rings[dir], &data)) > 0) {
+        size_t chunk = MIN(len, max);
+        int err = app_uart_tx(to, data, chunk);
+
+        if (err == -ENOMEM) {
+            // the other side is slower, the ring fills meanwhile
+            atomic_inc(&dirs[dir].waits);
+            return false;
+        }
+        if (err) {
+            LOG_WRN("%s: dropping %u bytes: %d", app_uart_name(to), (unsigned int)chunk, err);
+            atomic_add(&dirs[dir].dropped, chunk);
+        } else {
+            atomic_add(&dirs[dir].bytes, chunk);
+        }
+        spsc_ring_consume(&rings[dir], chunk);
+    }
+    return true;
+}
+
+static void bridge_thread(void *p1, void *p2, void *p3)
+{
+    while (true) {
+        (void)k_sem_take(&kick, K_FOREVER);
+
+        // a full TX buffer gives the semaphore back from its TX done
+        (void)bridge_forward(APP_BRIDGE_USB_TO_UART, BRIDGE_UART);
+        (void)bridge_forward(APP_BRIDGE_UART_TO_USB, BRIDGE_USB);
+    }
+}
+
+K_THREAD_DEFINE(app_bridge_id, CONFIG_APP_BRIDGE_THREAD_STACK_SIZE, bridge_thread, NULL, NULL,
+                NULL, CONFIG_APP_BRIDGE_THREAD_PRIORITY, 0, 0);
+
+static void usb_rx_callback(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    bridge_queue(APP_BRIDGE_USB_TO_UART, byte, len);
+}
+
+static void uart_rx_callback(struct app_uart *uart, uint8_t *byte, size_t len)
+{
+    bridge_queue(APP_BRIDGE_UART_TO_USB, byte, len);
+}
+
+/* from the UART ISR: room in a staging buffer again */
+static void bridge_tx_done(struct app_uart *uart)
+{
+    k_sem_give(&kick);
+}
+
+void app_bridge_line_coding(const struct device *usb_dev)
+{
+    struct uart_config cfg;
+    int err;
+
+    if (usb_dev != DEVICE_DT_GET(BRIDGE_USB_NODE)) {
+        return;
+    }
+
+    err = uart_config_get(usb_dev, &cfg);
+    if (err) {
+        LOG_WRN("Failed to get the line coding: %d", err);
+        return;
+    }
+
+    // CDC ACM has no flow control setting, the UART keeps none
+    cfg.flow_ctrl = UART_CFG_FLOW_CTRL_NONE;
+
+    err = app_uart_configure(BRIDGE_UART, &cfg);
+    if (err) {
+        LOG_WRN("Failed to apply line coding %u baud: %d", cfg.baudrate, err);
+        return;
+    }
+
+    LOG_INF("Line coding %u baud, parity %u, stop bits %u, data bits %u",
+            cfg.baudrate, cfg.parity, cfg.stop_bits, cfg.data_bits);
+}
+
+void app_bridge_stats_get(struct app_bridge_stats *stats)
+{
+    for (size_t i = 0; i < APP_BRIDGE_DIR_COUNT; i++) {
+        stats->dir[i].bytes = atomic_get(&dirs[i].bytes);
+        stats->dir[i].dropped = atomic_get(&dirs[i].dropped);
+        stats->dir[i].waits = atomic_get(&dirs[i].waits);
+    }
+    stats->elapsed_ms = (uint32_t)(k_uptime_get() - reset_ms);
+}
+
+void app_bridge_stats_reset(void)
+{
+    for (size_t i = 0; i < APP_BRIDGE_DIR_COUNT; i++) {
+        atomic_clear(&dirs[i].bytes);
+        atomic_clear(&dirs[i].dropped);
+        atomic_clear(&dirs[i].waits);
+    }
+    reset_ms = k_uptime_get();
+}
+
+int app_bridge_start(void)
+{
+    int err;
+
+    app_bridge_stats_reset();
+
+    err = app_uart_rx_cb_register(BRIDGE_USB, usb_rx_callback);
+    if (err) {
+        LOG_ERR("Failed to register USB RX callback: %d", err);
+        return err;
+    }
+
+    err = app_uart_rx_cb_register(BRIDGE_UART, uart_rx_callback);
+    if (err) {
+        LOG_ERR("Failed to register UART RX callback: %d", err);
+        return err;
+    }
+
+    (void)app_uart_tx_done_cb_register(BRIDGE_USB, bridge_tx_done);
+    (void)app_uart_tx_done_cb_register(BRIDGE_UART, bridge_tx_done);
+
+    LOG_INF("Bridge %s <-> %s", app_uart_name(BRIDGE_USB), app_uart_name(BRIDGE_UART));
+    return 0;
+}
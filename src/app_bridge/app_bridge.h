@@ -0,0 +1,54 @@
+#ifndef __APP_BRIDGE_H
+#define __APP_BRIDGE_H
+
+#include <stdint.h>
+#include <zephyr/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum app_bridge_dir {
+    APP_BRIDGE_USB_TO_UART,
+    APP_BRIDGE_UART_TO_USB,
+    APP_BRIDGE_DIR_COUNT,
+};
+
+struct app_bridge_stats {
+    struct {
+        uint32_t bytes;     // forwarded
+        uint32_t dropped;   // bytes that found the bridge buffer full
+        uint32_t waits;     // the other side's TX buffer was full, waited for its TX done
+    } dir[APP_BRIDGE_DIR_COUNT];
+    uint32_t elapsed_ms;    // since the last reset
+};
+
+/**
+ * @brief Start forwarding between the USB and UART ports
+ * @return 0 on success, negative error code on failure
+ */
+int app_bridge_start(void);
+
+/**
+ * @brief Apply the line coding of a CDC ACM port to the UART
+ *
+ * Called on USBD_MSG_CDC_ACM_LINE_CODING, other ports than the bridged one are ignored.
+ * @param usb_dev CDC ACM device whose line coding changed
+ */
+void app_bridge_line_coding(const struct device *usb_dev);
+
+/**
+ * @brief Read the counters of both directions
+ */
+void app_bridge_stats_get(struct app_bridge_stats *stats);
+
+/**
+ * @brief Reset the counters
+ */
+void app_bridge_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_BRIDGE_H
@@ -0,0 +1,41 @@
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "app_bridge.h"
+
+static const char *const dir_names[APP_BRIDGE_DIR_COUNT] = {
+    [APP_BRIDGE_USB_TO_UART] = "usb->uart",
+    [APP_BRIDGE_UART_TO_USB] = "uart->usb",
+};
+
+static int cmd_bridge(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_bridge_stats stats;
+
+    app_bridge_stats_get(&stats);
+
+    shell_print(sh, "%-10s %10s %8s %8s %8s", "direction", "bytes", "B/s", "dropped", "waits");
+    for (size_t i = 0; i < APP_BRIDGE_DIR_COUNT; i++) {
+        uint32_t rate = (stats.elapsed_ms > 0) ?
+                        (uint32_t)((uint64_t)stats.dir[i].bytes * 1000 / stats.elapsed_ms) : 0;
+
+        shell_print(sh, "%-10s %10u %8u %8u %8u", dir_names[i], stats.dir[i].bytes, rate,
+                    stats.dir[i].dropped, stats.dir[i].waits);
+    }
+    shell_print(sh, "over %u ms", stats.elapsed_ms);
+    return 0;
+}
+
+static int cmd_bridge_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    app_bridge_stats_reset();
+    shell_print(sh, "Statistics reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_bridge,
+    SHELL_CMD(reset, NULL, "Reset the counters", cmd_bridge_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(bridge, &sub_bridge, "USB to UART bridge throughput per direction", cmd_bridge);
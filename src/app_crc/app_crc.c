@@ -0,0 +1,123 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "app_crc.h"
+
+/* app_crc16_ccitt_table and app_crc32_ieee_table, [slices][256], generated at
+ * build time by scripts/gen_crc_tables.py
+ */
+#include "app_crc_tables.h"
+
+BUILD_ASSERT(APP_CRC_TABLE_SLICES == CONFIG_APP_CRC_SLICES,
+             "app_crc_tables.h is out of date, rebuild with -p");
+
+/*
+ * Slice by N: the running CRC is XORed into the next N bytes, then every
+ * byte of that block is looked up in its own table, table k folding a byte
+ * that is followed by k more. N lookups are independent of each other,
+ * instead of a chain of N dependent ones for the byte table.
+ *
+ * Both CRCs are reflected, the bytes are read little endian.
+ */
+#define T16 app_crc16_ccitt_table
+#define T32 app_crc32_ieee_table
+
+static ALWAYS_INLINE uint16_t crc16_bytes(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 8) ^ T16[0][(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+static ALWAYS_INLINE uint16_t crc16_run(uint16_t crc, const uint8_t *data, size_t len,
+                                        unsigned int slices)
+{
+#if CONFIG_APP_CRC_SLICES >= 8
+    if (slices == 8) {
+        for (; len >= 8; data += 8, len -= 8) {
+            uint32_t lo = crc ^ sys_get_le32(data);
+            uint32_t hi = sys_get_le32(data + 4);
+
+            crc = T16[7][lo & 0xFF] ^ T16[6][(lo >> 8) & 0xFF] ^
+                  T16[5][(lo >> 16) & 0xFF] ^ T16[4][lo >> 24] ^
+                  T16[3][hi & 0xFF] ^ T16[2][(hi >> 8) & 0xFF] ^
+                  T16[1][(hi >> 16) & 0xFF] ^ T16[0][hi >> 24];
+        }
+    }
+#endif
+#if CONFIG_APP_CRC_SLICES >= 4
+    if (slices >= 4) {
+        for (; len >= 4; data += 4, len -= 4) {
+            uint32_t lo = crc ^ sys_get_le32(data);
+
+            crc = T16[3][lo & 0xFF] ^ T16[2][(lo >> 8) & 0xFF] ^
+                  T16[1][(lo >> 16) & 0xFF] ^ T16[0][lo >> 24];
+        }
+    }
+#endif
+    return crc16_bytes(crc, data, len);
+}
+
+static ALWAYS_INLINE uint32_t crc32_bytes(uint32_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 8) ^ T32[0][(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+static ALWAYS_INLINE uint32_t crc32_run(uint32_t crc, const uint8_t *data, size_t len,
+                                        unsigned int slices)
+{
+    // pre and post inverted, like crc32_ieee_update()
+    crc = ~crc;
+#if CONFIG_APP_CRC_SLICES >= 8
+    if (slices == 8) {
+        for (; len >= 8; data += 8, len -= 8) {
+            uint32_t lo = crc ^ sys_get_le32(data);
+            uint32_t hi = sys_get_le32(data + 4);
+
+            crc = T32[7][lo & 0xFF] ^ T32[6][(lo >> 8) & 0xFF] ^
+                  T32[5][(lo >> 16) & 0xFF] ^ T32[4][lo >> 24] ^
+                  T32[3][hi & 0xFF] ^ T32[2][(hi >> 8) & 0xFF] ^
+                  T32[1][(hi >> 16) & 0xFF] ^ T32[0][hi >> 24];
+        }
+    }
+#endif
+#if CONFIG_APP_CRC_SLICES >= 4
+    if (slices >= 4) {
+        for (; len >= 4; data += 4, len -= 4) {
+            uint32_t lo = crc ^ sys_get_le32(data);
+
+            crc = T32[3][lo & 0xFF] ^ T32[2][(lo >> 8) & 0xFF] ^
+                  T32[1][(lo >> 16) & 0xFF] ^ T32[0][lo >> 24];
+        }
+    }
+#endif
+    return ~crc32_bytes(crc, data, len);
+}
+
+uint16_t app_crc16_ccitt(uint16_t seed, const uint8_t *data, size_t len)
+{
+    return crc16_run(seed, data, len, CONFIG_APP_CRC_SLICES);
+}
+
+uint32_t app_crc32_ieee_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    return crc32_run(crc, data, len, CONFIG_APP_CRC_SLICES);
+}
+
+uint16_t app_crc16_ccitt_sliced(uint16_t seed, const uint8_t *data, size_t len,
+                                unsigned int slices)
+{
+    __ASSERT(slices <= CONFIG_APP_CRC_SLICES, "Only %d slices", CONFIG_APP_CRC_SLICES);
+    return crc16_run(seed, data, len, slices);
+}
+
+uint32_t app_crc32_ieee_update_sliced(uint32_t crc, const uint8_t *data, size_t len,
+                                      unsigned int slices)
+{
+    __ASSERT(slices <= CONFIG_APP_CRC_SLICES, "Only %d slices", CONFIG_APP_CRC_SLICES);
+    return crc32_run(crc, data, len, slices);
+}
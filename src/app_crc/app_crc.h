@@ -0,0 +1,64 @@
+#ifndef __APP_CRC_H
+#define __APP_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Table driven CRCs, CONFIG_APP_CRC_SLICES bytes per lookup step.
+ * Same results as crc16_ccitt() and crc32_ieee_update() of <zephyr/sys/crc.h>,
+ * so the two can be mixed on either end of a link. All of them can be
+ * called incrementally: pass the result of one span as the seed of the next.
+ */
+
+/**
+ * @brief CRC16-CCITT, reflected polynomial 0x8408, no final XOR
+ * @param seed Initial value, or the CRC of the data before
+ * @param data Data
+ * @param len Length
+ * @return CRC
+ */
+uint16_t app_crc16_ccitt(uint16_t seed, const uint8_t *data, size_t len);
+
+/**
+ * @brief CRC32-IEEE as in Ethernet and zlib, update of a running CRC
+ * @param crc 0 for the first span, or the CRC of the data before
+ * @param data Data
+ * @param len Length
+ * @return CRC
+ */
+uint32_t app_crc32_ieee_update(uint32_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief CRC32-IEEE of one buffer
+ */
+static inline uint32_t app_crc32_ieee(const uint8_t *data, size_t len)
+{
+    return app_crc32_ieee_update(0, data, len);
+}
+
+/**
+ * @brief CRC16-CCITT with fewer slices than configured, for comparisons
+ * @param slices 1, 4 or 8, at most CONFIG_APP_CRC_SLICES
+ * @return CRC, the same for any @p slices
+ */
+uint16_t app_crc16_ccitt_sliced(uint16_t seed, const uint8_t *data, size_t len,
+                                unsigned int slices);
+
+/**
+ * @brief CRC32-IEEE with fewer slices than configured, for comparisons
+ * @param slices 1, 4 or 8, at most CONFIG_APP_CRC_SLICES
+ * @return CRC, the same for any @p slices
+ */
+uint32_t app_crc32_ieee_update_sliced(uint32_t crc, const uint8_t *data, size_t len,
+                                      unsigned int slices);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_CRC_H
@@ -0,0 +1,59 @@
+#include <zephyr/kernel.h>
+
+#include "app_framer.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_framer, CONFIG_APP_FRAMER_LOG_LEVEL);
+
+void app_framer_init(struct app_framer *framer, uint8_t *buf, size_t size,
+                     app_framer_cb_t cb, void *user_data)
+{
+    *framer = (struct app_framer) {
+        .buf = buf,
+        .size = size,
+        .cb = cb,
+        .user_data = user_data,
+    };
+}
+
+void app_framer_reset(struct app_framer *framer)
+{
+    framer->len = 0;
+    framer->state = 0;
+    framer->aux = 0;
+}
+
+#if !IS_ENABLED(CONFIG_APP_FRAMER_GAP)
+/* the frames are delimited in band, line idle is no boundary */
+void app_framer_feed_end(struct app_framer *framer, const uint8_t *data, size_t len)
+{
+    app_framer_feed(framer, data, len);
+}
+#endif
+
+int app_framer_send(struct app_uart *uart, const uint8_t *payload, size_t len)
+{
+    uint8_t *buf;
+    size_t avail;
+    int ret;
+
+    // encode straight into the TX staging buffer, into what is free:
+    // the worst case length may not fit where the frame itself does
+    ret = app_uart_tx_reserve_avail(uart, &buf, &avail);
+    if (ret) {
+        return ret;
+    }
+
+    ret = app_framer_encode(payload, len, buf, avail);
+    if (ret < 0) {
+        app_uart_tx_commit(uart, 0);
+        if (ret != -ENOSPC) {
+            return ret;
+        }
+        // a buffer that is empty doesn't get larger
+        return (avail == app_uart_tx_buf_size(uart)) ? -EMSGSIZE : -ENOMEM;
+    }
+
+    return app_uart_tx_commit(uart, ret);
+}
@@ -0,0 +1,136 @@
+#ifndef __APP_FRAMER_H
+#define __APP_FRAMER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct app_framer;
+struct app_uart;
+
+/**
+ * @brief Frame callback, called with the decoded payload
+ *
+ * The frame buffer is reused after the callback returns.
+ */
+typedef void (*app_framer_cb_t)(struct app_framer *framer, uint8_t *frame, size_t len);
+
+struct app_framer_stats {
+    uint32_t frames;
+    uint32_t errors;        // malformed frames: bad escape, bad CRC, bare '\r', ...
+    uint32_t overflows;     // frames longer than the buffer
+};
+
+/**
+ * @brief Incremental, allocation-free frame decoder
+ *
+ * The framing engine is selected at build time by CONFIG_APP_FRAMER_*.
+ * state and aux are private to the engine.
+ */
+struct app_framer {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    uint32_t state;
+    uint32_t aux;
+    app_framer_cb_t cb;
+    void *user_data;
+    struct app_framer_stats stats;
+};
+
+#define APP_FRAMER_DEFINE(_name, _size, _cb)                            \
+    static uint8_t _name##_buf[_size];                                  \
+    static struct app_framer _name = {                                  \
+        .buf = _name##_buf,                                             \
+        .size = (_size),                                                \
+        .cb = (_cb),                                                    \
+    }
+
+/* worst case encoded length of a payload of _len bytes */
+#if defined(CONFIG_APP_FRAMER_COBS)
+/* one code byte per 254 bytes, plus the 0x00 delimiter */
+#define APP_FRAMER_MAX_ENCODED_LEN(_len) ((_len) + (_len) / 254 + 2)
+#elif defined(CONFIG_APP_FRAMER_SLIP)
+/* every byte may be escaped, plus END on both sides */
+#define APP_FRAMER_MAX_ENCODED_LEN(_len) (2 * (_len) + 2)
+#elif defined(CONFIG_APP_FRAMER_GAP)
+/* the payload as is, the line idle after it delimits it */
+#define APP_FRAMER_MAX_ENCODED_LEN(_len) (_len)
+#elif defined(CONFIG_APP_FRAMER_LENPFX)
+/* SOF, 16 bit length, CRC16 */
+#define APP_FRAMER_MAX_ENCODED_LEN(_len) ((_len) + 5)
+#else
+/* "\r\n" */
+#define APP_FRAMER_MAX_ENCODED_LEN(_len) ((_len) + 2)
+#endif
+
+/**
+ * @brief Feed received bytes into the decoder
+ *
+ * The callback is called for every complete frame.
+ * @param framer Framer
+ * @param data Received bytes
+ * @param len Number of received bytes
+ */
+void app_framer_feed(struct app_framer *framer, const uint8_t *data, size_t len);
+
+/**
+ * @brief Feed the last received bytes before the line went idle
+ *
+ * See app_uart_rx_frame_end(). The gap engine ends the frame there, @p len
+ * may be 0 then. The other engines delimit their frames in band, it is the
+ * same as app_framer_feed() for them.
+ * @param framer Framer
+ * @param data Received bytes
+ * @param len Number of received bytes
+ */
+void app_framer_feed_end(struct app_framer *framer, const uint8_t *data, size_t len);
+
+/**
+ * @brief Initialize a framer at run time, APP_FRAMER_DEFINE() does it statically
+ * @param framer Framer
+ * @param buf Frame buffer
+ * @param size Size of buf, the longest payload
+ * @param cb Frame callback
+ * @param user_data Left for the callback in framer->user_data
+ */
+void app_framer_init(struct app_framer *framer, uint8_t *buf, size_t size,
+                     app_framer_cb_t cb, void *user_data);
+
+/**
+ * @brief Drop the partially received frame
+ */
+void app_framer_reset(struct app_framer *framer);
+
+/**
+ * @brief Encode one frame
+ * @param payload Payload to encode
+ * @param len Length of payload
+ * @param out Output buffer
+ * @param out_size Size of output buffer, APP_FRAMER_MAX_ENCODED_LEN(len) is always enough
+ * @return Encoded length on success, -ENOSPC if the output buffer is too small
+ */
+int app_framer_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size);
+
+/**
+ * @brief Encode one frame directly into the UART TX buffer and send it
+ *
+ * With the gap engine a frame waiting for its turn leaves no room, the TX
+ * done interrupt starts it once the gap passed, see CONFIG_APP_UART_TX_FRAME_GAP.
+ * @param uart Port
+ * @param payload Payload to encode
+ * @param len Length of payload
+ * @return 0 on success, -EMSGSIZE if the frame doesn't fit the TX staging buffer,
+ *         -ENOMEM if it doesn't fit the space left in it now, -EBUSY if a TX
+ *         reservation is open, other negative error code on failure
+ */
+int app_framer_send(struct app_uart *uart, const uint8_t *payload, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_FRAMER_H
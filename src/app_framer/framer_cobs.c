@@ -0,0 +1,127 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_framer.h"
+#include "framer_swar.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_framer, CONFIG_APP_FRAMER_LOG_LEVEL);
+
+/*
+ * Consistent Overhead Byte Stuffing, frames are delimited by 0x00.
+ *
+ * state: data bytes left in the current block, 0 when a code byte is expected
+ * aux: code byte of the current block, 0 at the start of a frame,
+ *      COBS_DISCARD while skipping a broken frame up to the next delimiter
+ */
+#define COBS_DISCARD 0x100
+
+static void cobs_discard(struct app_framer *framer)
+{
+    framer->len = 0;
+    framer->state = 0;
+    framer->aux = COBS_DISCARD;
+}
+
+void app_framer_feed(struct app_framer *framer, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        // look for the delimiter in the current run
+        const uint8_t *zero = framer_find(&data[i], len - i, 0x00);
+        size_t end = (zero != NULL) ? (size_t)(zero - data) : len;
+
+        while (i < end) {
+            if (framer->aux == COBS_DISCARD) {
+                i = end;
+                break;
+            }
+
+            if (framer->state == 0) {
+                // code byte, the previous block ends with an implicit zero
+                if (framer->aux != 0 && framer->aux != 0xFF) {
+                    if (framer->len >= framer->size) {
+                        framer->stats.overflows++;
+                        cobs_discard(framer);
+                        continue;
+                    }
+                    framer->buf[framer->len++] = 0x00;
+                }
+                framer->aux = data[i];
+                framer->state = data[i] - 1;
+                i++;
+                continue;
+            }
+
+            // copy the data bytes of the block at once
+            size_t run = MIN(framer->state, end - i);
+
+            if (run > framer->size - framer->len) {
+                framer->stats.overflows++;
+                cobs_discard(framer);
+                continue;
+            }
+            memcpy(&framer->buf[framer->len], &data[i], run);
+            framer->len += run;
+            framer->state -= run;
+            i += run;
+        }
+
+        if (zero == NULL) {
+            break;
+        }
+
+        // delimiter
+        if (framer->aux == COBS_DISCARD) {
+            // resynchronized
+        } else if (framer->state != 0) {
+            LOG_WRN("COBS frame truncated");
+            framer->stats.errors++;
+        } else if (framer->aux != 0) {
+            framer->stats.frames++;
+            framer->cb(framer, framer->buf, framer->len);
+        }
+        app_framer_reset(framer);
+        i++;
+    }
+}
+
+int app_framer_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size)
+{
+    size_t code_idx = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+
+    // the worst case may not fit where this payload does, out_size is checked as it goes
+    if (out_size < len + 2) {
+        return -ENOSPC;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if (payload[i] != 0x00) {
+            if (o >= out_size) {
+                return -ENOSPC;
+            }
+            out[o++] = payload[i];
+            code++;
+        }
+
+        if (payload[i] == 0x00 || code == 0xFF) {
+            if (o >= out_size) {
+                return -ENOSPC;
+            }
+            out[code_idx] = code;
+            code_idx = o++;
+            code = 1;
+        }
+    }
+
+    if (o >= out_size) {
+        return -ENOSPC;
+    }
+    out[code_idx] = code;
+    out[o++] = 0x00;
+    return o;
+}
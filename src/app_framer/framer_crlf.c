@@ -0,0 +1,83 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_framer.h"
+#include "framer_swar.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_framer, CONFIG_APP_FRAMER_LOG_LEVEL);
+
+/*
+ * "\r\n" terminated lines.
+ *
+ * Contract, kept from the original per-byte state machine:
+ * - a frame ends when '\r' is directly followed by '\n'
+ * - a byte arriving when the buffer is full is dropped and the frame is reset
+ * - '\r' followed by anything else than '\n' resets the frame,
+ *   that byte is dropped too
+ *
+ * state: '\r' was the last byte
+ */
+
+void app_framer_feed(struct app_framer *framer, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        if (framer->len >= framer->size) {
+            LOG_WRN("Serial command buffer overflow, resetting");
+            // the byte is dropped
+            framer->stats.overflows++;
+            app_framer_reset(framer);
+            i++;
+            continue;
+        }
+
+        if (framer->state) {
+            uint8_t byte = data[i++];
+
+            framer->buf[framer->len++] = byte;
+            if ('\n' == byte) {
+                framer->stats.frames++;
+                // without the "\r\n"
+                framer->cb(framer, framer->buf, framer->len - 2);
+            } else {
+                LOG_WRN("Received \\r, but no \\n after!!!");
+                framer->stats.errors++;
+            }
+            app_framer_reset(framer);
+            continue;
+        }
+
+        // copy the run up to and including the next '\r' at once
+        const uint8_t *cr = framer_find(&data[i], len - i, '\r');
+        size_t run = (cr != NULL) ? (size_t)(cr - &data[i]) + 1 : len - i;
+        size_t space = framer->size - framer->len;
+
+        if (run > space) {
+            // fill the buffer, the next byte is an overflow
+            memcpy(&framer->buf[framer->len], &data[i], space);
+            framer->len += space;
+            i += space;
+            continue;
+        }
+
+        memcpy(&framer->buf[framer->len], &data[i], run);
+        framer->len += run;
+        i += run;
+        framer->state = (cr != NULL);
+    }
+}
+
+int app_framer_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size)
+{
+    if (out_size < len + 2) {
+        return -ENOSPC;
+    }
+
+    memcpy(out, payload, len);
+    out[len] = '\r';
+    out[len + 1] = '\n';
+    return len + 2;
+}
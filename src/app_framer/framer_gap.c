@@ -0,0 +1,69 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_framer.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_framer, CONFIG_APP_FRAMER_LOG_LEVEL);
+
+/*
+ * Frames delimited by line idle, as Modbus RTU: the bytes of a frame go
+ * back to back, and a gap of CONFIG_APP_UART_RX_FRAME_GAP_X10 / 10
+ * characters ends it. app_uart finds the gap, see app_uart_rx_frame_end(),
+ * so the bytes are copied without being scanned, and a frame reported in
+ * one chunk is not even copied.
+ *
+ * state: the frame overflowed, dropped up to its end
+ */
+enum gap_state {
+    S_FRAME,
+    S_DROP,
+};
+
+void app_framer_feed(struct app_framer *framer, const uint8_t *data, size_t len)
+{
+    // the frame end alone comes with no bytes
+    if (len == 0 || framer->state == S_DROP) {
+        return;
+    }
+
+    if (len > framer->size - framer->len) {
+        LOG_WRN("Frame exceeds the buffer of %d bytes", framer->size);
+        framer->stats.overflows++;
+        framer->state = S_DROP;
+        return;
+    }
+
+    memcpy(&framer->buf[framer->len], data, len);
+    framer->len += len;
+}
+
+void app_framer_feed_end(struct app_framer *framer, const uint8_t *data, size_t len)
+{
+    if (framer->len == 0 && framer->state == S_FRAME && len > 0 && len <= framer->size) {
+        // the whole frame in one chunk, handed over in place
+        framer->stats.frames++;
+        framer->cb(framer, (uint8_t *)data, len);
+        return;
+    }
+
+    app_framer_feed(framer, data, len);
+
+    if (framer->state == S_FRAME && framer->len > 0) {
+        framer->stats.frames++;
+        framer->cb(framer, framer->buf, framer->len);
+    }
+    app_framer_reset(framer);
+}
+
+int app_framer_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size)
+{
+    if (out_size < APP_FRAMER_MAX_ENCODED_LEN(len)) {
+        return -ENOSPC;
+    }
+
+    // the gap before the next frame is the delimiter, see app_framer_send()
+    memcpy(out, payload, len);
+    return len;
+}
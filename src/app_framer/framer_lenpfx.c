@@ -0,0 +1,149 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_crc.h"
+#include "app_framer.h"
+#include "framer_swar.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_framer, CONFIG_APP_FRAMER_LOG_LEVEL);
+
+/*
+ * Length and CRC prefixed frames:
+ * | SOF | len (16 bit LE) | payload | CRC16-CCITT of len and payload (LE) |
+ *
+ * The payload is never scanned, SOF is only searched to resynchronize.
+ *
+ * state: position in the frame
+ * aux: expected payload length in the low half, running CRC in the high half
+ */
+#define LENPFX_SOF          0xA5
+#define LENPFX_CRC_SEED     0xFFFF
+
+enum lenpfx_state {
+    S_WAIT_SOF,
+    S_LEN_LO,
+    S_LEN_HI,
+    S_PAYLOAD,
+    S_CRC_LO,
+    S_CRC_HI,
+    S_CRC_HI_BAD,   // low byte of the CRC already mismatched
+};
+
+#define AUX_LEN(aux)            ((aux) & 0xFFFF)
+#define AUX_CRC(aux)            ((uint16_t)((aux) >> 16))
+#define AUX(len, crc)           (((uint32_t)(crc) << 16) | ((len) & 0xFFFF))
+
+static inline uint16_t lenpfx_crc(uint16_t crc, const uint8_t *data, size_t len)
+{
+    return app_crc16_ccitt(crc, data, len);
+}
+
+void app_framer_feed(struct app_framer *framer, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        uint8_t byte;
+
+        switch (framer->state) {
+        case S_WAIT_SOF:
+        {
+            const uint8_t *sof = framer_find(&data[i], len - i, LENPFX_SOF);
+
+            if (sof == NULL) {
+                return;
+            }
+            i = sof - data + 1;
+            framer->len = 0;
+            framer->state = S_LEN_LO;
+            break;
+        }
+
+        case S_LEN_LO:
+            byte = data[i++];
+            framer->aux = AUX(byte, lenpfx_crc(LENPFX_CRC_SEED, &byte, 1));
+            framer->state = S_LEN_HI;
+            break;
+
+        case S_LEN_HI:
+        {
+            byte = data[i++];
+            uint32_t expected = AUX_LEN(framer->aux) | ((uint32_t)byte << 8);
+
+            if (expected > framer->size) {
+                LOG_WRN("Frame of %d bytes exceeds the buffer", expected);
+                framer->stats.overflows++;
+                app_framer_reset(framer);
+                break;
+            }
+            framer->aux = AUX(expected, lenpfx_crc(AUX_CRC(framer->aux), &byte, 1));
+            framer->state = (expected > 0) ? S_PAYLOAD : S_CRC_LO;
+            break;
+        }
+
+        case S_PAYLOAD:
+        {
+            // copy and checksum the payload run at once
+            size_t run = MIN(AUX_LEN(framer->aux) - framer->len, len - i);
+            uint16_t crc = lenpfx_crc(AUX_CRC(framer->aux), &data[i], run);
+
+            memcpy(&framer->buf[framer->len], &data[i], run);
+            framer->len += run;
+            framer->aux = AUX(AUX_LEN(framer->aux), crc);
+            i += run;
+
+            if (framer->len == AUX_LEN(framer->aux)) {
+                framer->state = S_CRC_LO;
+            }
+            break;
+        }
+
+        case S_CRC_LO:
+            byte = data[i++];
+            framer->state = (byte == (AUX_CRC(framer->aux) & 0xFF)) ? S_CRC_HI : S_CRC_HI_BAD;
+            break;
+
+        case S_CRC_HI:
+        case S_CRC_HI_BAD:
+            byte = data[i++];
+            if (framer->state == S_CRC_HI && byte == (AUX_CRC(framer->aux) >> 8)) {
+                framer->stats.frames++;
+                framer->cb(framer, framer->buf, framer->len);
+            } else {
+                LOG_WRN("Frame CRC mismatch");
+                framer->stats.errors++;
+            }
+            app_framer_reset(framer);
+            break;
+
+        default:
+            app_framer_reset(framer);
+            break;
+        }
+    }
+}
+
+int app_framer_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size)
+{
+    uint16_t crc;
+
+    if (len > UINT16_MAX) {
+        return -EMSGSIZE;
+    }
+
+    if (out_size < APP_FRAMER_MAX_ENCODED_LEN(len)) {
+        return -ENOSPC;
+    }
+
+    out[0] = LENPFX_SOF;
+    out[1] = len & 0xFF;
+    out[2] = len >> 8;
+    memcpy(&out[3], payload, len);
+
+    crc = lenpfx_crc(LENPFX_CRC_SEED, &out[1], len + 2);
+    out[len + 3] = crc & 0xFF;
+    out[len + 4] = crc >> 8;
+    return len + 5;
+}
@@ -0,0 +1,135 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_framer.h"
+#include "framer_swar.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(app_framer, CONFIG_APP_FRAMER_LOG_LEVEL);
+
+/*
+ * SLIP (RFC 1055), frames are delimited by END.
+ *
+ * state: the last byte was ESC
+ * aux: skipping a broken frame up to the next END
+ */
+#define SLIP_END        0xC0
+#define SLIP_ESC        0xDB
+#define SLIP_ESC_END    0xDC
+#define SLIP_ESC_ESC    0xDD
+
+static void slip_discard(struct app_framer *framer)
+{
+    framer->len = 0;
+    framer->state = 0;
+    framer->aux = 1;
+}
+
+void app_framer_feed(struct app_framer *framer, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        uint8_t byte;
+
+        if (framer->aux) {
+            const uint8_t *end = framer_find(&data[i], len - i, SLIP_END);
+
+            if (end == NULL) {
+                return;
+            }
+            i = end - data;
+            framer->aux = 0;
+        }
+
+        if (framer->state) {
+            byte = data[i++];
+            framer->state = 0;
+
+            if (byte == SLIP_ESC_END) {
+                byte = SLIP_END;
+            } else if (byte == SLIP_ESC_ESC) {
+                byte = SLIP_ESC;
+            } else {
+                LOG_WRN("Invalid SLIP escape 0x%02x", byte);
+                framer->stats.errors++;
+                // END right after ESC still ends the frame
+                if (byte == SLIP_END) {
+                    app_framer_reset(framer);
+                } else {
+                    slip_discard(framer);
+                }
+                continue;
+            }
+
+            if (framer->len >= framer->size) {
+                framer->stats.overflows++;
+                slip_discard(framer);
+                continue;
+            }
+            framer->buf[framer->len++] = byte;
+            continue;
+        }
+
+        // copy the run up to the next special byte at once
+        const uint8_t *special = framer_find2(&data[i], len - i, SLIP_END, SLIP_ESC);
+        size_t run = (special != NULL) ? (size_t)(special - &data[i]) : len - i;
+
+        if (run > framer->size - framer->len) {
+            framer->stats.overflows++;
+            slip_discard(framer);
+            continue;
+        }
+        memcpy(&framer->buf[framer->len], &data[i], run);
+        framer->len += run;
+        i += run;
+
+        if (special == NULL) {
+            break;
+        }
+
+        i++;
+        if (*special == SLIP_ESC) {
+            framer->state = 1;
+        } else if (framer->len > 0) {
+            // empty frames between back to back END are ignored
+            framer->stats.frames++;
+            framer->cb(framer, framer->buf, framer->len);
+            app_framer_reset(framer);
+        }
+    }
+}
+
+int app_framer_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size)
+{
+    size_t o = 0;
+
+    // the worst case may not fit where this payload does, out_size is checked as it goes
+    if (out_size < len + 2) {
+        return -ENOSPC;
+    }
+
+    // leading END flushes any line noise on the receiver
+    out[o++] = SLIP_END;
+    for (size_t i = 0; i < len; i++) {
+        bool esc = payload[i] == SLIP_END || payload[i] == SLIP_ESC;
+
+        // this byte, its escape if any, and the closing END
+        if (o + esc + 2 > out_size) {
+            return -ENOSPC;
+        }
+
+        if (payload[i] == SLIP_END) {
+            out[o++] = SLIP_ESC;
+            out[o++] = SLIP_ESC_END;
+        } else if (payload[i] == SLIP_ESC) {
+            out[o++] = SLIP_ESC;
+            out[o++] = SLIP_ESC_ESC;
+        } else {
+            out[o++] = payload[i];
+        }
+    }
+    out[o++] = SLIP_END;
+    return o;
+}
@@ -0,0 +1,68 @@
+#ifndef __FRAMER_SWAR_H
+#define __FRAMER_SWAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Word-at-a-time (SWAR) delimiter search shared by the framing engines */
+
+#define SWAR_ONES   ((uintptr_t)-1 / 0xFF)  // 0x0101...01
+#define SWAR_HIGHS  (SWAR_ONES << 7)        // 0x8080...80
+
+/* non-zero if any byte of w is zero */
+static inline uintptr_t swar_has_zero(uintptr_t w)
+{
+    return (w - SWAR_ONES) & ~w & SWAR_HIGHS;
+}
+
+/**
+ * @brief Find the first byte equal to a or b, memchr-style
+ * @return Pointer to the byte, NULL if not found
+ */
+static inline const uint8_t *framer_find2(const uint8_t *p, size_t n, uint8_t a, uint8_t b)
+{
+    const uintptr_t pa = SWAR_ONES * a;
+    const uintptr_t pb = SWAR_ONES * b;
+
+    // byte by byte until aligned
+    while (n > 0 && ((uintptr_t)p & (sizeof(uintptr_t) - 1)) != 0) {
+        if (*p == a || *p == b) {
+            return p;
+        }
+        p++;
+        n--;
+    }
+
+    while (n >= sizeof(uintptr_t)) {
+        uintptr_t w;
+
+        memcpy(&w, p, sizeof(w));
+        if (swar_has_zero(w ^ pa) || swar_has_zero(w ^ pb)) {
+            break;
+        }
+        p += sizeof(uintptr_t);
+        n -= sizeof(uintptr_t);
+    }
+
+    while (n > 0) {
+        if (*p == a || *p == b) {
+            return p;
+        }
+        p++;
+        n--;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Find the first byte equal to c, memchr-style
+ * @return Pointer to the byte, NULL if not found
+ */
+static inline const uint8_t *framer_find(const uint8_t *p, size_t n, uint8_t c)
+{
+    return framer_find2(p, n, c, c);
+}
+
+#endif //__FRAMER_SWAR_H
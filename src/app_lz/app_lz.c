@@ -0,0 +1,333 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+
+#include "app_framer.h"
+#include "app_lz.h"
+#include "app_uart.h"
+#include "lz_codec.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_lz, CONFIG_APP_LZ_LOG_LEVEL);
+
+/* Compressed frames over the app_framer in use:
+ * | APP_LZ_TAG | flags and seq | LZ block, see lz_codec.h |
+ * The blocks refer to the ones before, so the receiver needs all of them:
+ * seq tells a lost frame, and the receiver skips the frames after it up to
+ * the next one with LZ_RESET, which the sender starts a new history with
+ * every CONFIG_APP_LZ_RESET_INTERVAL frames. A stored block is delivered
+ * either way.
+ */
+#define LZ_HDR_LEN 2
+#define LZ_FRAME_MAX (LZ_HDR_LEN + CONFIG_APP_LZ_MAX_PAYLOAD)
+
+#define LZ_STORED BIT(7)
+#define LZ_RESET BIT(6)
+#define LZ_SEQ_MASK 0x3F
+
+struct lz_port {
+    struct app_uart *uart;
+    app_lz_rx_cb_t cb;
+    struct k_spinlock lock;     // stats
+
+    /* TX, all of it under tx_mutex */
+    struct k_mutex tx_mutex;
+    struct lz_encoder enc;
+    uint8_t tx_seq;
+    uint8_t tx_since_reset;
+    uint16_t frame_len;         // compressed, waits for room in the staging buffer
+    uint16_t frame_in_len;      // bytes compressed into it
+    uint8_t frame[LZ_FRAME_MAX];
+    struct k_work tx_work;      // sends it after the next TX done
+
+    /* RX, only the RX context touches it */
+    struct lz_decoder dec;
+    uint8_t rx_seq;             // expected next
+    bool rx_synced;             // the history matches the sender's
+
+    struct app_lz_stats stats;
+};
+
+static struct lz_port ports[APP_UART_NUM];
+
+static struct lz_port *lz_port_of(struct app_uart *uart)
+{
+    return &ports[app_uart_index(uart)];
+}
+
+/* With tx_mutex held, sends the frame compressed last. Never waits for
+ * the line: -EAGAIN if it doesn't fit the staging buffer, it stays queued
+ * then and the TX done callback sends it.
+ */
+static int lz_tx_queued(struct lz_port *lp)
+{
+    uint8_t flags = lp->frame[1];
+    int err;
+
+    if (lp->frame_len == 0) {
+        return 0;
+    }
+
+    err = app_framer_send(lp->uart, lp->frame, lp->frame_len);
+    if (err == -ENOMEM || err == -EBUSY) {
+        return -EAGAIN;
+    }
+
+    if (err) {
+        // the receiver misses this block, the next frame starts over
+        LOG_WRN("%s: failed to send a frame: %d", app_uart_name(lp->uart), err);
+        lp->tx_since_reset = CONFIG_APP_LZ_RESET_INTERVAL;
+    } else {
+        K_SPINLOCK(&lp->lock) {
+            lp->stats.tx_frames++;
+            lp->stats.tx_stored += !!(flags & LZ_STORED);
+            lp->stats.tx_resets += !!(flags & LZ_RESET);
+            lp->stats.tx_in_bytes += lp->frame_in_len;
+            lp->stats.tx_out_bytes += lp->frame_len - LZ_HDR_LEN;
+        }
+    }
+    lp->frame_len = 0;
+    return err;
+}
+
+/* With tx_mutex held, compresses what is buffered and sends it, or
+ * queues it. -EAGAIN if the frame before is still queued.
+ */
+static int lz_tx_frame(struct lz_port *lp)
+{
+    size_t in_len = lz_encoder_pending(&lp->enc);
+    uint8_t flags = 0;
+    bool stored;
+    int len, err;
+
+    if (lz_tx_queued(lp) == -EAGAIN) {
+        return -EAGAIN;
+    }
+
+    if (lp->tx_since_reset >= CONFIG_APP_LZ_RESET_INTERVAL) {
+        lz_encoder_reset(&lp->enc);
+        lp->tx_since_reset = 0;
+        flags |= LZ_RESET;
+    }
+
+    len = lz_compress(&lp->enc, &lp->frame[LZ_HDR_LEN], CONFIG_APP_LZ_MAX_PAYLOAD, &stored);
+    if (len < 0) {
+        return len;
+    }
+    if (stored) {
+        flags |= LZ_STORED;
+    }
+
+    lp->frame[0] = APP_LZ_TAG;
+    lp->frame[1] = flags | (lp->tx_seq & LZ_SEQ_MASK);
+    lp->frame_len = LZ_HDR_LEN + len;
+    lp->frame_in_len = in_len;
+    lp->tx_seq++;
+    lp->tx_since_reset++;
+
+    // a frame that doesn't fit is taken, it goes out after the next TX done
+    err = lz_tx_queued(lp);
+    return (err == -EAGAIN) ? 0 : err;
+}
+
+static void lz_tx_work_handler(struct k_work *work)
+{
+    struct lz_port *lp = CONTAINER_OF(work, struct lz_port, tx_work);
+
+    k_mutex_lock(&lp->tx_mutex, K_FOREVER);
+    (void)lz_tx_queued(lp);
+    k_mutex_unlock(&lp->tx_mutex);
+}
+
+/* from the UART ISR: room in the staging buffer for the queued frame */
+static void lz_tx_done(struct app_uart *uart)
+{
+    struct lz_port *lp = lz_port_of(uart);
+
+    if (lp->frame_len > 0) {
+        k_work_submit(&lp->tx_work);
+    }
+}
+
+int app_lz_open(struct app_uart *uart, app_lz_rx_cb_t cb)
+{
+    struct lz_port *lp = lz_port_of(uart);
+
+    if (lp->cb != NULL) {
+        return -EALREADY;
+    }
+
+    if (APP_FRAMER_MAX_ENCODED_LEN(LZ_FRAME_MAX) > app_uart_tx_buf_size(uart)) {
+        LOG_ERR("Frames of %u bytes exceed the TX buffer of %s", LZ_FRAME_MAX,
+                app_uart_name(uart));
+        return -EMSGSIZE;
+    }
+
+    (void)app_uart_tx_done_cb_register(uart, lz_tx_done);
+    lp->cb = cb;
+    return 0;
+}
+
+int app_lz_write(struct app_uart *uart, const uint8_t *data, size_t len)
+{
+    struct lz_port *lp = lz_port_of(uart);
+    int err = 0;
+
+    if (lp->cb == NULL) {
+        return -ENOTCONN;
+    }
+
+    k_mutex_lock(&lp->tx_mutex, K_FOREVER);
+    while (len > 0) {
+        size_t n = lz_encoder_write(&lp->enc, data, len);
+
+        data += n;
+        len -= n;
+        if (lz_encoder_pending(&lp->enc) == CONFIG_APP_LZ_MAX_PAYLOAD) {
+            err = lz_tx_frame(lp);
+            if (err) {
+                break;
+            }
+        }
+    }
+    k_mutex_unlock(&lp->tx_mutex);
+    return err;
+}
+
+int app_lz_flush(struct app_uart *uart)
+{
+    struct lz_port *lp = lz_port_of(uart);
+    int err = 0;
+
+    if (lp->cb == NULL) {
+        return -ENOTCONN;
+    }
+
+    k_mutex_lock(&lp->tx_mutex, K_FOREVER);
+    if (lz_encoder_pending(&lp->enc) > 0) {
+        err = lz_tx_frame(lp);
+    }
+    k_mutex_unlock(&lp->tx_mutex);
+    return err;
+}
+
+int app_lz_send(struct app_uart *uart, const uint8_t *data, size_t len)
+{
+    struct lz_port *lp = lz_port_of(uart);
+    int err;
+
+    if (lp->cb == NULL) {
+        return -ENOTCONN;
+    }
+
+    // the mutex is recursive, nothing is taken while a frame is still queued
+    k_mutex_lock(&lp->tx_mutex, K_FOREVER);
+    err = lz_tx_queued(lp);
+    if (err != -EAGAIN) {
+        err = app_lz_write(uart, data, len);
+    }
+    if (!err) {
+        err = app_lz_flush(uart);
+    }
+    k_mutex_unlock(&lp->tx_mutex);
+    return err;
+}
+
+bool app_lz_frame(struct app_uart *uart, const uint8_t *frame, size_t len)
+{
+    struct lz_port *lp = lz_port_of(uart);
+    const uint8_t *data;
+    uint8_t flags, seq;
+    int n;
+
+    if (lp->cb == NULL || len <= LZ_HDR_LEN || frame[0] != APP_LZ_TAG) {
+        return false;
+    }
+
+    flags = frame[1] & ~LZ_SEQ_MASK;
+    seq = frame[1] & LZ_SEQ_MASK;
+
+    if (flags & LZ_RESET) {
+        lz_decoder_reset(&lp->dec);
+        lp->rx_synced = true;
+    } else if (seq != lp->rx_seq && lp->rx_synced) {
+        LOG_WRN("%s: lost compressed frames, %u expected, %u received", app_uart_name(uart),
+                lp->rx_seq, seq);
+        lp->rx_synced = false;
+        K_SPINLOCK(&lp->lock) {
+            lp->stats.rx_lost++;
+        }
+    }
+    lp->rx_seq = (seq + 1) & LZ_SEQ_MASK;
+
+    if (!lp->rx_synced && !(flags & LZ_STORED)) {
+        K_SPINLOCK(&lp->lock) {
+            lp->stats.rx_dropped++;
+        }
+        return true;
+    }
+
+    if (lp->rx_synced) {
+        n = lz_decompress(&lp->dec, &frame[LZ_HDR_LEN], len - LZ_HDR_LEN,
+                          flags & LZ_STORED, &data);
+    } else {
+        // stored, it doesn't need the history, but the history still misses blocks
+        data = &frame[LZ_HDR_LEN];
+        n = len - LZ_HDR_LEN;
+    }
+
+    if (n < 0) {
+        LOG_WRN("%s: malformed compressed frame: %d", app_uart_name(uart), n);
+        lp->rx_synced = false;
+        K_SPINLOCK(&lp->lock) {
+            lp->stats.rx_errors++;
+        }
+        return true;
+    }
+
+    K_SPINLOCK(&lp->lock) {
+        lp->stats.rx_frames++;
+        lp->stats.rx_in_bytes += len - LZ_HDR_LEN;
+        lp->stats.rx_out_bytes += n;
+    }
+
+    lp->cb(uart, data, n);
+    return true;
+}
+
+void app_lz_stats_get(struct app_uart *uart, struct app_lz_stats *stats)
+{
+    struct lz_port *lp = lz_port_of(uart);
+
+    K_SPINLOCK(&lp->lock) {
+        *stats = lp->stats;
+    }
+}
+
+void app_lz_stats_reset(struct app_uart *uart)
+{
+    struct lz_port *lp = lz_port_of(uart);
+
+    K_SPINLOCK(&lp->lock) {
+        memset(&lp->stats, 0, sizeof(lp->stats));
+    }
+}
+
+static int app_lz_init(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(ports); i++) {
+        struct lz_port *lp = &ports[i];
+
+        lp->uart = app_uart_at(i);
+        k_mutex_init(&lp->tx_mutex);
+        k_work_init(&lp->tx_work, lz_tx_work_handler);
+        lz_encoder_init(&lp->enc);
+        lz_decoder_init(&lp->dec);
+        // the first frame starts the history of the receiver
+        lp->tx_since_reset = CONFIG_APP_LZ_RESET_INTERVAL;
+    }
+    return 0;
+}
+
+SYS_INIT(app_lz_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,113 @@
+#ifndef __APP_LZ_H
+#define __APP_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct app_uart;
+
+/* First byte of every compressed frame, tells them from the other frames of the port */
+#define APP_LZ_TAG 0xC5
+
+/**
+ * @brief Decompressed payload, called from the RX context
+ *
+ * The data is only valid until the callback returns.
+ */
+typedef void (*app_lz_rx_cb_t)(struct app_uart *uart, const uint8_t *data, size_t len);
+
+struct app_lz_stats {
+    uint32_t tx_frames;
+    uint32_t tx_stored;     // frames sent as they are, compression didn't pay
+    uint32_t tx_resets;     // frames that start a new history
+    uint32_t tx_in_bytes;   // payload
+    uint32_t tx_out_bytes;  // compressed, without the frame header
+    uint32_t rx_frames;
+    uint32_t rx_in_bytes;   // compressed, without the frame header
+    uint32_t rx_out_bytes;  // payload delivered
+    uint32_t rx_errors;     // malformed frames
+    uint32_t rx_lost;       // gaps in the frame sequence
+    uint32_t rx_dropped;    // frames skipped until the next history reset
+};
+
+/**
+ * @brief Compress the frames of a port
+ *
+ * Only frames sent with app_lz_write() and app_lz_send() are compressed.
+ * Hand every received frame to app_lz_frame(). Both sides of the link need
+ * the same CONFIG_APP_LZ_WINDOW. Compression takes the TX done callback
+ * of the port, see app_uart_tx_done_cb_register().
+ * @param uart Port
+ * @param cb Callback for the decompressed payloads
+ * @return 0 on success, -EALREADY if compression runs on the port already,
+ *         -EMSGSIZE if a frame doesn't fit the TX buffer of the port
+ */
+int app_lz_open(struct app_uart *uart, app_lz_rx_cb_t cb);
+
+/**
+ * @brief Add data to the stream, from thread context
+ *
+ * The data is buffered, and sent compressed as one frame every
+ * CONFIG_APP_LZ_MAX_PAYLOAD bytes. It doesn't wait for the line: a frame
+ * that doesn't fit the TX staging buffer is queued, and sent from the TX
+ * done callback.
+ * @param uart Port
+ * @param data Data
+ * @param len Length
+ * @return 0 on success, -ENOTCONN if compression doesn't run on the port,
+ *         -EAGAIN if a frame is due while the one before is still queued,
+ *         the data up to that frame is taken, or the error of
+ *         app_framer_send() for a frame that couldn't be sent
+ */
+int app_lz_write(struct app_uart *uart, const uint8_t *data, size_t len);
+
+/**
+ * @brief Send the data buffered by app_lz_write() as a frame now, from thread context
+ *
+ * The receiver gets it in one callback. Nothing is sent if nothing is buffered.
+ * @param uart Port
+ * @return 0 on success, negative error code as app_lz_write()
+ */
+int app_lz_flush(struct app_uart *uart);
+
+/**
+ * @brief Send data as frames of its own, from thread context
+ *
+ * Same as app_lz_write() and app_lz_flush(). The receiver gets the data in
+ * one callback if it fits CONFIG_APP_LZ_MAX_PAYLOAD and nothing else was
+ * buffered. Nothing is taken and -EAGAIN is returned while a frame is
+ * still queued, so a payload of one frame is sent whole or not at all.
+ */
+int app_lz_send(struct app_uart *uart, const uint8_t *data, size_t len);
+
+/**
+ * @brief Hand a received frame to the decompressor, from the frame callback
+ * @param uart Port the frame was received on
+ * @param frame Decoded payload of the app_framer
+ * @param len Length
+ * @return true if the frame was a compressed frame and is consumed
+ */
+bool app_lz_frame(struct app_uart *uart, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Read the counters of a port
+ * @param uart Port
+ * @param stats Set to the counters
+ */
+void app_lz_stats_get(struct app_uart *uart, struct app_lz_stats *stats);
+
+/**
+ * @brief Reset the counters of a port
+ */
+void app_lz_stats_reset(struct app_uart *uart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_LZ_H
@@ -0,0 +1,41 @@
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "app_lz.h"
+#include "app_uart.h"
+
+static int cmd_lz(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_lz_stats st;
+
+    shell_print(sh, "%-16s %8s %8s %10s %10s %6s %8s %8s %8s %8s", "port", "tx", "stored",
+                "in", "out", "ratio", "rx", "errors", "lost", "dropped");
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        struct app_uart *uart = app_uart_at(i);
+
+        app_lz_stats_get(uart, &st);
+        // compressed bytes per 100 bytes of payload
+        shell_print(sh, "%-16s %8u %8u %10u %10u %5u%% %8u %8u %8u %8u", app_uart_name(uart),
+                    st.tx_frames, st.tx_stored, st.tx_in_bytes, st.tx_out_bytes,
+                    st.tx_in_bytes ? (uint32_t)((uint64_t)st.tx_out_bytes * 100 /
+                                                st.tx_in_bytes) : 0,
+                    st.rx_frames, st.rx_errors, st.rx_lost, st.rx_dropped);
+    }
+    return 0;
+}
+
+static int cmd_lz_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        app_lz_stats_reset(app_uart_at(i));
+    }
+    shell_print(sh, "Statistics reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_lz,
+    SHELL_CMD(reset, NULL, "Reset the counters", cmd_lz_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(lz, &sub_lz, "Compression ratio and counters per port", cmd_lz);
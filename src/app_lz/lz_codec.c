@@ -0,0 +1,283 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "lz_codec.h"
+
+BUILD_ASSERT(LZ_WINDOW <= UINT16_MAX, "Offsets are 16 bit");
+BUILD_ASSERT(LZ_WINDOW + LZ_MAX_BLOCK <= UINT16_MAX);
+
+/* Every 2^LZ_SKIP_SHIFT bytes without a match, the search steps one byte
+ * further, like LZ4: data that doesn't compress costs little time.
+ */
+#define LZ_SKIP_SHIFT 5
+
+static inline uint32_t lz_hash(const uint8_t *p)
+{
+    // Knuth's multiplicative hash of the next LZ_MIN_MATCH bytes
+    return (sys_get_le32(p) * 2654435761u) >> (32 - CONFIG_APP_LZ_HASH_BITS);
+}
+
+void lz_encoder_init(struct lz_encoder *enc)
+{
+    // a stale hash entry only costs a compare, a match is always checked
+    memset(enc, 0, sizeof(*enc));
+}
+
+void lz_encoder_reset(struct lz_encoder *enc)
+{
+    memmove(enc->buf, &enc->buf[enc->hist_len], enc->in_len);
+    enc->base += enc->hist_len;
+    enc->valid_from = enc->base;
+    enc->hist_len = 0;
+}
+
+size_t lz_encoder_write(struct lz_encoder *enc, const uint8_t *data, size_t len)
+{
+    size_t n = MIN(len, (size_t)(LZ_MAX_BLOCK - enc->in_len));
+
+    memcpy(&enc->buf[enc->hist_len + enc->in_len], data, n);
+    enc->in_len += n;
+    return n;
+}
+
+/* The block becomes history, the oldest bytes beyond the window go */
+static void lz_encoder_commit(struct lz_encoder *enc)
+{
+    size_t total = enc->hist_len + enc->in_len;
+    size_t keep = MIN(total, (size_t)LZ_WINDOW);
+
+    if (total > keep) {
+        memmove(enc->buf, &enc->buf[total - keep], keep);
+        enc->base += total - keep;
+    }
+    enc->hist_len = keep;
+    enc->in_len = 0;
+}
+
+static size_t lz_put_len(uint8_t *out, size_t op, size_t len)
+{
+    if (len < 15) {
+        return op;
+    }
+    for (len -= 15; len >= 255; len -= 255) {
+        out[op++] = 255;
+    }
+    out[op++] = len;
+    return op;
+}
+
+/* One sequence, literals and a match of match_len bytes dist back, or the
+ * literals only at the end. False if it may not fit below limit.
+ */
+static bool lz_put_seq(uint8_t *out, size_t *op, size_t limit, const uint8_t *lit,
+                       size_t lit_len, size_t dist, size_t match_len)
+{
+    size_t ml = (match_len > 0) ? match_len - LZ_MIN_MATCH : 0;
+    size_t worst = 1 + lit_len / 255 + 1 + lit_len + ((match_len > 0) ? 2 + ml / 255 + 1 : 0);
+    size_t o = *op;
+
+    if (o + worst > limit) {
+        return false;
+    }
+
+    out[o++] = (MIN(lit_len, 15) << 4) | MIN(ml, 15);
+    o = lz_put_len(out, o, lit_len);
+    memcpy(&out[o], lit, lit_len);
+    o += lit_len;
+
+    if (match_len > 0) {
+        sys_put_le16(dist, &out[o]);
+        o = lz_put_len(out, o + 2, ml);
+    }
+
+    *op = o;
+    return true;
+}
+
+int lz_compress(struct lz_encoder *enc, uint8_t *out, size_t out_size, bool *raw)
+{
+    const uint8_t *buf = enc->buf;
+    const size_t start = enc->hist_len;
+    const size_t end = start + enc->in_len;
+    size_t ip = start;
+    size_t anchor = start;
+    size_t op = 0;
+    int ret;
+
+    if (enc->in_len == 0) {
+        return -ENODATA;
+    }
+    if (out_size < enc->in_len) {
+        return -ENOSPC;
+    }
+
+    // the block is only worth it shorter than its input
+    const size_t limit = enc->in_len - 1;
+
+    while (ip + LZ_MIN_MATCH <= end) {
+        uint32_t h = lz_hash(&buf[ip]);
+        uint32_t cur = enc->base + ip;
+        uint32_t dist = cur - enc->hash[h];
+        uint32_t reach = MIN(MIN((uint32_t)LZ_WINDOW, (uint32_t)ip), cur - enc->valid_from);
+
+        enc->hash[h] = cur;
+
+        if (dist == 0 || dist > reach || memcmp(&buf[ip - dist], &buf[ip], LZ_MIN_MATCH) != 0) {
+            ip += 1 + ((ip - anchor) >> LZ_SKIP_SHIFT);
+            continue;
+        }
+
+        // the match may run on into the bytes it repeats
+        size_t ref = ip - dist;
+        size_t len = LZ_MIN_MATCH;
+
+        while (ip + len < end && buf[ref + len] == buf[ip + len]) {
+            len++;
+        }
+
+        if (!lz_put_seq(out, &op, limit, &buf[anchor], ip - anchor, dist, len)) {
+            goto stored;
+        }
+        ip += len;
+        anchor = ip;
+
+        // repeats of the end of the match are found too
+        if (ip + 2 <= end) {
+            enc->hash[lz_hash(&buf[ip - 2])] = enc->base + ip - 2;
+        }
+    }
+
+    if (anchor < end && !lz_put_seq(out, &op, limit, &buf[anchor], end - anchor, 0, 0)) {
+        goto stored;
+    }
+
+    *raw = false;
+    lz_encoder_commit(enc);
+    return op;
+
+stored:
+    // the history is the same either way, the decoder copies it in too
+    memcpy(out, &buf[start], enc->in_len);
+    *raw = true;
+    ret = enc->in_len;
+    lz_encoder_commit(enc);
+    return ret;
+}
+
+void lz_decoder_init(struct lz_decoder *dec)
+{
+    dec->hist_len = 0;
+    dec->out_len = 0;
+}
+
+/* The last block becomes history, it was valid until now */
+static void lz_decoder_slide(struct lz_decoder *dec)
+{
+    size_t total = dec->hist_len + dec->out_len;
+    size_t keep = MIN(total, (size_t)LZ_WINDOW);
+
+    if (total > keep) {
+        memmove(dec->buf, &dec->buf[total - keep], keep);
+    }
+    dec->hist_len = keep;
+    dec->out_len = 0;
+}
+
+static bool lz_get_len(const uint8_t *in, size_t len, size_t *ip, size_t *n)
+{
+    uint8_t byte;
+
+    do {
+        if (*ip >= len) {
+            return false;
+        }
+        byte = in[(*ip)++];
+        *n += byte;
+    } while (byte == 255);
+    return true;
+}
+
+int lz_decompress(struct lz_decoder *dec, const uint8_t *in, size_t len, bool raw,
+                  const uint8_t **out)
+{
+    lz_decoder_slide(dec);
+
+    uint8_t *buf = dec->buf;
+    const size_t start = dec->hist_len;
+    const size_t cap = start + LZ_MAX_BLOCK;
+    size_t op = start;
+    size_t ip = 0;
+    int err = -EBADMSG;
+
+    if (raw) {
+        if (len > LZ_MAX_BLOCK) {
+            err = -EMSGSIZE;
+            goto fail;
+        }
+        memcpy(&buf[op], in, len);
+        op += len;
+        ip = len;
+    }
+
+    while (ip < len) {
+        uint8_t token = in[ip++];
+        size_t lit = token >> 4;
+
+        if (lit == 15 && !lz_get_len(in, len, &ip, &lit)) {
+            goto fail;
+        }
+        if (lit > len - ip) {
+            goto fail;
+        }
+        if (lit > cap - op) {
+            err = -EMSGSIZE;
+            goto fail;
+        }
+        memcpy(&buf[op], &in[ip], lit);
+        op += lit;
+        ip += lit;
+
+        // the last sequence has no match
+        if (ip == len) {
+            break;
+        }
+
+        if (len - ip < 2) {
+            goto fail;
+        }
+        size_t dist = sys_get_le16(&in[ip]);
+        size_t ml = token & 0x0F;
+
+        ip += 2;
+        if (ml == 15 && !lz_get_len(in, len, &ip, &ml)) {
+            goto fail;
+        }
+        ml += LZ_MIN_MATCH;
+
+        if (dist == 0 || dist > op) {
+            goto fail;
+        }
+        if (ml > cap - op) {
+            err = -EMSGSIZE;
+            goto fail;
+        }
+
+        // byte by byte, a match may repeat its own output
+        const uint8_t *ref = &buf[op - dist];
+
+        for (size_t i = 0; i < ml; i++) {
+            buf[op + i] = ref[i];
+        }
+        op += ml;
+    }
+
+    dec->out_len = op - start;
+    *out = &buf[start];
+    return dec->out_len;
+
+fail:
+    lz_decoder_init(dec);
+    return err;
+}
@@ -0,0 +1,118 @@
+#ifndef __LZ_CODEC_H
+#define __LZ_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming LZ77 codec with a bounded history, in the format of LZ4 blocks:
+ * | token | literal length ext | literals | offset (16 bit LE) | match length ext |
+ * The high nibble of the token is the literal length, the low nibble the
+ * match length minus LZ_MIN_MATCH, 15 meaning more in the following bytes
+ * (255 each, until one below 255). A block ends after literals or after a
+ * match, wherever the input ends.
+ *
+ * A block is compressed against the previous blocks too: matches reach
+ * CONFIG_APP_LZ_WINDOW bytes back across block boundaries, so short frames
+ * of similar text compress well. The decoder has to see every block the
+ * encoder produced since its last reset, in order.
+ *
+ * The state is static, nothing is allocated. Not thread safe.
+ */
+#define LZ_MIN_MATCH 4
+#define LZ_WINDOW CONFIG_APP_LZ_WINDOW
+#define LZ_MAX_BLOCK CONFIG_APP_LZ_MAX_PAYLOAD
+
+struct lz_encoder {
+    uint32_t base;          // stream position of buf[0]
+    uint32_t valid_from;    // matches don't reach before this stream position
+    uint16_t hist_len;      // history at the start of buf, at most LZ_WINDOW
+    uint16_t in_len;        // input of the next block, after the history
+    uint32_t hash[1 << CONFIG_APP_LZ_HASH_BITS];
+    uint8_t buf[LZ_WINDOW + LZ_MAX_BLOCK];
+};
+
+struct lz_decoder {
+    uint16_t hist_len;      // history at the start of buf, at most LZ_WINDOW
+    uint16_t out_len;       // last block, after the history
+    uint8_t buf[LZ_WINDOW + LZ_MAX_BLOCK];
+};
+
+/**
+ * @brief Start an encoder without history
+ */
+void lz_encoder_init(struct lz_encoder *enc);
+
+/**
+ * @brief Drop the history, the next block doesn't refer to the ones before
+ *
+ * The buffered input is kept.
+ */
+void lz_encoder_reset(struct lz_encoder *enc);
+
+/**
+ * @brief Buffer input for the next block
+ * @return Bytes taken, less than @p len once LZ_MAX_BLOCK bytes are buffered
+ */
+size_t lz_encoder_write(struct lz_encoder *enc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Bytes buffered for the next block
+ */
+static inline size_t lz_encoder_pending(const struct lz_encoder *enc)
+{
+    return enc->in_len;
+}
+
+/**
+ * @brief Compress the buffered input into one block, and add it to the history
+ *
+ * A block that would not be shorter than its input is stored instead: the
+ * input is copied to @p out as is and @p raw is set. The decoder must be
+ * told, see lz_decompress().
+ * @param enc Encoder, with at least one byte buffered
+ * @param out Output, at least lz_encoder_pending() bytes
+ * @param out_size Size of out
+ * @param raw Set if the block is stored
+ * @return Length of the block in out, -ENOSPC if out is too small, -ENODATA
+ *         if nothing is buffered
+ */
+int lz_compress(struct lz_encoder *enc, uint8_t *out, size_t out_size, bool *raw);
+
+/**
+ * @brief Start a decoder without history
+ */
+void lz_decoder_init(struct lz_decoder *dec);
+
+/**
+ * @brief Drop the history, for a block compressed after lz_encoder_reset()
+ */
+static inline void lz_decoder_reset(struct lz_decoder *dec)
+{
+    lz_decoder_init(dec);
+}
+
+/**
+ * @brief Decompress one block, and add it to the history
+ * @param dec Decoder
+ * @param in Block
+ * @param len Length of the block
+ * @param raw The block is stored, as lz_compress() told
+ * @param out Set to the decompressed data, valid until the next call
+ * @return Decompressed length, -EBADMSG if the block is malformed or refers
+ *         to data the decoder doesn't have, -EMSGSIZE if it decompresses to
+ *         more than LZ_MAX_BLOCK bytes. The history is lost on error.
+ */
+int lz_decompress(struct lz_decoder *dec, const uint8_t *in, size_t len, bool raw,
+                  const uint8_t **out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__LZ_CODEC_H
@@ -0,0 +1,480 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/slist.h>
+
+#include "app_framer.h"
+#include "app_mux.h"
+#include "app_uart.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_mux, CONFIG_APP_MUX_LOG_LEVEL);
+
+/* Frame: APP_MUX_TAG, type << 5 | channel, sequence number, acknowledgement,
+ * payload. The acknowledgement is the next sequence number the sender
+ * expects on the same channel the other way: every frame the peer sent
+ * before it is consumed, and its credit is back.
+ */
+#define MUX_CH_MASK 0x1F
+#define MUX_TYPE_SHIFT 5
+
+enum mux_type {
+    MUX_DATA,
+    MUX_ACK,        // acknowledgement only, no payload and no sequence number
+};
+
+#define MUX_FRAME_MAX (APP_MUX_HDR_LEN + CONFIG_APP_MUX_MAX_PAYLOAD)
+
+/* acknowledge once half the window is consumed, the data frames of the
+ * other direction carry the acknowledgement meanwhile */
+#define MUX_ACK_THRESHOLD MAX(1, CONFIG_APP_MUX_WINDOW / 2)
+
+struct mux_txf {
+    sys_snode_t node;
+    uint32_t ts;            // k_cycle_get_32() in app_mux_send()
+    uint16_t len;
+    uint8_t data[MUX_FRAME_MAX];
+};
+
+struct mux_chan {
+    struct app_mux_chan_cfg cfg;
+    bool open;
+
+    /* TX */
+    sys_slist_t txq;
+    struct k_sem space;     // frames the channel may still queue
+    uint8_t tx_seq;         // of the next frame
+    uint8_t peer_ack;       // the peer consumed every frame before it
+    bool stalled;           // frames wait for credit
+    uint32_t stall_ms;      // k_uptime_get_32() when the window closed
+    int32_t deficit;        // bytes the channel may send in this round
+    bool topped;            // the deficit got its quantum in this round
+
+    /* RX */
+    uint8_t rx_next;        // sequence number expected next
+    uint8_t ack_sent;       // last rx_next sent to the peer
+    bool ack_due;
+
+    struct app_mux_chan_stats stats;
+};
+
+K_MEM_SLAB_DEFINE_STATIC(mux_slab, sizeof(struct mux_txf), CONFIG_APP_MUX_TX_FRAMES, 4);
+
+static struct {
+    struct app_uart *uart;
+    struct k_spinlock lock;
+    struct k_sem kick;      // frames queued, credit back, acknowledgement due, TX done
+    size_t rr;              // round robin position
+    struct mux_chan chans[CONFIG_APP_MUX_CHANNELS];
+} mux;
+
+static inline uint8_t mux_in_flight(const struct mux_chan *c)
+{
+    return (uint8_t)(c->tx_seq - c->peer_ack);
+}
+
+static void mux_hdr(uint8_t *hdr, size_t idx, enum mux_type type, uint8_t seq)
+{
+    struct mux_chan *c = &mux.chans[idx];
+
+    hdr[0] = APP_MUX_TAG;
+    hdr[1] = (type << MUX_TYPE_SHIFT) | idx;
+    hdr[2] = seq;
+    hdr[3] = c->rx_next;
+
+    c->ack_sent = c->rx_next;
+    c->ack_due = false;
+}
+
+/* Must be called with the lock held: a frame is queued and the peer has room for it */
+static bool mux_ready_locked(struct mux_chan *c)
+{
+    if (sys_slist_is_empty(&c->txq)) {
+        return false;
+    }
+
+    if (mux_in_flight(c) >= CONFIG_APP_MUX_WINDOW) {
+        if (!c->stalled) {
+            c->stalled = true;
+            c->stall_ms = k_uptime_get_32();
+            c->stats.credit_stalls++;
+        }
+        return false;
+    }
+    return true;
+}
+
+/* Must be called with the lock held. Strict priority between the levels,
+ * deficit round robin by weight within the highest ready one.
+ */
+static struct mux_chan *mux_pick_locked(void)
+{
+    int prio = -1;
+
+    for (size_t i = 0; i < ARRAY_SIZE(mux.chans); i++) {
+        struct mux_chan *c = &mux.chans[i];
+
+        if (mux_ready_locked(c) && (prio < 0 || c->cfg.priority < prio)) {
+            prio = c->cfg.priority;
+        }
+    }
+    if (prio < 0) {
+        return NULL;
+    }
+
+    // ends: every pass tops up the deficit of each ready channel of the level
+    while (true) {
+        struct mux_chan *c = &mux.chans[mux.rr];
+
+        if (c->cfg.priority == prio && mux_ready_locked(c)) {
+            struct mux_txf *f = SYS_SLIST_PEEK_HEAD_CONTAINER(&c->txq, f, node);
+
+            if (c->deficit >= f->len) {
+                c->deficit -= f->len;
+                return c;
+            }
+            if (!c->topped) {
+                c->deficit += CONFIG_APP_MUX_QUANTUM * c->cfg.weight;
+                c->topped = true;
+                continue;
+            }
+        } else if (sys_slist_is_empty(&c->txq)) {
+            // an idle channel doesn't save up
+            c->deficit = 0;
+        }
+
+        c->topped = false;
+        mux.rr = (mux.rr + 1) % ARRAY_SIZE(mux.chans);
+    }
+}
+
+/* Must be called with the lock held */
+static struct mux_chan *mux_ack_due_locked(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(mux.chans); i++) {
+        if (mux.chans[i].ack_due) {
+            return &mux.chans[i];
+        }
+    }
+    return NULL;
+}
+
+/* The acknowledgements were lost or the peer restarted: the frames in
+ * flight are given up after CONFIG_APP_MUX_CREDIT_TIMEOUT_MS without credit.
+ */
+static bool mux_credit_expire(void)
+{
+    uint32_t now = k_uptime_get_32();
+    uint32_t expired = 0;
+    bool stalled = false;
+
+    K_SPINLOCK(&mux.lock) {
+        for (size_t i = 0; i < ARRAY_SIZE(mux.chans); i++) {
+            struct mux_chan *c = &mux.chans[i];
+
+            if (!c->stalled) {
+                continue;
+            }
+            if (now - c->stall_ms >= CONFIG_APP_MUX_CREDIT_TIMEOUT_MS) {
+                c->peer_ack = c->tx_seq;
+                c->stalled = false;
+                c->stats.credit_timeouts++;
+                expired |= BIT(i);
+            } else {
+                stalled = true;
+            }
+        }
+    }
+
+    if (expired) {
+        LOG_WRN("No credit for %u ms, taken back on channels 0x%08x",
+                CONFIG_APP_MUX_CREDIT_TIMEOUT_MS, expired);
+    }
+    return stalled;
+}
+
+/* Send the next frame, false if there is none or the staging buffer isn't empty */
+static bool mux_tx_one(void)
+{
+    uint8_t ack[APP_MUX_HDR_LEN];
+    struct mux_chan *c = NULL;
+    struct mux_txf *f = NULL;
+    int err;
+
+    // one frame on the wire and one in the staging buffer, a frame of a
+    // higher priority waits for no more than these two
+    if (app_uart_tx_queued(mux.uart) > 0) {
+        return false;
+    }
+
+    K_SPINLOCK(&mux.lock) {
+        c = mux_ack_due_locked();
+        if (c != NULL) {
+            mux_hdr(ack, c - mux.chans, MUX_ACK, 0);
+            K_SPINLOCK_BREAK;
+        }
+
+        c = mux_pick_locked();
+        if (c == NULL) {
+            K_SPINLOCK_BREAK;
+        }
+        f = CONTAINER_OF(sys_slist_get_not_empty(&c->txq), struct mux_txf, node);
+        c->stats.queued--;
+        mux_hdr(f->data, c - mux.chans, MUX_DATA, c->tx_seq++);
+    }
+
+    if (c == NULL) {
+        return false;
+    }
+
+    if (f == NULL) {
+        err = app_framer_send(mux.uart, ack, sizeof(ack));
+        if (err) {
+            // the next one carries it
+            LOG_WRN("Channel %zu: failed to send the acknowledgement: %d",
+                    (size_t)(c - mux.chans), err);
+        }
+        return true;
+    }
+
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - f->ts);
+
+    err = app_framer_send(mux.uart, f->data, f->len);
+
+    K_SPINLOCK(&mux.lock) {
+        struct app_mux_chan_stats *st = &c->stats;
+
+        if (err) {
+            st->tx_errors++;
+            K_SPINLOCK_BREAK;
+        }
+        st->tx_frames++;
+        st->tx_bytes += f->len - APP_MUX_HDR_LEN;
+        st->lat_count++;
+        st->lat_sum_us += us;
+        st->lat_min_us = MIN(st->lat_min_us, us);
+        st->lat_max_us = MAX(st->lat_max_us, us);
+    }
+    if (err) {
+        LOG_WRN("Channel %zu: failed to send %u bytes: %d", (size_t)(c - mux.chans), f->len,
+                err);
+    }
+
+    k_mem_slab_free(&mux_slab, f);
+    k_sem_give(&c->space);
+    return true;
+}
+
+static void mux_thread(void *p1, void *p2, void *p3)
+{
+    bool stalled = false;
+
+    while (true) {
+        (void)k_sem_take(&mux.kick,
+                         stalled ? K_MSEC(CONFIG_APP_MUX_CREDIT_TIMEOUT_MS) : K_FOREVER);
+
+        stalled = mux_credit_expire();
+        while (mux_tx_one()) {
+        }
+    }
+}
+
+K_THREAD_DEFINE(app_mux_tx_id, CONFIG_APP_MUX_THREAD_STACK_SIZE, mux_thread, NULL, NULL, NULL,
+                CONFIG_APP_MUX_THREAD_PRIORITY, 0, 0);
+
+/* from the UART ISR: the staging buffer went to the wire */
+static void mux_tx_done(struct app_uart *uart)
+{
+    k_sem_give(&mux.kick);
+}
+
+int app_mux_attach(struct app_uart *uart)
+{
+    if (mux.uart != NULL) {
+        return -EALREADY;
+    }
+
+    if (APP_FRAMER_MAX_ENCODED_LEN(MUX_FRAME_MAX) > app_uart_tx_buf_size(uart)) {
+        LOG_ERR("Frames of %u bytes exceed the TX buffer of %s", MUX_FRAME_MAX,
+                app_uart_name(uart));
+        return -EMSGSIZE;
+    }
+
+    (void)app_uart_tx_done_cb_register(uart, mux_tx_done);
+    mux.uart = uart;
+    return 0;
+}
+
+int app_mux_open(uint8_t ch, const struct app_mux_chan_cfg *cfg)
+{
+    if (ch >= ARRAY_SIZE(mux.chans) || cfg->weight == 0) {
+        return -EINVAL;
+    }
+
+    K_SPINLOCK(&mux.lock) {
+        mux.chans[ch].cfg = *cfg;
+        mux.chans[ch].open = true;
+    }
+    return 0;
+}
+
+int app_mux_send(uint8_t ch, const uint8_t *data, size_t len, k_timeout_t timeout)
+{
+    struct mux_chan *c;
+    struct mux_txf *f;
+
+    if (ch >= ARRAY_SIZE(mux.chans)) {
+        return -EINVAL;
+    }
+    c = &mux.chans[ch];
+
+    if (mux.uart == NULL || !c->open) {
+        return -ENOTCONN;
+    }
+    if (len > CONFIG_APP_MUX_MAX_PAYLOAD) {
+        return -EMSGSIZE;
+    }
+
+    if (k_sem_take(&c->space, timeout)) {
+        return -EAGAIN;
+    }
+    // the frames are shared, a channel can't take more than its depth
+    if (k_mem_slab_alloc(&mux_slab, (void **)&f, K_NO_WAIT)) {
+        k_sem_give(&c->space);
+        return -ENOMEM;
+    }
+
+    memcpy(&f->data[APP_MUX_HDR_LEN], data, len);
+    f->len = APP_MUX_HDR_LEN + len;
+    f->ts = k_cycle_get_32();
+
+    K_SPINLOCK(&mux.lock) {
+        sys_slist_append(&c->txq, &f->node);
+        c->stats.queued++;
+    }
+    k_sem_give(&mux.kick);
+    return 0;
+}
+
+bool app_mux_frame(struct app_uart *uart, const uint8_t *frame, size_t len)
+{
+    app_mux_rx_cb_t cb = NULL;
+    void *user_data = NULL;
+    struct mux_chan *c;
+    bool kick = false;
+
+    if (uart != mux.uart || len < APP_MUX_HDR_LEN || frame[0] != APP_MUX_TAG) {
+        return false;
+    }
+
+    size_t idx = frame[1] & MUX_CH_MASK;
+    enum mux_type type = frame[1] >> MUX_TYPE_SHIFT;
+    uint8_t seq = frame[2];
+    uint8_t ack = frame[3];
+
+    if (idx >= ARRAY_SIZE(mux.chans)) {
+        LOG_WRN("Frame on unknown channel %zu", idx);
+        return true;
+    }
+    c = &mux.chans[idx];
+
+    K_SPINLOCK(&mux.lock) {
+        // an acknowledgement outside the frames in flight is stale
+        if (ack != c->peer_ack && (uint8_t)(ack - c->peer_ack) <= mux_in_flight(c)) {
+            c->peer_ack = ack;
+            c->stalled = false;
+            kick = true;
+        }
+
+        if (type != MUX_DATA) {
+            K_SPINLOCK_BREAK;
+        }
+
+        // frames damaged on the wire are not sent again, the sequence goes on
+        if (seq != c->rx_next) {
+            c->stats.rx_lost += (uint8_t)(seq - c->rx_next);
+        }
+        c->rx_next = seq + 1;
+
+        if (c->open) {
+            cb = c->cfg.cb;
+            user_data = c->cfg.user_data;
+            c->stats.rx_frames++;
+            c->stats.rx_bytes += len - APP_MUX_HDR_LEN;
+        } else {
+            c->stats.rx_dropped++;
+        }
+    }
+
+    if (cb != NULL) {
+        cb(idx, &frame[APP_MUX_HDR_LEN], len - APP_MUX_HDR_LEN, user_data);
+    }
+
+    if (type == MUX_DATA) {
+        // consumed, the credit goes back
+        K_SPINLOCK(&mux.lock) {
+            if (!c->ack_due && (uint8_t)(c->rx_next - c->ack_sent) >= MUX_ACK_THRESHOLD) {
+                c->ack_due = true;
+                kick = true;
+            }
+        }
+    }
+
+    if (kick) {
+        k_sem_give(&mux.kick);
+    }
+    return true;
+}
+
+int app_mux_stats_get(uint8_t ch, struct app_mux_chan_stats *stats)
+{
+    if (ch >= ARRAY_SIZE(mux.chans)) {
+        return -EINVAL;
+    }
+
+    K_SPINLOCK(&mux.lock) {
+        struct mux_chan *c = &mux.chans[ch];
+
+        *stats = c->stats;
+        stats->in_flight = mux_in_flight(c);
+    }
+    if (stats->lat_count == 0) {
+        stats->lat_min_us = 0;
+    }
+    return 0;
+}
+
+static void mux_stats_reset_locked(struct mux_chan *c)
+{
+    uint32_t queued = c->stats.queued;
+
+    memset(&c->stats, 0, sizeof(c->stats));
+    c->stats.lat_min_us = UINT32_MAX;
+    c->stats.queued = queued;
+}
+
+void app_mux_stats_reset(void)
+{
+    K_SPINLOCK(&mux.lock) {
+        for (size_t i = 0; i < ARRAY_SIZE(mux.chans); i++) {
+            mux_stats_reset_locked(&mux.chans[i]);
+        }
+    }
+}
+
+static int app_mux_init(void)
+{
+    k_sem_init(&mux.kick, 0, 1);
+
+    for (size_t i = 0; i < ARRAY_SIZE(mux.chans); i++) {
+        struct mux_chan *c = &mux.chans[i];
+
+        sys_slist_init(&c->txq);
+        k_sem_init(&c->space, CONFIG_APP_MUX_TX_DEPTH, CONFIG_APP_MUX_TX_DEPTH);
+        mux_stats_reset_locked(c);
+    }
+    return 0;
+}
+
+SYS_INIT(app_mux_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
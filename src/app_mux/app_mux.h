@@ -0,0 +1,122 @@
+#ifndef __APP_MUX_H
+#define __APP_MUX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys_clock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct app_uart;
+
+/* First byte of every mux frame, tells them from the other frames of the port */
+#define APP_MUX_TAG 0xF9
+
+/* Tag, channel and type, sequence number, acknowledgement */
+#define APP_MUX_HDR_LEN 4
+
+/**
+ * @brief Data received on a channel, called from the RX context
+ *
+ * The data is only valid until the callback returns. The peer gets the
+ * credit of the frame back once it returns.
+ */
+typedef void (*app_mux_rx_cb_t)(uint8_t ch, const uint8_t *data, size_t len, void *user_data);
+
+struct app_mux_chan_cfg {
+    uint8_t priority;       // 0 is the highest, strict between the levels
+    uint8_t weight;         // share of the line among the channels of one level, 1 .. 255
+    app_mux_rx_cb_t cb;
+    void *user_data;
+};
+
+struct app_mux_chan_stats {
+    uint32_t tx_frames;
+    uint32_t tx_bytes;
+    uint32_t tx_errors;         // frames app_framer_send() failed, lost for the peer
+    uint32_t credit_stalls;     // times frames waited for the peer's credit
+    uint32_t credit_timeouts;   // credit taken back after CONFIG_APP_MUX_CREDIT_TIMEOUT_MS
+    uint32_t rx_frames;
+    uint32_t rx_bytes;
+    uint32_t rx_lost;           // gaps in the peer's sequence numbers
+    uint32_t rx_dropped;        // received on a channel that isn't open
+    /* app_mux_send() to the UART staging buffer */
+    uint32_t lat_count;
+    uint32_t lat_min_us;
+    uint32_t lat_max_us;
+    uint64_t lat_sum_us;
+    /* now */
+    uint32_t queued;            // frames waiting for their turn
+    uint32_t in_flight;         // frames sent and not acknowledged by the peer
+};
+
+/**
+ * @brief Run the multiplexer over a port
+ *
+ * Every frame sent on the channels goes through the app_framer in use, at
+ * most one of them waits in the TX staging buffer behind the one on the
+ * wire. The other app_uart_tx() users of the port share the line without
+ * being scheduled. Call it once, before opening the channels.
+ * @param uart Port
+ * @return 0 on success, -EALREADY if the multiplexer runs already
+ */
+int app_mux_attach(struct app_uart *uart);
+
+/**
+ * @brief Open a channel, or change the settings of an open one
+ *
+ * Both sides open the channels they use with the same numbers. A channel
+ * may send CONFIG_APP_MUX_WINDOW frames before the peer acknowledges them.
+ * @param ch Channel, below CONFIG_APP_MUX_CHANNELS
+ * @param cfg Priority, weight and RX callback, copied
+ * @return 0 on success, -EINVAL if ch or the weight is out of range
+ */
+int app_mux_open(uint8_t ch, const struct app_mux_chan_cfg *cfg);
+
+/**
+ * @brief Queue a frame on a channel
+ *
+ * The frames of one channel are sent in order. Between the channels, the
+ * highest priority goes first and the channels of one priority share the
+ * line by weight, a frame at a time (deficit round robin).
+ * @param ch Channel
+ * @param data Payload
+ * @param len Payload length, up to CONFIG_APP_MUX_MAX_PAYLOAD
+ * @param timeout How long to wait while CONFIG_APP_MUX_TX_DEPTH frames of
+ *        the channel are queued
+ * @return 0 on success, -EAGAIN on timeout, -ENOMEM if every TX frame is in
+ *         use, -EMSGSIZE if @p len is too long, -ENOTCONN if the channel is
+ *         not open or the multiplexer is not attached
+ */
+int app_mux_send(uint8_t ch, const uint8_t *data, size_t len, k_timeout_t timeout);
+
+/**
+ * @brief Hand a received frame to the multiplexer, from the frame callback
+ * @param uart Port the frame was received on
+ * @param frame Decoded payload
+ * @param len Payload length
+ * @return true if the frame was a mux frame and is consumed
+ */
+bool app_mux_frame(struct app_uart *uart, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Read the counters and the latency of a channel
+ * @param ch Channel
+ * @param stats Set to the statistics
+ * @return 0 on success, -EINVAL if ch is out of range
+ */
+int app_mux_stats_get(uint8_t ch, struct app_mux_chan_stats *stats);
+
+/**
+ * @brief Reset the counters and the latency of every channel
+ */
+void app_mux_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_MUX_H
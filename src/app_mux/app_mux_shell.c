@@ -0,0 +1,51 @@
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "app_mux.h"
+
+static int cmd_mux(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_mux_chan_stats st;
+
+    shell_print(sh, "%-3s %8s %8s %8s %8s %8s %6s %6s %8s %8s %8s", "ch", "tx", "tx_err",
+                "stalls", "rx", "rx_lost", "queue", "flight", "lat_min", "lat_avg", "lat_max");
+    for (uint8_t ch = 0; ch < CONFIG_APP_MUX_CHANNELS; ch++) {
+        (void)app_mux_stats_get(ch, &st);
+
+        uint32_t avg = (st.lat_count > 0) ? (uint32_t)(st.lat_sum_us / st.lat_count) : 0;
+
+        shell_print(sh, "%-3u %8u %8u %8u %8u %8u %6u %6u %8u %8u %8u", ch, st.tx_frames,
+                    st.tx_errors, st.credit_stalls, st.rx_frames, st.rx_lost, st.queued,
+                    st.in_flight, st.lat_min_us, avg, st.lat_max_us);
+    }
+    shell_print(sh, "latency in us, app_mux_send() to the UART");
+    return 0;
+}
+
+static int cmd_mux_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    app_mux_stats_reset();
+    shell_print(sh, "Statistics reset");
+    return 0;
+}
+
+static int cmd_mux_send(const struct shell *sh, size_t argc, char **argv)
+{
+    int err = app_mux_send(strtoul(argv[1], NULL, 10), (const uint8_t *)argv[2],
+                           strlen(argv[2]), K_NO_WAIT);
+
+    if (err) {
+        shell_error(sh, "Failed to send: %d", err);
+    }
+    return err;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_mux,
+    SHELL_CMD(reset, NULL, "Reset the counters and the latency", cmd_mux_reset),
+    SHELL_CMD_ARG(send, NULL, "Send a text frame <ch> <text>", cmd_mux_send, 3, 0),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(mux, &sub_mux, "Multiplexer counters and latency per channel", cmd_mux);
@@ -0,0 +1,168 @@
+#include <errno.h>
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/sys/atomic.h>
+
+#include "app_pool.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_pool, CONFIG_APP_POOL_LOG_LEVEL);
+
+#define CLASS_SIZE(n) CONFIG_APP_POOL_CLASS##n##_SIZE
+#define CLASS_COUNT(n) CONFIG_APP_POOL_CLASS##n##_COUNT
+
+BUILD_ASSERT(CLASS_SIZE(0) % 4 == 0 && CLASS_SIZE(1) % 4 == 0 && CLASS_SIZE(2) % 4 == 0,
+             "Pool block sizes must be multiples of 4");
+BUILD_ASSERT(CLASS_SIZE(0) < CLASS_SIZE(1) && CLASS_SIZE(1) < CLASS_SIZE(2),
+             "Pool block sizes must grow from class 0 to class 2");
+
+struct pool_class {
+    struct k_mem_slab slab;
+    uint8_t *buf;
+    uint32_t block_size;
+    uint32_t block_num;
+
+    atomic_t max_used;
+    atomic_t allocs;
+    atomic_t fallbacks;
+    atomic_t failures;
+};
+
+static uint8_t __aligned(4) class0_buf[CLASS_SIZE(0) * CLASS_COUNT(0)];
+static uint8_t __aligned(4) class1_buf[CLASS_SIZE(1) * CLASS_COUNT(1)];
+static uint8_t __aligned(4) class2_buf[CLASS_SIZE(2) * CLASS_COUNT(2)];
+
+/* smallest first, the search stops at the first class that fits */
+static struct pool_class classes[APP_POOL_CLASS_NUM] = {
+    { .buf = class0_buf, .block_size = CLASS_SIZE(0), .block_num = CLASS_COUNT(0) },
+    { .buf = class1_buf, .block_size = CLASS_SIZE(1), .block_num = CLASS_COUNT(1) },
+    { .buf = class2_buf, .block_size = CLASS_SIZE(2), .block_num = CLASS_COUNT(2) },
+};
+
+static struct pool_class *pool_class_of(const void *ptr)
+{
+    const uint8_t *p = ptr;
+
+    for (size_t i = 0; i < ARRAY_SIZE(classes); i++) {
+        struct pool_class *cls = &classes[i];
+
+        if (p >= cls->buf && p < cls->buf + cls->block_size * cls->block_num) {
+            return cls;
+        }
+    }
+    return NULL;
+}
+
+static void pool_max_update(struct pool_class *cls)
+{
+    atomic_val_t used = k_mem_slab_num_used_get(&cls->slab);
+    atomic_val_t max;
+
+    // lock-free, a concurrent allocation may have raised it already
+    do {
+        max = atomic_get(&cls->max_used);
+        if (used <= max) {
+            return;
+        }
+    } while (!atomic_cas(&cls->max_used, max, used));
+}
+
+void *app_pool_alloc(size_t len)
+{
+    struct pool_class *fit = NULL;
+    void *block;
+
+    for (size_t i = 0; i < ARRAY_SIZE(classes); i++) {
+        struct pool_class *cls = &classes[i];
+
+        if (len > cls->block_size) {
+            continue;
+        }
+        if (fit == NULL) {
+            fit = cls;
+        } else if (!IS_ENABLED(CONFIG_APP_POOL_FALLBACK)) {
+            break;
+        }
+
+        if (k_mem_slab_alloc(&cls->slab, &block, K_NO_WAIT) == 0) {
+            atomic_inc(&cls->allocs);
+            if (cls != fit) {
+                atomic_inc(&fit->fallbacks);
+            }
+            pool_max_update(cls);
+            return block;
+        }
+    }
+
+    if (fit == NULL) {
+        LOG_WRN("%u bytes exceed the largest pool block", (unsigned int)len);
+        return NULL;
+    }
+
+    atomic_inc(&fit->failures);
+    return NULL;
+}
+
+void app_pool_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    struct pool_class *cls = pool_class_of(ptr);
+
+    __ASSERT(cls != NULL, "Pointer does not belong to the packet pool");
+    k_mem_slab_free(&cls->slab, ptr);
+}
+
+size_t app_pool_block_size(const void *ptr)
+{
+    struct pool_class *cls = pool_class_of(ptr);
+
+    return (cls != NULL) ? cls->block_size : 0;
+}
+
+int app_pool_stats_get(size_t idx, struct app_pool_stats *stats)
+{
+    if (idx >= ARRAY_SIZE(classes)) {
+        return -EINVAL;
+    }
+
+    struct pool_class *cls = &classes[idx];
+
+    stats->block_size = cls->block_size;
+    stats->block_num = cls->block_num;
+    stats->used = k_mem_slab_num_used_get(&cls->slab);
+    stats->max_used = atomic_get(&cls->max_used);
+    stats->allocs = atomic_get(&cls->allocs);
+    stats->fallbacks = atomic_get(&cls->fallbacks);
+    stats->failures = atomic_get(&cls->failures);
+    return 0;
+}
+
+void app_pool_stats_reset(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(classes); i++) {
+        struct pool_class *cls = &classes[i];
+
+        atomic_set(&cls->max_used, k_mem_slab_num_used_get(&cls->slab));
+        atomic_clear(&cls->allocs);
+        atomic_clear(&cls->fallbacks);
+        atomic_clear(&cls->failures);
+    }
+}
+
+static int app_pool_init(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(classes); i++) {
+        struct pool_class *cls = &classes[i];
+        int err = k_mem_slab_init(&cls->slab, cls->buf, cls->block_size, cls->block_num);
+
+        __ASSERT(err == 0, "Failed to init pool class %u", (unsigned int)i);
+        (void)err;
+    }
+    return 0;
+}
+
+/* before app_uart and the application, which may allocate from their init */
+SYS_INIT(app_pool_init, POST_KERNEL, CONFIG_APPLICATION_INIT_PRIORITY);
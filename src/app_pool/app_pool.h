@@ -0,0 +1,67 @@
+#ifndef __APP_POOL_H
+#define __APP_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size classes, see Kconfig.app_pool */
+#define APP_POOL_CLASS_NUM 3
+
+/* Largest packet the pool can hold */
+#define APP_POOL_MAX_LEN CONFIG_APP_POOL_CLASS2_SIZE
+
+/* Usage of one size class */
+struct app_pool_stats {
+    uint32_t block_size;
+    uint32_t block_num;
+    uint32_t used;          // blocks allocated now
+    uint32_t max_used;      // high-water mark of used
+    uint32_t allocs;        // blocks handed out by this class
+    uint32_t fallbacks;     // requests of this class served by a larger one
+    uint32_t failures;      // requests of this class that found every class full
+};
+
+/**
+ * @brief Allocate a packet buffer, ISR safe, never waits
+ *
+ * The buffer is a block of the smallest class len fits in, or of a larger
+ * class if that one is full and CONFIG_APP_POOL_FALLBACK is enabled.
+ * @param len Packet length, at most APP_POOL_MAX_LEN
+ * @return Buffer of at least len bytes, NULL if no block is free or len is too big
+ */
+void *app_pool_alloc(size_t len);
+
+/**
+ * @brief Return a buffer of app_pool_alloc(), ISR safe
+ * @param ptr Buffer, NULL is ignored
+ */
+void app_pool_free(void *ptr);
+
+/**
+ * @brief Usable size of a buffer of app_pool_alloc()
+ * @return Block size of the class the buffer belongs to, 0 if it is not a pool buffer
+ */
+size_t app_pool_block_size(const void *ptr);
+
+/**
+ * @brief Read the usage of a size class
+ * @param cls Class index, below APP_POOL_CLASS_NUM
+ * @param stats Set to the usage
+ * @return 0 on success, -EINVAL if cls is out of range
+ */
+int app_pool_stats_get(size_t cls, struct app_pool_stats *stats);
+
+/**
+ * @brief Reset the counters of every class, max_used restarts from used
+ */
+void app_pool_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_POOL_H
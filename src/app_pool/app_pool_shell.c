@@ -0,0 +1,32 @@
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+
+#include "app_pool.h"
+
+static int cmd_pool(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_pool_stats stats;
+
+    shell_print(sh, "%-6s %6s %9s %9s %9s %9s %9s", "block", "blocks", "used", "max_used",
+                "allocs", "fallbacks", "failures");
+    for (size_t i = 0; i < APP_POOL_CLASS_NUM; i++) {
+        app_pool_stats_get(i, &stats);
+        shell_print(sh, "%-6u %6u %9u %9u %9u %9u %9u", stats.block_size, stats.block_num,
+                    stats.used, stats.max_used, stats.allocs, stats.fallbacks, stats.failures);
+    }
+    return 0;
+}
+
+static int cmd_pool_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    app_pool_stats_reset();
+    shell_print(sh, "Statistics reset");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_pool,
+    SHELL_CMD(reset, NULL, "Reset the usage statistics", cmd_pool_reset),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(pool, &sub_pool, "Serial packet pool usage per size class", cmd_pool);
@@ -1,4 +1,3 @@
-
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
@@ -6,308 +5,2491 @@
 #include <zephyr/pm/device.h>
 #include <string.h>
 
-#if IS_ENABLED(CONFIG_APP_UART_GPIO_CROSS_DOMAIN)
-/* For NCS v3.0.x */
-// #include <nrfx_power.h>
-/* For NCS v3.1.x - latest */
-#include <nrf_sys_event.h>
-#endif /* CONFIG_APP_UART_GPIO_CROSS_DOMAIN */
+#if IS_ENABLED(CONFIG_APP_UART_GPIO_CROSS_DOMAIN)
+/* For NCS v3.0.x */
+// #include <nrfx_power.h>
+/* For NCS v3.1.x - latest */
+#include <nrf_sys_event.h>
+#endif /* CONFIG_APP_UART_GPIO_CROSS_DOMAIN */
+
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+#include <zephyr/drivers/gpio.h>
+#endif
+
+#include "app_uart.h"
+#include "spsc_ring.h"
+#include "app_uart_stats.h"
+#include "app_uart_trace.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(app_uart, CONFIG_APP_UART_LOG_LEVEL);
+
+#define RX_INACTIVE_TIMEOUT_US 1000000
+
+/* baud rate switch, see app_uart_set_baudrate() */
+#define TX_DRAIN_TIMEOUT K_MSEC(1000)
+#define RX_STOP_TIMEOUT K_MSEC(100)
+
+#if IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
+/* USB CDC ACM */
+#include <uart_async_adapter.h>
+#endif /* CONFIG_UART_ASYNC_ADAPTER */
+
+/* TX staging buffers for DMA.
+ * While one of them is on the wire, app_uart_tx() packs data into the other one,
+ * which is started from the UART_TX_DONE event.
+ */
+struct tx_buf {
+    uint8_t *data;
+    size_t len;
+};
+
+/* RX DMA block exhaustion.
+ * A UART_RX_BUF_REQUEST that finds the slab empty is declined, the driver
+ * then disables RX once the current block is full, and the RX context
+ * enables it again as soon as a block comes back.
+ */
+enum {
+    RX_STARVED,     // a buffer request was declined
+    RX_REARM,       // RX was disabled while starved, the RX context has to enable it
+};
+
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+/* Idle power management, see pm_idle_handler() */
+enum {
+    PM_ACTIVE,
+    PM_SUSPENDED,   // RX off and the device suspended, TX waits in the staging buffer
+    PM_RESUMING,    // pm_resume_work submitted
+};
+
+struct pm_counters {
+    int64_t since;              // uptime of the last change between active and suspended
+    uint64_t active_ms;
+    uint64_t suspended_ms;
+    uint32_t suspends;
+    uint32_t rx_wakeups;
+    uint32_t tx_wakeups;
+    uint32_t resume_count;
+    uint32_t resume_us_max;
+    uint64_t resume_us_sum;
+    uint32_t first_byte_count;
+    uint32_t first_byte_us_max;
+    uint64_t first_byte_us_sum;
+};
+#endif /* CONFIG_APP_UART_PM_IDLE */
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ADAPTIVE)
+/* Traffic of the current period, see rx_adapt_handler() */
+struct rx_adapt {
+    atomic_t bytes;
+    atomic_t events;            // UART_RX_RDY
+    int64_t since;
+    uint32_t bytes_per_sec;     // last period
+    uint32_t events_per_sec;
+    uint32_t len_changes;
+    uint32_t restarts;
+};
+#endif /* CONFIG_APP_UART_RX_ADAPTIVE */
+
+struct app_uart {
+    /* serial device */
+    const struct device *dev;
+#if IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
+    const struct device *const *adapter;
+#endif
+    uint8_t index;
+
+    /* uart rx memory pool for DMA */
+    struct k_mem_slab slab;
+    uint8_t *slab_buf;
+    size_t block_size;
+    uint32_t block_num;
+    atomic_t rx_flags;
+    struct k_sem rx_stopped;    // given on UART_RX_DISABLED
+
+    /* RX operating point, the driver fills rx_len bytes of each block */
+    size_t rx_len;
+    uint32_t rx_timeout_us;
+    struct k_mutex rx_ctl;      // serializes stopping and starting RX
+    bool rx_off;                // suspended, RX is not started again
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ADAPTIVE)
+    struct k_work_delayable rx_adapt_work;
+    struct rx_adapt adapt;
+#endif
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+    /* Frame boundaries at line idle, see rx_gap_chunk_start() */
+    uint32_t gap_dt_baudrate;   // current-speed, if the rate can't be read at run time
+    uint32_t gap_char_cyc;      // one character
+    uint32_t gap_timeout_cyc;   // the RX timeout
+    uint32_t gap_wait_us;       // see rx_gap_expiry()
+    struct k_timer gap_timer;
+    struct k_spinlock gap_lock;
+    bool gap_pending;           // the last chunk filled its block, the frame may go on
+    uint32_t gap_full_cyc;      // when that chunk was reported
+    bool rx_frame_end;          // the chunk being dispatched ends a frame
+#if !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    /* ring positions where frames end, pushed under gap_lock */
+    uint32_t gap_marks[CONFIG_APP_UART_RX_FRAME_GAP_MARKS];
+    atomic_t gap_mark_head;
+    atomic_t gap_mark_tail;
+#endif
+#endif /* CONFIG_APP_UART_RX_FRAME_GAP */
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    /* Reference count of each slab block.
+     * The UART driver holds one reference from allocation until UART_RX_BUF_RELEASED,
+     * and every view handed to the consumer holds one more.
+     */
+    atomic_t *block_refs;
+    rx_view_cb_t view_callback;
+#if IS_ENABLED(CONFIG_APP_UART_RX_SUBSCRIBERS)
+    /* in subscription order, see rx_sub_publish() */
+    struct app_uart_rx_sub *subs[CONFIG_APP_UART_RX_SUBSCRIBERS_MAX];
+    size_t sub_num;
+    struct k_mutex sub_lock;
+    struct k_condvar sub_done;      // a blocked put of rx_sub_publish() ended
+#endif
+#else
+    /* RX bytes are copied from the DMA block into the ring by the ISR */
+    struct spsc_ring *ring;
+#endif
+    packets_cb_t user_callback;
+
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+    /* Interrupt-driven backend for the devices without async API, see irq_callback() */
+    bool irq_mode;
+    uint8_t *irq_rx_buf;        // block being filled, NULL while RX is disabled
+    uint8_t *irq_rx_next;       // block provided on UART_RX_BUF_REQUEST
+    size_t irq_rx_len;          // bytes already read into irq_rx_buf
+    size_t irq_rx_cap;          // rx_len when irq_rx_buf was started
+    const uint8_t *irq_tx_buf;  // staging buffer being written into the FIFO
+    size_t irq_tx_len;
+    size_t irq_tx_off;
+#endif
+
+    /* TX staging */
+    struct tx_buf tx_bufs[2];
+    struct tx_buf *tx_fill;
+    size_t tx_buf_size;
+    bool tx_busy;
+    struct k_spinlock tx_lock;
+    uint32_t tx_start_ts;
+    tx_done_cb_t tx_done_callback;
+    struct k_sem tx_settled;        // TX may have gone idle, see app_uart_tx_drain()
+
+    /* Open reservation in tx_fill, see app_uart_tx_reserve() */
+    bool tx_rsv_open;
+    size_t tx_rsv_off;
+    size_t tx_rsv_len;
+
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+    /* One frame per staging buffer, see tx_gap_expiry() */
+    struct k_timer tx_gap_timer;
+    uint32_t tx_gap_us;         // the gap and the character still shifting out at UART_TX_DONE
+    bool tx_gap;                // the gap after the last frame is running
+#endif
+
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+    struct gpio_dt_spec wake;   // RX pin as GPIO, no port if the node has no wake-gpios
+    struct gpio_callback wake_cb;
+    struct k_work_delayable pm_idle_work;
+    struct k_work pm_resume_work;
+    atomic_t pm_state;
+    atomic_t pm_last_activity;  // k_uptime_get_32() of the last RX or TX
+    uint32_t pm_wake_cyc;       // cycle stamp of the resume request
+    bool pm_wake_rx;            // the resume request came from the wake GPIO
+    bool pm_first_byte;         // waiting for the first byte after an RX wake-up
+    struct pm_counters pm;
+    struct k_spinlock pm_lock;
+#endif
+
+#if IS_ENABLED(CONFIG_APP_UART_STATS)
+    /* Timestamps of the oldest chunk not yet dequeued by the RX context */
+    struct {
+        bool valid;
+        uint32_t rdy;
+        uint32_t enqueued;
+    } rx_pending;
+    struct k_spinlock rx_pending_lock;
+    /* UART_RX_RDY of the chunk being dispatched, see app_uart_rx_rdy_ts() */
+    bool rx_rdy_valid;
+    uint32_t rx_rdy;
+#endif /* CONFIG_APP_UART_STATS */
+};
+
+/* per port sizes, from the "app,uart" node or Kconfig */
+#define RX_BLOCK_SIZE(cfg) DT_PROP_OR(cfg, rx_block_size, CONFIG_APP_UART_RX_DMA_BLOCK_SIZE)
+#define RX_BLOCK_NUM(cfg) DT_PROP_OR(cfg, rx_block_number, CONFIG_APP_UART_RX_DMA_BLOCK_NUMBER)
+#define TX_BUF_SIZE(cfg) DT_PROP_OR(cfg, tx_buf_size, CONFIG_APP_UART_TX_BUF_SIZE)
+#define RX_RING_SIZE(cfg) DT_PROP_OR(cfg, rx_ring_size, CONFIG_APP_UART_RX_RING_SIZE)
+
+#define PORT_SYM(serial, suffix) _CONCAT(APP_UART_NAME(serial), suffix)
+
+#define APP_UART_DEFINE(serial, cfg)                                                    \
+    static uint8_t __aligned(4) PORT_SYM(serial, _slab_buf)                             \
+        [RX_BLOCK_NUM(cfg) * RX_BLOCK_SIZE(cfg)];                                       \
+    static uint8_t PORT_SYM(serial, _tx_data)[2][TX_BUF_SIZE(cfg)];                     \
+    IF_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY,                                            \
+               (static atomic_t PORT_SYM(serial, _refs)[RX_BLOCK_NUM(cfg)];))           \
+    COND_CODE_1(CONFIG_APP_UART_RX_ZERO_COPY, (),                                       \
+                (BUILD_ASSERT(IS_POWER_OF_TWO(RX_RING_SIZE(cfg)),                       \
+                              "RX ring size must be a power of two");                   \
+                 static uint8_t PORT_SYM(serial, _ring_buf)[RX_RING_SIZE(cfg)];         \
+                 static struct spsc_ring PORT_SYM(serial, _ring) = {                    \
+                     .buf = PORT_SYM(serial, _ring_buf),                                \
+                     .size = RX_RING_SIZE(cfg),                                         \
+                 };))                                                                   \
+    IF_ENABLED(CONFIG_UART_ASYNC_ADAPTER,                                               \
+               (UART_ASYNC_ADAPTER_INST_DEFINE(PORT_SYM(serial, _adapter));))           \
+    struct app_uart APP_UART_NAME(serial) = {                                           \
+        .dev = DEVICE_DT_GET(serial),                                                   \
+        IF_ENABLED(CONFIG_UART_ASYNC_ADAPTER,                                           \
+                   (.adapter = &PORT_SYM(serial, _adapter),))                           \
+        .slab_buf = PORT_SYM(serial, _slab_buf),                                        \
+        .block_size = RX_BLOCK_SIZE(cfg),                                               \
+        .block_num = RX_BLOCK_NUM(cfg),                                                 \
+        .rx_len = RX_BLOCK_SIZE(cfg),                                                   \
+        .rx_timeout_us = RX_INACTIVE_TIMEOUT_US,                                        \
+        COND_CODE_1(CONFIG_APP_UART_RX_ZERO_COPY,                                       \
+                    (.block_refs = PORT_SYM(serial, _refs),),                           \
+                    (.ring = &PORT_SYM(serial, _ring),))                                \
+        .tx_bufs = {                                                                    \
+            { .data = PORT_SYM(serial, _tx_data)[0] },                                  \
+            { .data = PORT_SYM(serial, _tx_data)[1] },                                  \
+        },                                                                              \
+        .tx_fill = &APP_UART_NAME(serial).tx_bufs[0],                                   \
+        .tx_buf_size = TX_BUF_SIZE(cfg),                                                \
+        IF_ENABLED(CONFIG_APP_UART_PM_IDLE,                                             \
+                   (.wake = GPIO_DT_SPEC_GET_OR(cfg, wake_gpios, {0}),))                \
+        IF_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP,                                        \
+                   (.gap_dt_baudrate = DT_PROP_OR(serial, current_speed, 0),))          \
+    };
+
+APP_UART_FOREACH(APP_UART_DEFINE)
+
+#define APP_UART_PTR(serial, cfg) &APP_UART_NAME(serial),
+
+static struct app_uart *const ports[] = {
+    APP_UART_FOREACH(APP_UART_PTR)
+};
+
+struct app_uart *app_uart_at(size_t idx)
+{
+    return (idx < ARRAY_SIZE(ports)) ? ports[idx] : NULL;
+}
+
+size_t app_uart_index(const struct app_uart *uart)
+{
+    return uart->index;
+}
+
+const char *app_uart_name(const struct app_uart *uart)
+{
+    return uart->dev->name;
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+static void pm_request_resume(struct app_uart *uart, bool rx);
+
+static inline void pm_touch(struct app_uart *uart)
+{
+    atomic_set(&uart->pm_last_activity, k_uptime_get_32());
+}
+
+/* TX is held back while the port is not running */
+static inline bool pm_held(struct app_uart *uart)
+{
+    return atomic_get(&uart->pm_state) != PM_ACTIVE;
+}
+
+static inline void pm_tx_activity(struct app_uart *uart)
+{
+    pm_touch(uart);
+    if (pm_held(uart)) {
+        pm_request_resume(uart, false);
+    }
+}
+
+/* ISR */
+static inline void pm_rx_activity(struct app_uart *uart)
+{
+    pm_touch(uart);
+    if (!uart->pm_first_byte) {
+        return;
+    }
+
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - uart->pm_wake_cyc);
+
+    uart->pm_first_byte = false;
+    K_SPINLOCK(&uart->pm_lock) {
+        uart->pm.first_byte_count++;
+        uart->pm.first_byte_us_sum += us;
+        uart->pm.first_byte_us_max = MAX(uart->pm.first_byte_us_max, us);
+    }
+}
+#else
+static inline bool pm_held(struct app_uart *uart)
+{
+    return false;
+}
+
+static inline void pm_tx_activity(struct app_uart *uart) {}
+static inline void pm_rx_activity(struct app_uart *uart) {}
+#endif /* CONFIG_APP_UART_PM_IDLE */
+
+/* ISR: traffic seen by the adaptive RX operating point */
+static inline void rx_adapt_account(struct app_uart *uart, size_t len)
+{
+#if IS_ENABLED(CONFIG_APP_UART_RX_ADAPTIVE)
+    atomic_add(&uart->adapt.bytes, len);
+    atomic_inc(&uart->adapt.events);
+#endif
+}
+
+/* all the ports share the RX context, a thread or a work item */
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+K_MSGQ_DEFINE(rx_queue, sizeof(struct app_uart_rx_view), 16 * APP_UART_NUM, 4);
+#endif
+
+/* retry period of a rearm while the application still holds every block */
+#define RX_REARM_RETRY K_MSEC(1)
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_WORKQUEUE)
+static void rx_work_handler(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(rx_work, rx_work_handler);
+#elif !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+static K_SEM_DEFINE(rx_ready, 0, 1);
+#endif
+
+/* wake up the RX context, ISR safe */
+static inline void rx_kick(void)
+{
+#if IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_WORKQUEUE)
+    k_work_reschedule(&rx_work, K_NO_WAIT);
+#elif !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    k_sem_give(&rx_ready);
+#endif
+    // the zero-copy RX thread is woken up by the queue itself
+}
+
+static size_t rx_block_index(struct app_uart *uart, const uint8_t *block)
+{
+    return (block - uart->slab_buf) / uart->block_size;
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+static atomic_t *rx_block_ref(struct app_uart *uart, const uint8_t *block)
+{
+    size_t idx = rx_block_index(uart, block);
+
+    __ASSERT(idx < uart->block_num, "Pointer does not belong to the RX slab");
+    return &uart->block_refs[idx];
+}
+
+static void rx_block_unref(struct app_uart *uart, uint8_t *block)
+{
+    // the last one returns the block to the slab
+    if (atomic_dec(rx_block_ref(uart, block)) == 1) {
+        k_mem_slab_free(&uart->slab, (void *)block);
+    }
+}
+
+void app_uart_rx_view_hold(const struct app_uart_rx_view *view)
+{
+    // a frame end alone has no block
+    if (view->buf != NULL) {
+        atomic_inc(rx_block_ref(view->uart, view->buf));
+    }
+}
+
+void app_uart_rx_view_release(const struct app_uart_rx_view *view)
+{
+    if (view->buf != NULL) {
+        rx_block_unref(view->uart, view->buf);
+    }
+}
+
+void app_uart_rx_block_stats_get(struct app_uart *uart, struct app_uart_rx_block_stats *stats)
+{
+    stats->block_num = uart->block_num;
+    stats->block_size = uart->block_size;
+    stats->used = k_mem_slab_num_used_get(&uart->slab);
+#if defined(CONFIG_MEM_SLAB_TRACE_MAX_UTILIZATION)
+    stats->high_watermark = k_mem_slab_max_used_get(&uart->slab);
+#else
+    stats->high_watermark = 0;
+#endif
+}
+
+void app_uart_rx_block_stats_reset(struct app_uart *uart)
+{
+#if defined(CONFIG_MEM_SLAB_TRACE_MAX_UTILIZATION)
+    (void)k_mem_slab_runtime_stats_reset_max(&uart->slab);
+#endif
+}
+#else
+void app_uart_rx_ring_stats_get(struct app_uart *uart, struct app_uart_rx_ring_stats *stats)
+{
+    stats->size = uart->ring->size;
+    stats->used = spsc_ring_used(uart->ring);
+    stats->high_watermark = uart->ring->high_watermark;
+    stats->overflows = uart->ring->overflows;
+    stats->dropped_bytes = uart->ring->dropped_bytes;
+}
+#endif /* CONFIG_APP_UART_RX_ZERO_COPY */
+
+static int rx_buf_alloc(struct app_uart *uart, uint8_t **buf, k_timeout_t timeout)
+{
+    int err = k_mem_slab_alloc(&uart->slab, (void **)buf, timeout);
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    if (!err) {
+        // reference of the UART driver
+        atomic_set(rx_block_ref(uart, *buf), 1);
+    }
+#endif
+    return err;
+}
+
+static void rx_buf_free(struct app_uart *uart, uint8_t *buf)
+{
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    rx_block_unref(uart, buf);
+#else
+    k_mem_slab_free(&uart->slab, (void *)buf);
+#endif
+}
+
+static void rx_pending_mark(struct app_uart *uart, uint32_t rdy, uint32_t enqueued)
+{
+#if IS_ENABLED(CONFIG_APP_UART_STATS)
+    app_uart_stats_stage(uart->index, APP_UART_STAGE_RX_ISR, rdy, enqueued);
+
+    K_SPINLOCK(&uart->rx_pending_lock) {
+        if (!uart->rx_pending.valid) {
+            uart->rx_pending.valid = true;
+            uart->rx_pending.rdy = rdy;
+            uart->rx_pending.enqueued = enqueued;
+        }
+    }
+#endif
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+/* Frame boundaries at line idle.
+ * The RX timeout is the gap, so a chunk reported before its block is full
+ * ends a frame. A chunk that fills its block may go on in the next one,
+ * whose timing tells: sent back to back, it comes its own length and the
+ * timeout after the full block, a gap delays it by the gap. If no chunk
+ * comes at all, the gap timer ends the frame.
+ */
+#if !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_APP_UART_RX_FRAME_GAP_MARKS),
+             "Frame end queue size must be a power of two");
+#endif
+
+static inline bool port_irq_mode(struct app_uart *uart);
+
+/* Gap and timings at the current line settings, before RX starts */
+static void rx_gap_update(struct app_uart *uart)
+{
+    uint32_t baud = uart->gap_dt_baudrate;
+    // start, 8 data, parity or a second stop bit, stop: Modbus RTU
+    uint32_t bits = 11;
+    uint32_t char_us, gap_us;
+
+#if IS_ENABLED(CONFIG_UART_USE_RUNTIME_CONFIGURE)
+    struct uart_config cfg;
+
+    if (uart_config_get(uart->dev, &cfg) == 0) {
+        baud = cfg.baudrate;
+        bits = 1 + (cfg.data_bits + 5) + (cfg.parity != UART_CFG_PARITY_NONE) +
+               (cfg.stop_bits >= UART_CFG_STOP_BITS_1_5 ? 2 : 1);
+    }
+#endif
+
+    char_us = baud ? DIV_ROUND_UP(bits * USEC_PER_SEC, baud) : 0;
+    gap_us = MAX(char_us * CONFIG_APP_UART_RX_FRAME_GAP_X10 / 10,
+                 CONFIG_APP_UART_RX_FRAME_GAP_MIN_US);
+
+    uart->rx_timeout_us = gap_us;
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+    uart->tx_gap_us = gap_us + char_us;
+#endif
+    uart->gap_char_cyc = k_us_to_cyc_ceil32(char_us);
+    uart->gap_timeout_cyc = k_us_to_cyc_ceil32(gap_us);
+    // a byte received within the gap after a full block is reported by then
+    uart->gap_wait_us = gap_us + uart->rx_len * char_us + gap_us + gap_us / 2;
+    if (port_irq_mode(uart)) {
+        // every byte is reported as soon as it is read from the FIFO
+        uart->gap_wait_us = gap_us + gap_us / 2;
+    }
+}
+
+/* ISR, with gap_lock held: a frame ends at the current position */
+static void rx_gap_mark(struct app_uart *uart, bool late)
+{
+    app_uart_trace(uart->index, APP_UART_TRACE_RX_FRAME_END, late);
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    struct app_uart_rx_view end = {
+        .uart = uart,
+        .flags = APP_UART_RX_FRAME_END,
+    };
+
+    if (k_msgq_put(&rx_queue, &end, K_NO_WAIT)) {
+        LOG_WRN("%s: RX queue full, frame end lost", uart->dev->name);
+    }
+#else
+    uint32_t head = atomic_get(&uart->gap_mark_head);
+
+    if (head - (uint32_t)atomic_get(&uart->gap_mark_tail) == ARRAY_SIZE(uart->gap_marks)) {
+        LOG_WRN("%s: too many frame ends queued, frames merge", uart->dev->name);
+        return;
+    }
+    uart->gap_marks[head & (ARRAY_SIZE(uart->gap_marks) - 1)] = atomic_get(&uart->ring->head);
+    atomic_set(&uart->gap_mark_head, head + 1);
+#endif
+}
+
+/* ISR, before a chunk is queued: ends the frame of the previous full block
+ * if the line went idle in between
+ */
+static void rx_gap_chunk_start(struct app_uart *uart, size_t len, bool full)
+{
+    K_SPINLOCK(&uart->gap_lock) {
+        if (!uart->gap_pending) {
+            K_SPINLOCK_BREAK;
+        }
+        uart->gap_pending = false;
+        k_timer_stop(&uart->gap_timer);
+
+        uint32_t back_to_back = uart->gap_char_cyc * len + (full ? 0 : uart->gap_timeout_cyc);
+        uint32_t margin = uart->gap_timeout_cyc / 2;
+
+        if (k_cycle_get_32() - uart->gap_full_cyc > back_to_back + margin) {
+            rx_gap_mark(uart, true);
+        }
+    }
+}
+
+/* ISR, after a chunk is queued */
+static void rx_gap_chunk_end(struct app_uart *uart, bool full)
+{
+    K_SPINLOCK(&uart->gap_lock) {
+        if (!full) {
+#if !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+            // the zero-copy view carries the flag itself
+            rx_gap_mark(uart, false);
+#endif
+            K_SPINLOCK_BREAK;
+        }
+        uart->gap_pending = true;
+        uart->gap_full_cyc = k_cycle_get_32();
+        k_timer_start(&uart->gap_timer, K_USEC(uart->gap_wait_us), K_NO_WAIT);
+    }
+}
+
+static void rx_gap_expiry(struct k_timer *timer)
+{
+    struct app_uart *uart = CONTAINER_OF(timer, struct app_uart, gap_timer);
+    bool ended = false;
+
+    K_SPINLOCK(&uart->gap_lock) {
+        if (uart->gap_pending) {
+            uart->gap_pending = false;
+            rx_gap_mark(uart, true);
+            ended = true;
+        }
+    }
+    if (ended) {
+        rx_kick();
+    }
+}
+#endif /* CONFIG_APP_UART_RX_FRAME_GAP */
+
+bool app_uart_rx_frame_end(const struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+    return uart->rx_frame_end;
+#else
+    return false;
+#endif
+}
+
+int app_uart_rx_rdy_ts(const struct app_uart *uart, uint32_t *cycles)
+{
+#if IS_ENABLED(CONFIG_APP_UART_STATS)
+    if (!uart->rx_rdy_valid) {
+        return -ENODATA;
+    }
+    *cycles = uart->rx_rdy;
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+uint32_t app_uart_frame_gap_us(const struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+    return uart->rx_timeout_us;
+#else
+    return 0;
+#endif
+}
+
+static void uart_callback(const struct device *dev, struct uart_event *evt, void *user_data);
+
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+/* Native backend for USB CDC ACM.
+ * The CDC ACM class only has the interrupt-driven API. Instead of wrapping it
+ * in uart_async_adapter, every chunk is read from the class FIFO straight into
+ * the current RX block and reported at once, without an RX timeout, and TX
+ * fills the FIFO from the staging buffer. The same async events are then fed
+ * to uart_callback(), so the rest of app_uart doesn't know the difference.
+ */
+static void irq_emit(struct app_uart *uart, struct uart_event *evt)
+{
+    uart_callback(uart->dev, evt, uart);
+}
+
+static void irq_rx_block_start(struct app_uart *uart, uint8_t *buf)
+{
+    struct uart_event evt = {
+        .type = UART_RX_BUF_REQUEST,
+    };
+
+    uart->irq_rx_buf = buf;
+    uart->irq_rx_len = 0;
+    // a new length takes effect with the next block, as with uart_rx_buf_rsp()
+    uart->irq_rx_cap = uart->rx_len;
+
+    // the next block is requested early, as an async driver does
+    irq_emit(uart, &evt);
+}
+
+static void irq_rx_block_done(struct app_uart *uart)
+{
+    uint8_t *next = uart->irq_rx_next;
+    struct uart_event evt = {
+        .type = UART_RX_BUF_RELEASED,
+        .data.rx_buf.buf = uart->irq_rx_buf,
+    };
+
+    uart->irq_rx_next = NULL;
+    uart->irq_rx_buf = NULL;
+    irq_emit(uart, &evt);
+
+    if (next != NULL) {
+        irq_rx_block_start(uart, next);
+        return;
+    }
+
+    // the request was declined, the rest stays in the class FIFO
+    uart_irq_rx_disable(uart->dev);
+    evt.type = UART_RX_DISABLED;
+    irq_emit(uart, &evt);
+}
+
+static void irq_rx(struct app_uart *uart)
+{
+    while (uart->irq_rx_buf != NULL) {
+        size_t off = uart->irq_rx_len;
+        int n = uart_fifo_read(uart->dev, &uart->irq_rx_buf[off], uart->irq_rx_cap - off);
+
+        if (n <= 0) {
+            return;
+        }
+
+        struct uart_event evt = {
+            .type = UART_RX_RDY,
+            .data.rx = {
+                .buf = uart->irq_rx_buf,
+                .offset = off,
+                .len = n,
+            },
+        };
+
+        uart->irq_rx_len += n;
+        irq_emit(uart, &evt);
+
+        if (uart->irq_rx_len == uart->irq_rx_cap) {
+            irq_rx_block_done(uart);
+        }
+    }
+
+    uart_irq_rx_disable(uart->dev);
+}
+
+static void irq_tx(struct app_uart *uart)
+{
+    if (uart->irq_tx_buf == NULL) {
+        uart_irq_tx_disable(uart->dev);
+        return;
+    }
+
+    int n = uart_fifo_fill(uart->dev, &uart->irq_tx_buf[uart->irq_tx_off],
+                           uart->irq_tx_len - uart->irq_tx_off);
+
+    if (n > 0) {
+        uart->irq_tx_off += n;
+    }
+    if (uart->irq_tx_off < uart->irq_tx_len) {
+        return;
+    }
+
+    struct uart_event evt = {
+        .type = UART_TX_DONE,
+        .data.tx = {
+            .buf = uart->irq_tx_buf,
+            .len = uart->irq_tx_len,
+        },
+    };
+
+    // cleared first, UART_TX_DONE may start the next staging buffer
+    uart->irq_tx_buf = NULL;
+    uart_irq_tx_disable(uart->dev);
+    irq_emit(uart, &evt);
+}
+
+static void irq_callback(const struct device *dev, void *user_data)
+{
+    struct app_uart *uart = user_data;
+
+    while (uart_irq_update(dev) && uart_irq_is_pending(dev)) {
+        if (uart_irq_rx_ready(dev)) {
+            irq_rx(uart);
+        }
+        if (uart_irq_tx_ready(dev)) {
+            irq_tx(uart);
+        }
+    }
+}
+
+static int irq_rx_enable(struct app_uart *uart, uint8_t *buf)
+{
+    if (uart->irq_rx_buf != NULL) {
+        return -EBUSY;
+    }
+
+    irq_rx_block_start(uart, buf);
+    uart_irq_rx_enable(uart->dev);
+    return 0;
+}
+
+static int irq_rx_disable(struct app_uart *uart)
+{
+    struct uart_event evt = {
+        .type = UART_RX_BUF_RELEASED,
+    };
+
+    if (uart->irq_rx_buf == NULL) {
+        return -EFAULT;
+    }
+
+    uart_irq_rx_disable(uart->dev);
+
+    // every byte read was reported already
+    evt.data.rx_buf.buf = uart->irq_rx_buf;
+    uart->irq_rx_buf = NULL;
+    irq_emit(uart, &evt);
+
+    if (uart->irq_rx_next != NULL) {
+        evt.data.rx_buf.buf = uart->irq_rx_next;
+        uart->irq_rx_next = NULL;
+        irq_emit(uart, &evt);
+    }
+
+    evt.type = UART_RX_DISABLED;
+    irq_emit(uart, &evt);
+    return 0;
+}
+
+static int irq_tx_start(struct app_uart *uart, const uint8_t *buf, size_t len)
+{
+    if (uart->irq_tx_buf != NULL) {
+        return -EBUSY;
+    }
+
+    uart->irq_tx_buf = buf;
+    uart->irq_tx_len = len;
+    uart->irq_tx_off = 0;
+    uart_irq_tx_enable(uart->dev);
+    return 0;
+}
+#endif /* CONFIG_APP_UART_CDC_ACM_NATIVE */
+
+/* async API or the native backend */
+static inline bool port_irq_mode(struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+    return uart->irq_mode;
+#else
+    return false;
+#endif
+}
+
+static int port_rx_enable(struct app_uart *uart, uint8_t *buf)
+{
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+    if (uart->irq_mode) {
+        return irq_rx_enable(uart, buf);
+    }
+#endif
+    return uart_rx_enable(uart->dev, buf, uart->rx_len, uart->rx_timeout_us);
+}
+
+static int port_rx_buf_rsp(struct app_uart *uart, uint8_t *buf)
+{
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+    if (uart->irq_mode) {
+        uart->irq_rx_next = buf;
+        return 0;
+    }
+#endif
+    return uart_rx_buf_rsp(uart->dev, buf, uart->rx_len);
+}
+
+static int port_rx_disable(struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+    if (uart->irq_mode) {
+        return irq_rx_disable(uart);
+    }
+#endif
+    return uart_rx_disable(uart->dev);
+}
+
+static int port_tx(struct app_uart *uart, const uint8_t *buf, size_t len)
+{
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+    if (uart->irq_mode) {
+        return irq_tx_start(uart, buf, len);
+    }
+#endif
+    return uart_tx(uart->dev, buf, len, 0);
+}
+
+static void rx_rearm_request(struct app_uart *uart)
+{
+    if (!atomic_test_and_clear_bit(&uart->rx_flags, RX_STARVED)) {
+        return;
+    }
+    atomic_set_bit(&uart->rx_flags, RX_REARM);
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY) && IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_THREAD)
+    // an empty view only wakes up the RX thread,
+    // if the queue is full the thread is busy anyway
+    struct app_uart_rx_view wake = {
+        .uart = uart,
+    };
+
+    (void)k_msgq_put(&rx_queue, &wake, K_NO_WAIT);
+#else
+    rx_kick();
+#endif
+}
+
+/**
+ * RX context: enable RX again after exhaustion, without waiting
+ * @return 0 if RX runs or no rearm was requested,
+ *         -EAGAIN if no block is free or RX failed to start, the request is kept
+ */
+static int rx_rearm(struct app_uart *uart)
+{
+    uint8_t *buf;
+    int err;
+
+    if (!atomic_test_and_clear_bit(&uart->rx_flags, RX_REARM)) {
+        return 0;
+    }
+
+    err = rx_buf_alloc(uart, &buf, K_NO_WAIT);
+    if (err == -ENOMEM || err == -EAGAIN) {
+        atomic_set_bit(&uart->rx_flags, RX_REARM);
+        return -EAGAIN;
+    } else if (err) {
+        LOG_ERR("Failed to allocate RX buffer: %d", err);
+        return 0;
+    }
+
+    err = port_rx_enable(uart, buf);
+    if (err == -EBUSY) {
+        // started meanwhile, by a resume or a baud rate switch
+        rx_buf_free(uart, buf);
+        return 0;
+    } else if (err) {
+        // RX would stay off for good, try again as without a block
+        LOG_ERR("Failed to enable RX: %d", err);
+        rx_buf_free(uart, buf);
+        atomic_set_bit(&uart->rx_flags, RX_REARM);
+        return -EAGAIN;
+    }
+
+    app_uart_stats_add(uart->index, APP_UART_CNT_RX_REARMS, 1);
+    app_uart_trace(uart->index, APP_UART_TRACE_RX_REARM, 0);
+    LOG_WRN("%s: RX enabled again after DMA buffer exhaustion", uart->dev->name);
+    return 0;
+}
+
+/* Allocate a block and start RX. If the application holds every block,
+ * the RX context starts it once one comes back, as after exhaustion.
+ */
+static int rx_start(struct app_uart *uart, k_timeout_t timeout)
+{
+    uint8_t *buf;
+    int err = rx_buf_alloc(uart, &buf, timeout);
+
+    if (err == -ENOMEM || err == -EAGAIN) {
+        atomic_set_bit(&uart->rx_flags, RX_STARVED);
+        rx_rearm_request(uart);
+        return 0;
+    } else if (err) {
+        LOG_ERR("Failed to allocate RX buffer: %d", err);
+        return err;
+    }
+
+    err = port_rx_enable(uart, buf);
+    if (err) {
+        LOG_ERR("Failed to enable RX: %d", err);
+        rx_buf_free(uart, buf);
+    }
+    return err;
+}
+
+/* Stop RX on purpose, the RX context doesn't enable it again.
+ * Must be called with rx_ctl held.
+ */
+static int rx_stop(struct app_uart *uart)
+{
+    int err;
+
+    atomic_clear(&uart->rx_flags);
+    k_sem_reset(&uart->rx_stopped);
+    err = port_rx_disable(uart);
+    if (err == 0) {
+        // every block is released before UART_RX_DISABLED
+        if (k_sem_take(&uart->rx_stopped, RX_STOP_TIMEOUT)) {
+            LOG_WRN("%s: no RX disabled event", uart->dev->name);
+        }
+    } else if (err != -EFAULT) {
+        // -EFAULT: RX was off already, after DMA buffer exhaustion
+        LOG_ERR("%s: failed to disable RX: %d", uart->dev->name, err);
+        return err;
+    }
+    return 0;
+}
+
+/* Start RX again after port_suspend() */
+static int rx_resume(struct app_uart *uart)
+{
+    int err;
+
+    // if the application holds every block, RX starts once one comes back
+    k_mutex_lock(&uart->rx_ctl, K_FOREVER);
+    uart->rx_off = false;
+    err = rx_start(uart, K_NO_WAIT);
+    k_mutex_unlock(&uart->rx_ctl);
+    return err;
+}
+
+static int port_suspend(struct app_uart *uart)
+{
+    int err;
+
+    k_mutex_lock(&uart->rx_ctl, K_FOREVER);
+    err = rx_stop(uart);
+    if (!err) {
+        uart->rx_off = true;
+    }
+    k_mutex_unlock(&uart->rx_ctl);
+    if (err) {
+        return err;
+    }
+
+#if !IS_ENABLED(CONFIG_PM_DEVICE_RUNTIME) && !IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
+    // the USB stack suspends CDC ACM itself
+    if (!port_irq_mode(uart)) {
+        err = pm_device_action_run(uart->dev, PM_DEVICE_ACTION_SUSPEND);
+        if (err) {
+            LOG_ERR("Failed to suspend device: %d", err);
+            return err;
+        }
+    }
+#endif /* !CONFIG_PM_DEVICE_RUNTIME */
+
+#if IS_ENABLED(CONFIG_APP_UART_GPIO_CROSS_DOMAIN)
+    /* For NCS v3.0.x */
+    // nrfx_power_constlat_mode_free();
+    /* For NCS v3.1.x - latest */
+    nrf_sys_event_release_global_constlat();
+#endif /* CONFIG_APP_UART_GPIO_CROSS_DOMAIN */
+
+    return 0;
+}
+
+static int port_resume(struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_GPIO_CROSS_DOMAIN)
+    /* For NCS v3.0.x */
+    // nrfx_power_constlat_mode_request();
+    /* For NCS v3.1.x - latest */
+    nrf_sys_event_request_global_constlat();
+#endif /* CONFIG_APP_UART_GPIO_CROSS_DOMAIN */
+
+#if !IS_ENABLED(CONFIG_PM_DEVICE_RUNTIME) && !IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
+    if (!port_irq_mode(uart)) {
+        int err = pm_device_action_run(uart->dev, PM_DEVICE_ACTION_RESUME);
+
+        if (err) {
+            LOG_ERR("Failed to resume device: %d", err);
+            return err;
+        }
+    }
+#endif /* !CONFIG_PM_DEVICE_RUNTIME */
+
+    return rx_resume(uart);
+}
+
+/* Swap the staging buffers if the line is idle and there is pending data.
+ * Must be called with tx_lock held, returns the buffer to start or NULL.
+ */
+static struct tx_buf *tx_kick_locked(struct app_uart *uart)
+{
+    struct tx_buf *buf = uart->tx_fill;
+
+    if (uart->tx_busy || uart->tx_rsv_open || buf->len == 0 || pm_held(uart)) {
+        return NULL;
+    }
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+    if (uart->tx_gap) {
+        return NULL;
+    }
+#endif
+
+    uart->tx_fill = (buf == &uart->tx_bufs[0]) ? &uart->tx_bufs[1] : &uart->tx_bufs[0];
+    uart->tx_fill->len = 0;
+    uart->tx_busy = true;
+    return buf;
+}
+
+static void tx_start(struct app_uart *uart, struct tx_buf *buf)
+{
+    while (buf != NULL) {
+        uart->tx_start_ts = app_uart_stats_ts();
+        app_uart_trace(uart->index, APP_UART_TRACE_TX_START, buf->len);
+
+        int err = port_tx(uart, buf->data, buf->len);
+
+        if (!err) {
+            return;
+        }
+
+        LOG_ERR("Failed to send tx data: %d, dropping %d bytes", err, buf->len);
+        app_uart_stats_add(uart->index, APP_UART_CNT_TX_ERRORS, 1);
+        app_uart_trace(uart->index, APP_UART_TRACE_TX_ERROR, buf->len);
+
+        // no UART_TX_DONE comes, start what was packed meanwhile here
+        K_SPINLOCK(&uart->tx_lock) {
+            uart->tx_busy = false;
+            buf = tx_kick_locked(uart);
+        }
+        k_sem_give(&uart->tx_settled);
+    }
+}
+
+/* Every byte went to the driver, with tx_lock held */
+static bool tx_idle_locked(const struct app_uart *uart)
+{
+    bool idle = !uart->tx_busy && !uart->tx_rsv_open && uart->tx_fill->len == 0;
+
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+    idle = idle && !uart->tx_gap;
+#endif
+    return idle;
+}
+
+/* Space left in the staging buffer being filled, with tx_lock held */
+static size_t tx_room_locked(const struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+    // a frame waiting for its turn is not merged with the next one
+    if (uart->tx_fill->len > 0) {
+        return 0;
+    }
+#endif
+    return uart->tx_buf_size - uart->tx_fill->len;
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+/* Timer ISR: the gap after the last frame passed, start the next one */
+static void tx_gap_expiry(struct k_timer *timer)
+{
+    struct app_uart *uart = CONTAINER_OF(timer, struct app_uart, tx_gap_timer);
+    struct tx_buf *next;
+    k_spinlock_key_t key = k_spin_lock(&uart->tx_lock);
+
+    uart->tx_gap = false;
+    next = tx_kick_locked(uart);
+    k_spin_unlock(&uart->tx_lock, key);
+
+    if (next != NULL) {
+        tx_start(uart, next);
+    } else {
+        k_sem_give(&uart->tx_settled);
+    }
+}
+#endif
+
+static void tx_complete(struct app_uart *uart)
+{
+    struct tx_buf *next;
+    k_spinlock_key_t key = k_spin_lock(&uart->tx_lock);
+
+    uart->tx_busy = false;
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+    // the next frame waits for the gap on the timer, not in the sender
+    uart->tx_gap = true;
+    k_timer_start(&uart->tx_gap_timer, K_USEC(uart->tx_gap_us), K_NO_WAIT);
+#endif
+    next = tx_kick_locked(uart);
+    k_spin_unlock(&uart->tx_lock, key);
+
+    // start the buffer packed meanwhile, without a thread round-trip
+    if (next != NULL) {
+        tx_start(uart, next);
+    } else {
+        k_sem_give(&uart->tx_settled);
+    }
+
+    if (uart->tx_done_callback != NULL) {
+        uart->tx_done_callback(uart);
+    }
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ADAPTIVE)
+/* Adaptive RX operating point.
+ * Every CONFIG_APP_UART_RX_ADAPT_PERIOD_MS the bytes and UART_RX_RDY events
+ * of the period give the byte rate, and the DMA length and inactivity
+ * timeout are picked for the target. The lengths are the block size and
+ * its halves down to CONFIG_APP_UART_RX_ADAPT_MIN_LEN, every block of the
+ * slab holds any of them. A new length takes effect with the next buffer
+ * request, a new timeout restarts RX.
+ */
+#define RX_ADAPT_PERIOD K_MSEC(CONFIG_APP_UART_RX_ADAPT_PERIOD_MS)
+
+/* a shorter timeout splits frames at the gaps between their characters */
+#define RX_ADAPT_GAP_CHARS 3
+
+/* largest length up to want, the shortest one if none */
+static size_t rx_len_floor(struct app_uart *uart, uint64_t want)
+{
+    size_t len = uart->block_size;
+
+    while (len > want && len / 2 >= CONFIG_APP_UART_RX_ADAPT_MIN_LEN) {
+        len /= 2;
+    }
+    return len;
+}
+
+/* shortest length of at least want, the block size if none */
+static size_t rx_len_ceil(struct app_uart *uart, uint64_t want)
+{
+    size_t len = uart->block_size;
+
+    while (len / 2 >= want && len / 2 >= CONFIG_APP_UART_RX_ADAPT_MIN_LEN) {
+        len /= 2;
+    }
+    return len;
+}
+
+/* shortest timeout, a few characters at the line rate if it is known */
+static uint32_t rx_timeout_min(struct app_uart *uart)
+{
+    uint32_t baud = app_uart_baudrate(uart);
+    uint32_t gap_us = baud ? RX_ADAPT_GAP_CHARS * 10 * USEC_PER_SEC / baud : 0;
+
+    return MAX(gap_us, CONFIG_APP_UART_RX_ADAPT_TIMEOUT_MIN_US);
+}
+
+static void rx_point_pick(struct app_uart *uart, uint32_t bytes_per_sec,
+                          uint32_t events_per_sec, size_t *len, uint32_t *timeout_us)
+{
+    uint32_t min_us = rx_timeout_min(uart);
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ADAPT_LATENCY)
+    // a block fills within the target, and the timeout reports the rest of a frame
+    *len = rx_len_floor(uart, (uint64_t)bytes_per_sec * CONFIG_APP_UART_RX_ADAPT_LATENCY_US /
+                              USEC_PER_SEC);
+    *timeout_us = MAX(CONFIG_APP_UART_RX_ADAPT_LATENCY_US, min_us);
+#else
+    // full blocks take half of the ceiling at most
+    *len = rx_len_ceil(uart, DIV_ROUND_UP((uint64_t)bytes_per_sec * 2,
+                                          CONFIG_APP_UART_RX_ADAPT_ISR_MAX));
+
+    // and so do timeouts, a timeout fires once per period of inactivity at most,
+    // the short one only while the frames leave room for it
+    if (events_per_sec > CONFIG_APP_UART_RX_ADAPT_ISR_MAX / 2) {
+        *timeout_us = MAX(2 * USEC_PER_SEC / CONFIG_APP_UART_RX_ADAPT_ISR_MAX, min_us);
+    } else if (events_per_sec < CONFIG_APP_UART_RX_ADAPT_ISR_MAX / 4) {
+        *timeout_us = min_us;
+    } else {
+        *timeout_us = uart->rx_timeout_us;
+    }
+#endif
+}
+
+/* Apply a new timeout, unless the port is suspended: it starts with it */
+static void rx_restart(struct app_uart *uart)
+{
+    k_mutex_lock(&uart->rx_ctl, K_FOREVER);
+    if (!uart->rx_off && rx_stop(uart) == 0) {
+        (void)rx_start(uart, K_NO_WAIT);
+        uart->adapt.restarts++;
+    }
+    k_mutex_unlock(&uart->rx_ctl);
+}
+
+static void rx_adapt_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct app_uart *uart = CONTAINER_OF(dwork, struct app_uart, rx_adapt_work);
+    int64_t now = k_uptime_get();
+    uint32_t elapsed_ms = MAX((uint32_t)(now - uart->adapt.since), 1);
+    uint32_t bytes = (uint32_t)atomic_clear(&uart->adapt.bytes);
+    uint32_t events = (uint32_t)atomic_clear(&uart->adapt.events);
+    size_t len;
+    uint32_t timeout_us;
+
+    uart->adapt.since = now;
+    uart->adapt.bytes_per_sec = (uint64_t)bytes * MSEC_PER_SEC / elapsed_ms;
+    uart->adapt.events_per_sec = (uint64_t)events * MSEC_PER_SEC / elapsed_ms;
+
+    rx_point_pick(uart, uart->adapt.bytes_per_sec, uart->adapt.events_per_sec,
+                  &len, &timeout_us);
+
+    if (len != uart->rx_len) {
+        uart->rx_len = len;
+        uart->adapt.len_changes++;
+        app_uart_trace(uart->index, APP_UART_TRACE_RX_POINT, len);
+    }
+    if (timeout_us != uart->rx_timeout_us) {
+        uart->rx_timeout_us = timeout_us;
+        // the native backend reports every USB packet, it has no timeout to apply
+        if (!port_irq_mode(uart)) {
+            rx_restart(uart);
+        }
+    }
+
+    k_work_reschedule(dwork, RX_ADAPT_PERIOD);
+}
+
+/* Before RX starts, the idle operating point */
+static void rx_adapt_init(struct app_uart *uart)
+{
+    k_work_init_delayable(&uart->rx_adapt_work, rx_adapt_handler);
+
+    rx_point_pick(uart, 0, 0, &uart->rx_len, &uart->rx_timeout_us);
+    uart->adapt.since = k_uptime_get();
+    k_work_reschedule(&uart->rx_adapt_work, RX_ADAPT_PERIOD);
+}
+#endif /* CONFIG_APP_UART_RX_ADAPTIVE */
+
+int app_uart_rx_point_get(struct app_uart *uart, struct app_uart_rx_point *point)
+{
+    *point = (struct app_uart_rx_point) {
+        .rx_len = uart->rx_len,
+        .timeout_us = uart->rx_timeout_us,
+#if IS_ENABLED(CONFIG_APP_UART_RX_ADAPTIVE)
+        .bytes_per_sec = uart->adapt.bytes_per_sec,
+        .events_per_sec = uart->adapt.events_per_sec,
+        .len_changes = uart->adapt.len_changes,
+        .restarts = uart->adapt.restarts,
+#endif
+    };
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+/* Idle power management.
+ * A port with a wake GPIO on its RX pin is suspended once nothing was sent
+ * or received for CONFIG_APP_UART_PM_IDLE_TIMEOUT_MS. The start bit of the
+ * next incoming byte resumes it, that byte is lost, and so does app_uart_tx(),
+ * whose data waits in the staging buffer meanwhile.
+ */
+#define PM_IDLE_TIMEOUT K_MSEC(CONFIG_APP_UART_PM_IDLE_TIMEOUT_MS)
+
+/* Close the current period, before the port changes between active and suspended */
+static void pm_account(struct app_uart *uart, bool was_active)
+{
+    int64_t now = k_uptime_get();
+
+    K_SPINLOCK(&uart->pm_lock) {
+        if (was_active) {
+            uart->pm.active_ms += now - uart->pm.since;
+        } else {
+            uart->pm.suspended_ms += now - uart->pm.since;
+        }
+        uart->pm.since = now;
+    }
+}
+
+static void pm_wake_arm(struct app_uart *uart, bool arm)
+{
+    int err;
+
+    if (uart->wake.port == NULL) {
+        return;
+    }
+
+    if (arm) {
+        // the sleep pin state may have disconnected the input buffer
+        err = gpio_pin_configure_dt(&uart->wake, GPIO_INPUT);
+        if (!err) {
+            err = gpio_pin_interrupt_configure_dt(&uart->wake, GPIO_INT_EDGE_TO_ACTIVE);
+        }
+    } else {
+        err = gpio_pin_interrupt_configure_dt(&uart->wake, GPIO_INT_DISABLE);
+    }
+
+    if (err) {
+        LOG_ERR("%s: failed to configure the wake GPIO: %d", uart->dev->name, err);
+    }
+}
+
+static void pm_wake_handler(const struct device *port, struct gpio_callback *cb,
+                            gpio_port_pins_t pins)
+{
+    struct app_uart *uart = CONTAINER_OF(cb, struct app_uart, wake_cb);
+
+    pm_request_resume(uart, true);
+}
+
+/* ISR safe, the resume itself runs on the system workqueue */
+static void pm_request_resume(struct app_uart *uart, bool rx)
+{
+    if (!atomic_cas(&uart->pm_state, PM_SUSPENDED, PM_RESUMING)) {
+        return;
+    }
+
+    uart->pm_wake_cyc = k_cycle_get_32();
+    uart->pm_wake_rx = rx;
+    k_work_submit(&uart->pm_resume_work);
+}
+
+/* Running again: the TX staged meanwhile goes out and the idle timer restarts */
+static void pm_activate(struct app_uart *uart)
+{
+    struct tx_buf *start = NULL;
+
+    pm_account(uart, false);
+    pm_touch(uart);
+    atomic_set(&uart->pm_state, PM_ACTIVE);
+
+    K_SPINLOCK(&uart->tx_lock) {
+        start = tx_kick_locked(uart);
+    }
+    if (start != NULL) {
+        tx_start(uart, start);
+    }
+
+    if (uart->wake.port != NULL) {
+        k_work_reschedule(&uart->pm_idle_work, PM_IDLE_TIMEOUT);
+    }
+}
+
+/* Suspend a port already marked PM_SUSPENDED */
+static int pm_suspend(struct app_uart *uart)
+{
+    int err = port_suspend(uart);
+
+    if (err) {
+        // RX may be off already
+        (void)rx_resume(uart);
+        pm_activate(uart);
+        return err;
+    }
+
+    K_SPINLOCK(&uart->pm_lock) {
+        uart->pm.suspends++;
+    }
+    app_uart_trace(uart->index, APP_UART_TRACE_PM_SUSPEND, 0);
+
+    pm_wake_arm(uart, true);
+
+    // a start bit between RX disable and arming has no edge left to catch
+    if (uart->wake.port != NULL && gpio_pin_get_dt(&uart->wake) > 0) {
+        pm_request_resume(uart, true);
+    }
+    return 0;
+}
+
+/* Resume a port marked PM_RESUMING */
+static int pm_resume(struct app_uart *uart)
+{
+    int err;
+
+    pm_wake_arm(uart, false);
+
+    err = port_resume(uart);
+    if (err) {
+        // wait for the next edge or TX request
+        atomic_set(&uart->pm_state, PM_SUSPENDED);
+        pm_wake_arm(uart, true);
+        return err;
+    }
+
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - uart->pm_wake_cyc);
+
+    K_SPINLOCK(&uart->pm_lock) {
+        if (uart->pm_wake_rx) {
+            uart->pm.rx_wakeups++;
+        } else {
+            uart->pm.tx_wakeups++;
+        }
+        uart->pm.resume_count++;
+        uart->pm.resume_us_sum += us;
+        uart->pm.resume_us_max = MAX(uart->pm.resume_us_max, us);
+    }
+    app_uart_trace(uart->index, APP_UART_TRACE_PM_RESUME, uart->pm_wake_rx);
+
+    // the first byte after an RX wake-up tells how long the peer has to wait
+    uart->pm_first_byte = uart->pm_wake_rx;
+    pm_activate(uart);
+    return 0;
+}
+
+static void pm_resume_handler(struct k_work *work)
+{
+    struct app_uart *uart = CONTAINER_OF(work, struct app_uart, pm_resume_work);
+
+    if (atomic_get(&uart->pm_state) == PM_RESUMING) {
+        (void)pm_resume(uart);
+    }
+}
+
+static void pm_idle_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct app_uart *uart = CONTAINER_OF(dwork, struct app_uart, pm_idle_work);
+    uint32_t idle_ms = k_uptime_get_32() - (uint32_t)atomic_get(&uart->pm_last_activity);
+    bool idle = false;
+
+    if (idle_ms < CONFIG_APP_UART_PM_IDLE_TIMEOUT_MS) {
+        k_work_reschedule(dwork, K_MSEC(CONFIG_APP_UART_PM_IDLE_TIMEOUT_MS - idle_ms));
+        return;
+    }
+
+    K_SPINLOCK(&uart->tx_lock) {
+        // from here on app_uart_tx() only stages and requests a resume
+        if (!uart->tx_busy && !uart->tx_rsv_open && uart->tx_fill->len == 0) {
+            idle = atomic_cas(&uart->pm_state, PM_ACTIVE, PM_SUSPENDED);
+        }
+    }
+
+    if (!idle) {
+        // suspended by hand, pm_activate() restarts the timer
+        if (!pm_held(uart)) {
+            k_work_reschedule(dwork, PM_IDLE_TIMEOUT);
+        }
+        return;
+    }
+
+    pm_account(uart, true);
+    (void)pm_suspend(uart);
+}
+
+static void pm_init(struct app_uart *uart)
+{
+    int err;
+
+    uart->pm.since = k_uptime_get();
+    pm_touch(uart);
+    k_work_init_delayable(&uart->pm_idle_work, pm_idle_handler);
+    k_work_init(&uart->pm_resume_work, pm_resume_handler);
+
+    if (uart->wake.port == NULL || port_irq_mode(uart)) {
+        // USB suspends CDC ACM itself
+        uart->wake.port = NULL;
+        LOG_INF("%s: no wake GPIO, not suspended when idle", uart->dev->name);
+        return;
+    }
+
+    if (!gpio_is_ready_dt(&uart->wake)) {
+        LOG_ERR("%s: wake GPIO not ready", uart->dev->name);
+        uart->wake.port = NULL;
+        return;
+    }
+
+    gpio_init_callback(&uart->wake_cb, pm_wake_handler, BIT(uart->wake.pin));
+    err = gpio_add_callback_dt(&uart->wake, &uart->wake_cb);
+    if (err) {
+        LOG_ERR("%s: failed to add the wake GPIO callback: %d", uart->dev->name, err);
+        uart->wake.port = NULL;
+        return;
+    }
+
+    k_work_reschedule(&uart->pm_idle_work, PM_IDLE_TIMEOUT);
+}
+
+int app_uart_pm_stats_get(struct app_uart *uart, struct app_uart_pm_stats *stats)
+{
+    int64_t now = k_uptime_get();
+
+    K_SPINLOCK(&uart->pm_lock) {
+        const struct pm_counters *pm = &uart->pm;
+        bool active = !pm_held(uart);
+
+        stats->suspended = !active;
+        stats->active_ms = pm->active_ms + (active ? now - pm->since : 0);
+        stats->suspended_ms = pm->suspended_ms + (active ? 0 : now - pm->since);
+        stats->suspends = pm->suspends;
+        stats->rx_wakeups = pm->rx_wakeups;
+        stats->tx_wakeups = pm->tx_wakeups;
+        stats->resume_us_max = pm->resume_us_max;
+        stats->resume_us_avg = pm->resume_count ?
+                               (uint32_t)(pm->resume_us_sum / pm->resume_count) : 0;
+        stats->first_byte_us_max = pm->first_byte_us_max;
+        stats->first_byte_us_avg = pm->first_byte_count ?
+                                   (uint32_t)(pm->first_byte_us_sum / pm->first_byte_count) : 0;
+    }
+    return 0;
+}
+
+void app_uart_pm_stats_reset(struct app_uart *uart)
+{
+    K_SPINLOCK(&uart->pm_lock) {
+        uart->pm = (struct pm_counters) {
+            .since = k_uptime_get(),
+        };
+    }
+}
+#endif /* CONFIG_APP_UART_PM_IDLE */
+
+int app_uart_sleep(struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+    // TX waits for the resume from now on
+    if (!atomic_cas(&uart->pm_state, PM_ACTIVE, PM_SUSPENDED)) {
+        return -EALREADY;
+    }
+    pm_account(uart, true);
+    return pm_suspend(uart);
+#else
+    return port_suspend(uart);
+#endif
+}
+
+int app_uart_wakeup(struct app_uart *uart)
+{
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+    if (!atomic_cas(&uart->pm_state, PM_SUSPENDED, PM_RESUMING)) {
+        return -EALREADY;
+    }
+    uart->pm_wake_cyc = k_cycle_get_32();
+    uart->pm_wake_rx = false;
+    return pm_resume(uart);
+#else
+    return port_resume(uart);
+#endif
+}
+
+/* async serial callback, also fed by the native CDC ACM backend */
+static void uart_callback(const struct device *dev,
+			  struct uart_event *evt,
+			  void *user_data)
+{
+	struct app_uart *uart = user_data;
+	int err;
+
+	switch (evt->type) {
+	case UART_TX_DONE:
+        app_uart_trace(uart->index, APP_UART_TRACE_TX_DONE, evt->data.tx.len);
+        app_uart_stats_stage(uart->index, APP_UART_STAGE_TX_WIRE, uart->tx_start_ts,
+                             app_uart_stats_ts());
+        app_uart_stats_add(uart->index, APP_UART_CNT_TX_BYTES, evt->data.tx.len);
+        tx_complete(uart);
+		break;
+
+	case UART_TX_ABORTED:
+        app_uart_trace(uart->index, APP_UART_TRACE_TX_ABORTED, evt->data.tx.len);
+        app_uart_stats_add(uart->index, APP_UART_CNT_TX_ABORTS, 1);
+        app_uart_stats_add(uart->index, APP_UART_CNT_TX_BYTES, evt->data.tx.len);
+        tx_complete(uart);
+		break;
+
+	case UART_RX_RDY:
+    {
+        uint32_t rdy_ts = app_uart_stats_ts();
+
+        app_uart_trace(uart->index, APP_UART_TRACE_RX_RDY, evt->data.rx.len);
+        pm_rx_activity(uart);
+        rx_adapt_account(uart, evt->data.rx.len);
+
+        app_uart_stats_add(uart->index, APP_UART_CNT_RX_BYTES, evt->data.rx.len);
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+        // reported before the timeout, the chunk ran up to the end of its block.
+        // The native backend has no RX timeout, only the gap timer tells.
+        bool full = port_irq_mode(uart) ||
+                    evt->data.rx.offset + evt->data.rx.len >= uart->rx_len;
+
+        rx_gap_chunk_start(uart, evt->data.rx.len, full);
+#endif
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+        // hand the DMA block itself to the RX context, no copy
+        struct app_uart_rx_view view = {
+            .uart = uart,
+            .buf = evt->data.rx.buf,
+            .offset = evt->data.rx.offset,
+            .len = evt->data.rx.len,
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+            .flags = full ? 0 : APP_UART_RX_FRAME_END,
+#endif
+        };
+
+        app_uart_rx_view_hold(&view);
+        err = k_msgq_put(&rx_queue, &view, K_NO_WAIT);
+        if (err) {
+            LOG_ERR("Failed to put view to RX queue, dropping %d bytes", view.len);
+            app_uart_trace(uart->index, APP_UART_TRACE_RX_DROP, view.len);
+            app_uart_stats_add(uart->index, APP_UART_CNT_RX_DROPPED, 1);
+            app_uart_stats_add(uart->index, APP_UART_CNT_RX_DROPPED_BYTES, view.len);
+            app_uart_rx_view_release(&view);
+        } else {
+            rx_pending_mark(uart, rdy_ts, app_uart_stats_ts());
+            rx_kick();
+        }
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+        rx_gap_chunk_end(uart, full);
+#endif
+#else
+        uint8_t *p = &(evt->data.rx.buf[evt->data.rx.offset]);
+        size_t len = evt->data.rx.len;
+
+        // if the RX buffer is full, it will be free after the `uart_callback` return.
+        // so the data should be copy here.
+        err = spsc_ring_put(uart->ring, p, len);
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+        // before the kick, a dropped chunk still ends its frame, the framer sees it short
+        rx_gap_chunk_end(uart, full);
+#endif
+        if (err) {
+            LOG_ERR("RX ring full, dropping %d bytes", len);
+            app_uart_trace(uart->index, APP_UART_TRACE_RX_DROP, len);
+            app_uart_stats_add(uart->index, APP_UART_CNT_RX_DROPPED, 1);
+            app_uart_stats_add(uart->index, APP_UART_CNT_RX_DROPPED_BYTES, len);
+        } else {
+            rx_pending_mark(uart, rdy_ts, app_uart_stats_ts());
+            rx_kick();
+        }
+#endif /* CONFIG_APP_UART_RX_ZERO_COPY */
+		break;
+    }
+
+	case UART_RX_BUF_REQUEST:
+	{
+		uint8_t *buf;
+		err = rx_buf_alloc(uart, &buf, K_NO_WAIT);
+		if (err) {
+			// decline, RX stops when the current block is full
+			atomic_set_bit(&uart->rx_flags, RX_STARVED);
+			app_uart_stats_add(uart->index, APP_UART_CNT_RX_SLAB_EXHAUSTED, 1);
+			app_uart_trace(uart->index, APP_UART_TRACE_RX_BUF_REQUEST, UINT16_MAX);
+			break;
+		}
+		app_uart_trace(uart->index, APP_UART_TRACE_RX_BUF_REQUEST, rx_block_index(uart, buf));
+
+		err = port_rx_buf_rsp(uart, buf);
+		if (err) {
+			LOG_ERR("Failed to provide new buffer: %d", err);
+			rx_buf_free(uart, buf);
+		}
+		break;
+	}
+
+	case UART_RX_BUF_RELEASED:
+        app_uart_trace(uart->index, APP_UART_TRACE_RX_BUF_RELEASED,
+                       rx_block_index(uart, evt->data.rx_buf.buf));
+		rx_buf_free(uart, evt->data.rx_buf.buf);
+		break;
+
+	case UART_RX_DISABLED:
+        app_uart_trace(uart->index, APP_UART_TRACE_RX_DISABLED, 0);
+        k_sem_give(&uart->rx_stopped);
+        rx_rearm_request(uart);
+		break;
+
+	case UART_RX_STOPPED:
+        app_uart_trace(uart->index, APP_UART_TRACE_RX_STOPPED, evt->data.rx_stop.reason);
+        app_uart_stats_add(uart->index, APP_UART_CNT_RX_ERRORS, 1);
+		break;
+	}
+}
+
+int app_uart_rx_cb_register(struct app_uart *uart, packets_cb_t cb)
+{
+    __ASSERT(cb != NULL, "Callback cannot be NULL");
+    uart->user_callback = cb;
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+int app_uart_rx_view_cb_register(struct app_uart *uart, rx_view_cb_t cb)
+{
+    __ASSERT(cb != NULL, "Callback cannot be NULL");
+    uart->view_callback = cb;
+    return 0;
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_SUBSCRIBERS)
+static void rx_sub_drain(struct app_uart_rx_sub *sub)
+{
+    struct app_uart_rx_view view;
+
+    while (k_msgq_get(sub->queue, &view, K_NO_WAIT) == 0) {
+        app_uart_rx_view_release(&view);
+    }
+}
+
+int app_uart_rx_subscribe(struct app_uart *uart, struct app_uart_rx_sub *sub,
+                          rx_sub_filter_t filter, void *user_data)
+{
+    int err = 0;
+
+    if (sub->queue == NULL || sub->queue->msg_size != sizeof(struct app_uart_rx_view)) {
+        return -EINVAL;
+    }
+
+    // the RX context is shared, it may only wait a bounded time, and never on the workqueue
+    if (sub->policy == APP_UART_RX_SUB_BLOCK &&
+        (IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_WORKQUEUE) ||
+         K_TIMEOUT_EQ(sub->block_timeout, K_FOREVER))) {
+        return -ENOTSUP;
+    }
+
+    k_mutex_lock(&uart->sub_lock, K_FOREVER);
+    if (sub->uart != NULL) {
+        err = -EALREADY;
+    } else if (uart->sub_num == ARRAY_SIZE(uart->subs)) {
+        err = -ENOMEM;
+    } else {
+        sub->uart = uart;
+        sub->filter = filter;
+        sub->user_data = user_data;
+        sub->delivered = 0;
+        sub->dropped = 0;
+        uart->subs[uart->sub_num++] = sub;
+    }
+    k_mutex_unlock(&uart->sub_lock);
+    return err;
+}
+
+int app_uart_rx_unsubscribe(struct app_uart_rx_sub *sub)
+{
+    struct app_uart *uart = sub->uart;
+
+    if (uart == NULL) {
+        return -EALREADY;
+    }
+
+    k_mutex_lock(&uart->sub_lock, K_FOREVER);
+    while (sub->waiting) {
+        // the RX context waits for room in the queue, this ends the wait
+        rx_sub_drain(sub);
+        (void)k_condvar_wait(&uart->sub_done, &uart->sub_lock, K_FOREVER);
+    }
+    for (size_t i = 0; i < uart->sub_num; i++) {
+        if (uart->subs[i] == sub) {
+            memmove(&uart->subs[i], &uart->subs[i + 1],
+                    (uart->sub_num - i - 1) * sizeof(uart->subs[0]));
+            uart->sub_num--;
+            break;
+        }
+    }
+    sub->uart = NULL;
+    k_mutex_unlock(&uart->sub_lock);
+
+    // nothing is queued any more, the last blocks go back to the slab
+    rx_sub_drain(sub);
+    return 0;
+}
+
+int app_uart_rx_sub_get(struct app_uart_rx_sub *sub, struct app_uart_rx_view *view,
+                        k_timeout_t timeout)
+{
+    return k_msgq_get(sub->queue, view, timeout);
+}
+
+int app_uart_rx_sub_stats_get(struct app_uart *uart, size_t idx,
+                              struct app_uart_rx_sub_stats *stats)
+{
+    int err = -ENOENT;
+
+    k_mutex_lock(&uart->sub_lock, K_FOREVER);
+    if (idx < uart->sub_num) {
+        const struct app_uart_rx_sub *sub = uart->subs[idx];
+
+        stats->name = sub->name;
+        stats->policy = sub->policy;
+        stats->queued = k_msgq_num_used_get(sub->queue);
+        stats->delivered = sub->delivered;
+        stats->dropped = sub->dropped;
+        err = 0;
+    }
+    k_mutex_unlock(&uart->sub_lock);
+    return err;
+}
+
+/* With sub_lock held, queues one more reference on the block of the view.
+ * Returns false if a blocking subscriber has no room, the view is held then
+ * and the caller waits for room without the lock.
+ */
+static bool rx_sub_put(struct app_uart_rx_sub *sub, const struct app_uart_rx_view *view)
+{
+    struct app_uart_rx_view oldest;
+
+    app_uart_rx_view_hold(view);
+    if (k_msgq_put(sub->queue, view, K_NO_WAIT) == 0) {
+        sub->delivered++;
+        return true;
+    }
+
+    if (sub->policy == APP_UART_RX_SUB_BLOCK) {
+        return false;
+    }
+
+    // only the RX context puts, the subscriber may have made room meanwhile
+    if (k_msgq_get(sub->queue, &oldest, K_NO_WAIT) == 0) {
+        app_uart_rx_view_release(&oldest);
+        sub->dropped++;
+    }
+    if (k_msgq_put(sub->queue, view, K_NO_WAIT) == 0) {
+        sub->delivered++;
+    } else {
+        app_uart_rx_view_release(view);
+        sub->dropped++;
+    }
+    return true;
+}
+
+/* Hands the view to every subscriber that takes it, in thread context */
+static void rx_sub_publish(const struct app_uart_rx_view *view)
+{
+    struct app_uart *uart = view->uart;
+    struct app_uart_rx_sub *blocked[CONFIG_APP_UART_RX_SUBSCRIBERS_MAX];
+    bool queued[CONFIG_APP_UART_RX_SUBSCRIBERS_MAX];
+    size_t n = 0;
+
+    k_mutex_lock(&uart->sub_lock, K_FOREVER);
+    for (size_t i = 0; i < uart->sub_num; i++) {
+        struct app_uart_rx_sub *sub = uart->subs[i];
+
+        if ((sub->filter == NULL || sub->filter(view, sub->user_data)) &&
+            !rx_sub_put(sub, view)) {
+            // app_uart_rx_unsubscribe() waits until it is done with the queue
+            sub->waiting = true;
+            blocked[n++] = sub;
+        }
+    }
+    k_mutex_unlock(&uart->sub_lock);
+
+    if (n == 0) {
+        return;
+    }
+
+    // without the lock, the other subscribers and the shell go on meanwhile
+    for (size_t i = 0; i < n; i++) {
+        queued[i] = k_msgq_put(blocked[i]->queue, view, blocked[i]->block_timeout) == 0;
+    }
+
+    k_mutex_lock(&uart->sub_lock, K_FOREVER);
+    for (size_t i = 0; i < n; i++) {
+        struct app_uart_rx_sub *sub = blocked[i];
+
+        if (queued[i]) {
+            sub->delivered++;
+        } else {
+            app_uart_rx_view_release(view);
+            sub->dropped++;
+        }
+        sub->waiting = false;
+    }
+    k_condvar_broadcast(&uart->sub_done);
+    k_mutex_unlock(&uart->sub_lock);
+}
+#endif /* CONFIG_APP_UART_RX_SUBSCRIBERS */
+#endif /* CONFIG_APP_UART_RX_ZERO_COPY */
+
+int app_uart_txv(struct app_uart *uart, const struct app_uart_iovec *iov, size_t cnt)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; i < cnt; i++) {
+        if (iov[i].data == NULL && iov[i].len != 0) {
+            LOG_WRN("Invalid TX parameters");
+            return -EINVAL;
+        }
+        len += iov[i].len;
+    }
 
-#include "app_uart.h"
+    if (len == 0) {
+        LOG_WRN("Invalid TX parameters");
+        return -EINVAL;
+    }
 
-#include <zephyr/logging/log.h>
-LOG_MODULE_REGISTER(app_uart, CONFIG_APP_UART_LOG_LEVEL);
+    if (len > uart->tx_buf_size) {
+        LOG_ERR("TX packet of %d bytes exceeds the TX buffer", len);
+        return -EMSGSIZE;
+    }
 
-#define RX_INACTIVE_TIMEOUT_US 1000000
+    struct tx_buf *start;
+    struct tx_buf *fill;
+    k_spinlock_key_t key = k_spin_lock(&uart->tx_lock);
 
-/* serial device */ 
-#if IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
-/* USB CDC ACM */
-#include <uart_async_adapter.h>
+    fill = uart->tx_fill;
+    if (len > tx_room_locked(uart)) {
+        k_spin_unlock(&uart->tx_lock, key);
+        LOG_ERR("No space in TX buffer for %d bytes", len);
+        app_uart_stats_add(uart->index, APP_UART_CNT_TX_NO_SPACE, 1);
+        return -ENOMEM;
+    }
 
-#define USB_UART_INST DT_ALIAS(my_usb_serial)
-static const struct device *uart_dev = DEVICE_DT_GET(USB_UART_INST);
-UART_ASYNC_ADAPTER_INST_DEFINE(async_adapter);
-#else 
+    // pack behind the data already waiting in the staging buffer
+    for (size_t i = 0; i < cnt; i++) {
+        memcpy(&fill->data[fill->len], iov[i].data, iov[i].len);
+        fill->len += iov[i].len;
+    }
 
-/* Normal UART */
-#define UART_INST DT_ALIAS(learning_serial)
-static const struct device *uart_dev = DEVICE_DT_GET(UART_INST);
+    start = tx_kick_locked(uart);
+    k_spin_unlock(&uart->tx_lock, key);
 
-#endif /* CONFIG_UART_ASYNC_ADAPTER */
+    if (start != NULL) {
+        tx_start(uart, start);
+    }
+    pm_tx_activity(uart);
 
-/* uart rx memory pool for DMA */
-#define BUF_SIZE CONFIG_APP_UART_RX_DMA_BLOCK_SIZE
-#define BUF_NUM CONFIG_APP_UART_RX_DMA_BLOCK_NUMBER
-K_MEM_SLAB_DEFINE(uart_slab, BUF_SIZE, BUF_NUM, 4);
+    return 0;
+}
 
-/* Queues for TX and RX packet */
-struct uart_data_t {
-    uint8_t *data;
-    size_t len;
-};
-K_MSGQ_DEFINE(tx_queue, sizeof(struct uart_data_t), 16, 4);
-K_MSGQ_DEFINE(rx_queue, sizeof(struct uart_data_t), 16, 4);
+size_t app_uart_tx_buf_size(const struct app_uart *uart)
+{
+    return uart->tx_buf_size;
+}
 
-/* TX semaphores */
-static K_SEM_DEFINE(tx_done, 0, 1);
+int app_uart_tx_done_cb_register(struct app_uart *uart, tx_done_cb_t cb)
+{
+    uart->tx_done_callback = cb;
+    return 0;
+}
 
-int app_uart_sleep(void)
+size_t app_uart_tx_queued(struct app_uart *uart)
 {
-    int err;
-    err = uart_rx_disable(uart_dev);
-    if (err) {
-        LOG_ERR("Failed to disable RX: %d", err);
-        return err;
+    size_t len = 0;
+
+    K_SPINLOCK(&uart->tx_lock) {
+        len = uart->tx_fill->len;
     }
+    return len;
+}
+
+int app_uart_configure(struct app_uart *uart, const struct uart_config *cfg)
+{
+#if IS_ENABLED(CONFIG_UART_USE_RUNTIME_CONFIGURE)
+    int err = uart_configure(uart->dev, cfg);
 
-#if !IS_ENABLED(CONFIG_PM_DEVICE_RUNTIME) && !IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
-    // give some time for UART callback
-    k_sleep(K_MSEC(10)); 
-    err = pm_device_action_run(uart_dev, PM_DEVICE_ACTION_SUSPEND);
     if (err) {
-        LOG_ERR("Failed to suspend device: %d", err);
-        return err;
+        LOG_ERR("%s: failed to configure: %d", uart->dev->name, err);
     }
-#endif /* !CONFIG_PM_DEVICE_RUNTIME */ 
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+    // the RX timeout follows at the next RX start
+    rx_gap_update(uart);
+#endif
+    return err;
+#else
+    return -ENOTSUP;
+#endif
+}
 
-#if IS_ENABLED(CONFIG_APP_UART_GPIO_CROSS_DOMAIN)
-    /* For NCS v3.0.x */
-    // nrfx_power_constlat_mode_free();
-    /* For NCS v3.1.x - latest */
-    nrf_sys_event_release_global_constlat();
-#endif /* CONFIG_APP_UART_GPIO_CROSS_DOMAIN */
+int app_uart_tx_drain(struct app_uart *uart, k_timeout_t timeout)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    bool idle = false;
 
-    return 0;
+    while (true) {
+        K_SPINLOCK(&uart->tx_lock) {
+            idle = tx_idle_locked(uart);
+        }
+        if (idle) {
+            // for the next caller waiting, if any
+            k_sem_give(&uart->tx_settled);
+            return 0;
+        }
+        // given by the TX done path, a stale give only costs one more check
+        if (k_sem_take(&uart->tx_settled, sys_timepoint_timeout(end)) &&
+            sys_timepoint_expired(end)) {
+            return -EAGAIN;
+        }
+    }
 }
 
-int app_uart_wakeup(void)
+uint32_t app_uart_baudrate(const struct app_uart *uart)
 {
-    uint8_t *buf;
-    int err;
+#if IS_ENABLED(CONFIG_UART_USE_RUNTIME_CONFIGURE)
+    struct uart_config cfg;
 
-#if IS_ENABLED(CONFIG_APP_UART_GPIO_CROSS_DOMAIN)
-    /* For NCS v3.0.x */
-    // nrfx_power_constlat_mode_request();
-    /* For NCS v3.1.x - latest */
-    nrf_sys_event_request_global_constlat();
-#endif /* CONFIG_APP_UART_GPIO_CROSS_DOMAIN */
+    if (uart_config_get(uart->dev, &cfg) == 0) {
+        return cfg.baudrate;
+    }
+#endif
+    return 0;
+}
 
-#if !IS_ENABLED(CONFIG_PM_DEVICE_RUNTIME) && !IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
-    err = pm_device_action_run(uart_dev, PM_DEVICE_ACTION_RESUME);
+int app_uart_set_baudrate(struct app_uart *uart, uint32_t baudrate)
+{
+#if IS_ENABLED(CONFIG_UART_USE_RUNTIME_CONFIGURE)
+    struct uart_config cfg;
+    int err, rx_err;
+
+    err = uart_config_get(uart->dev, &cfg);
     if (err) {
-        LOG_ERR("Failed to resume device: %d", err);
+        LOG_ERR("%s: failed to get the configuration: %d", uart->dev->name, err);
         return err;
     }
-#endif /* !CONFIG_PM_DEVICE_RUNTIME */
+    if (cfg.baudrate == baudrate) {
+        return 0;
+    }
 
-    err = k_mem_slab_alloc(&uart_slab, (void **)&buf, K_NO_WAIT);
+    err = app_uart_tx_drain(uart, TX_DRAIN_TIMEOUT);
     if (err) {
-        LOG_ERR("Failed to allocate RX buffer: %d", err);
+        LOG_ERR("%s: TX didn't drain: %d", uart->dev->name, err);
         return err;
     }
+    // UART_TX_DONE comes with the last byte still in the shift register,
+    // 12 bits cover start, 8 data, parity and 2 stop bits
+    k_busy_wait(12 * USEC_PER_SEC / cfg.baudrate + 1);
 
-    err = uart_rx_enable(uart_dev, buf, BUF_SIZE, RX_INACTIVE_TIMEOUT_US);
+    k_mutex_lock(&uart->rx_ctl, K_FOREVER);
+    err = rx_stop(uart);
     if (err) {
-        LOG_ERR("Failed to enable RX: %d", err);
+        k_mutex_unlock(&uart->rx_ctl);
         return err;
     }
-    return 0;
+
+    cfg.baudrate = baudrate;
+    err = uart_configure(uart->dev, &cfg);
+    if (err) {
+        // RX goes on at the old rate
+        LOG_ERR("%s: failed to set %u baud: %d", uart->dev->name, baudrate, err);
+    }
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+    rx_gap_update(uart);
+#endif
+
+    // a suspended port starts RX when it resumes
+    rx_err = uart->rx_off ? 0 : rx_start(uart, RX_STOP_TIMEOUT);
+    k_mutex_unlock(&uart->rx_ctl);
+    return err ? err : rx_err;
+#else
+    return -ENOTSUP;
+#endif
 }
 
-/* async serial callback */
-static void uart_callback(const struct device *dev,
-			  struct uart_event *evt,
-			  void *user_data)
+int app_uart_tx(struct app_uart *uart, const uint8_t *byte, size_t len)
 {
-	struct device *uart = user_data;
-	int err;
+    if (byte == NULL || len == 0) {
+        LOG_WRN("Invalid TX parameters");
+        return -EINVAL;
+    }
 
-	switch (evt->type) {
-	case UART_TX_DONE:
-        LOG_INF("TX done %d bytes", evt->data.tx.len);
-        k_sem_give(&tx_done);
-		break;
+    const struct app_uart_iovec iov = {
+        .data = byte,
+        .len = len,
+    };
 
-	case UART_TX_ABORTED:
-        LOG_WRN("TX aborted");
-        k_sem_give(&tx_done);
-		break;
+    return app_uart_txv(uart, &iov, 1);
+}
 
-	case UART_RX_RDY:
-    {
-        uint8_t *p = &(evt->data.rx.buf[evt->data.rx.offset]);
-        size_t len = evt->data.rx.len;
+int app_uart_tx_reserve(struct app_uart *uart, uint8_t **buf, size_t len)
+{
+    if (buf == NULL || len == 0) {
+        LOG_WRN("Invalid TX parameters");
+        return -EINVAL;
+    }
 
-        LOG_INF("RX %d bytes", len);
-        
-        struct uart_data_t packet = {
-            .data = k_malloc(len),
-            .len = len,
-        };
+    if (len > uart->tx_buf_size) {
+        LOG_ERR("TX packet of %d bytes exceeds the TX buffer", len);
+        return -EMSGSIZE;
+    }
 
-        if( NULL == packet.data){
-            LOG_ERR("Failed to alloc memory for RX packet!!!");
-            return;
-        }
+    k_spinlock_key_t key = k_spin_lock(&uart->tx_lock);
+    struct tx_buf *fill = uart->tx_fill;
 
-        // if the RX buffer is full, it will be free after the `uart_callback` return.
-        // so the data should be copy here.
-        memcpy(packet.data, p, len);
+    if (uart->tx_rsv_open) {
+        k_spin_unlock(&uart->tx_lock, key);
+        return -EBUSY;
+    }
 
-        err = k_msgq_put(&rx_queue, &packet, K_NO_WAIT);
-        if (err) {
-            LOG_ERR("Failed to put packet to RX queue, freeing memory");
-            k_free(packet.data); 
-        } else {
-            LOG_INF("RX %d bytes copied", len);
-        }
-		break;
+    if (len > tx_room_locked(uart)) {
+        k_spin_unlock(&uart->tx_lock, key);
+        LOG_ERR("No space in TX buffer for %d bytes", len);
+        app_uart_stats_add(uart->index, APP_UART_CNT_TX_NO_SPACE, 1);
+        return -ENOMEM;
     }
 
-	case UART_RX_BUF_REQUEST:
-	{
-		uint8_t *buf;
-        LOG_INF("RX buffer request");
-		err = k_mem_slab_alloc(&uart_slab, (void **)&buf, K_NO_WAIT);
-		__ASSERT(err == 0, "Failed to allocate slab\n");
+    // the fill buffer is not swapped while the reservation is open
+    uart->tx_rsv_open = true;
+    uart->tx_rsv_off = fill->len;
+    uart->tx_rsv_len = len;
+    fill->len += len;
+    *buf = &fill->data[uart->tx_rsv_off];
 
-		err = uart_rx_buf_rsp(uart, buf, BUF_SIZE);
-		__ASSERT(err == 0, "Failed to provide new buffer\n");
-		break;
-	}
+    k_spin_unlock(&uart->tx_lock, key);
+    return 0;
+}
 
-	case UART_RX_BUF_RELEASED:
-        LOG_INF("RX buffer released");
-		k_mem_slab_free(&uart_slab, (void *)evt->data.rx_buf.buf);
-		break;
+int app_uart_tx_reserve_avail(struct app_uart *uart, uint8_t **buf, size_t *len)
+{
+    if (buf == NULL || len == NULL) {
+        LOG_WRN("Invalid TX parameters");
+        return -EINVAL;
+    }
 
-	case UART_RX_DISABLED:
-        LOG_INF("RX disabled");
-		break;
+    k_spinlock_key_t key = k_spin_lock(&uart->tx_lock);
+    struct tx_buf *fill = uart->tx_fill;
 
-	case UART_RX_STOPPED:
-        LOG_INF("RX stopped");
-		break;
-	}
-}
+    if (uart->tx_rsv_open) {
+        k_spin_unlock(&uart->tx_lock, key);
+        return -EBUSY;
+    }
 
-static packets_cb_t user_callback = NULL;
+    if (tx_room_locked(uart) == 0) {
+        k_spin_unlock(&uart->tx_lock, key);
+        app_uart_stats_add(uart->index, APP_UART_CNT_TX_NO_SPACE, 1);
+        return -ENOMEM;
+    }
 
-int app_uart_rx_cb_register(packets_cb_t cb)
-{
-    __ASSERT(cb != NULL, "Callback cannot be NULL");
-    user_callback = cb;
+    uart->tx_rsv_open = true;
+    uart->tx_rsv_off = fill->len;
+    uart->tx_rsv_len = tx_room_locked(uart);
+    fill->len = uart->tx_buf_size;
+    *buf = &fill->data[uart->tx_rsv_off];
+    *len = uart->tx_rsv_len;
+
+    k_spin_unlock(&uart->tx_lock, key);
     return 0;
 }
 
-int app_uart_tx(const uint8_t *byte, size_t len)
+int app_uart_tx_commit(struct app_uart *uart, size_t len)
 {
-    if (byte == NULL || len == 0) {
-        LOG_WRN("Invalid TX parameters");
+    struct tx_buf *start;
+    bool idle;
+    k_spinlock_key_t key = k_spin_lock(&uart->tx_lock);
+    struct tx_buf *fill = uart->tx_fill;
+
+    if (!uart->tx_rsv_open || len > uart->tx_rsv_len) {
+        k_spin_unlock(&uart->tx_lock, key);
+        LOG_WRN("Invalid TX commit of %d bytes", len);
         return -EINVAL;
     }
 
-    // k_msgq will copy the "packet" element. So we can use local variable here
-    struct uart_data_t packet = {
-        .data = k_malloc(len),
-        .len = len,
-    };
+    // give back the unused tail, data packed after the reservation moves down
+    size_t unused = uart->tx_rsv_len - len;
+    size_t after = uart->tx_rsv_off + uart->tx_rsv_len;
 
-    if( NULL == packet.data){
-        LOG_ERR("Failed to alloc memory for TX packet");
-        return -ENOMEM;
+    if (unused > 0) {
+        memmove(&fill->data[after - unused], &fill->data[after], fill->len - after);
+        fill->len -= unused;
     }
+    uart->tx_rsv_open = false;
 
-    memcpy(packet.data, byte, len);
+    start = tx_kick_locked(uart);
+    idle = tx_idle_locked(uart);
+    k_spin_unlock(&uart->tx_lock, key);
 
-    int err = k_msgq_put(&tx_queue, &packet, K_NO_WAIT);
-    if (err) {
-        LOG_ERR("Failed to put packet to TX queue, freeing memory");
-        k_free(packet.data); 
-        return err;
+    if (start != NULL) {
+        tx_start(uart, start);
+    } else if (idle) {
+        // an empty reservation on an idle line, a drain waits on it
+        k_sem_give(&uart->tx_settled);
     }
+    pm_tx_activity(uart);
 
     return 0;
 }
 
-static void app_uart_rx_thread()
+static bool rx_subscribed(const struct app_uart *uart)
 {
-    struct uart_data_t packet = {0};
-    int err;
+#if IS_ENABLED(CONFIG_APP_UART_RX_SUBSCRIBERS)
+    return uart->sub_num > 0;
+#else
+    ARG_UNUSED(uart);
+    return false;
+#endif
+}
 
-    while(1) {
-        err = k_msgq_get(&rx_queue, &packet, K_FOREVER);
-        if (err) {
-            LOG_ERR("Failed to get packet from RX queue");
-            continue;
+/* hand received data to the user callback, in thread context */
+static void rx_dispatch(const struct app_uart_rx_view *view)
+{
+    struct app_uart *uart = view->uart;
+    // a frame end alone has no data
+    uint8_t *data = view->buf ? &view->buf[view->offset] : NULL;
+
+    LOG_HEXDUMP_DBG(data, view->len, "RX packet:");
+    app_uart_trace(uart->index, APP_UART_TRACE_RX_DISPATCH, view->len);
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+    uart->rx_frame_end = view->flags & APP_UART_RX_FRAME_END;
+#endif
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    // it has to hold the view if the data is used after return
+    if (uart->view_callback != NULL) {
+        uart->view_callback(view);
+    } else
+#endif
+    if (uart->user_callback != NULL) {
+        uart->user_callback(uart, data, view->len);
+    } else if (!rx_subscribed(uart)) {
+        LOG_WRN("No user callback registered for RX packets on %s", uart->dev->name);
+    }
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_SUBSCRIBERS)
+    // after the callback, a subscriber with a full queue doesn't delay it
+    rx_sub_publish(view);
+#endif
+
+    app_uart_trace(uart->index, APP_UART_TRACE_RX_DISPATCHED, view->len);
+}
+
+static void rx_dispatch_measured(const struct app_uart_rx_view *view)
+{
+#if IS_ENABLED(CONFIG_APP_UART_STATS)
+    struct app_uart *uart = view->uart;
+    uint32_t dequeued = app_uart_stats_ts();
+    bool valid;
+    uint32_t rdy, enqueued;
+
+    K_SPINLOCK(&uart->rx_pending_lock) {
+        valid = uart->rx_pending.valid;
+        rdy = uart->rx_pending.rdy;
+        enqueued = uart->rx_pending.enqueued;
+        uart->rx_pending.valid = false;
+    }
+    uart->rx_rdy_valid = valid;
+    uart->rx_rdy = rdy;
+
+    uint32_t entry = app_uart_stats_ts();
+
+    rx_dispatch(view);
+
+    uint32_t exit = app_uart_stats_ts();
+
+    if (valid) {
+        app_uart_stats_stage(uart->index, APP_UART_STAGE_RX_QUEUE, enqueued, dequeued);
+        app_uart_stats_stage(uart->index, APP_UART_STAGE_RX_LATENCY, rdy, entry);
+    }
+    app_uart_stats_stage(uart->index, APP_UART_STAGE_RX_DISPATCH, dequeued, entry);
+    app_uart_stats_stage(uart->index, APP_UART_STAGE_RX_CALLBACK, entry, exit);
+#else
+    rx_dispatch(view);
+#endif
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+static void rx_process(const struct app_uart_rx_view *view)
+{
+    // an empty view is only a wake-up, or a frame end
+    if (view->buf != NULL) {
+        rx_dispatch_measured(view);
+        app_uart_rx_view_release(view);
+    } else if (view->flags != 0) {
+        rx_dispatch_measured(view);
+    }
+}
+#else
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+/* Bytes up to the next frame end, or len if it is further away */
+static uint32_t rx_gap_span(struct app_uart *uart, uint32_t len, uint32_t *flags)
+{
+    uint32_t tail = atomic_get(&uart->gap_mark_tail);
+
+    if (tail == (uint32_t)atomic_get(&uart->gap_mark_head)) {
+        return len;
+    }
+
+    uint32_t to_end = uart->gap_marks[tail & (ARRAY_SIZE(uart->gap_marks) - 1)] -
+                      (uint32_t)atomic_get(&uart->ring->tail);
+
+    if (to_end > len) {
+        return len;
+    }
+    *flags = APP_UART_RX_FRAME_END;
+    return to_end;
+}
+#endif /* CONFIG_APP_UART_RX_FRAME_GAP */
+
+static void rx_drain_ring(struct app_uart *uart)
+{
+    while (true) {
+        uint8_t *data = NULL;
+        uint32_t len = spsc_ring_peek(uart->ring, &data);
+        uint32_t flags = 0;
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+        len = rx_gap_span(uart, len, &flags);
+#endif
+        if (len == 0 && flags == 0) {
+            break;
         }
 
-        LOG_HEXDUMP_INF(packet.data, packet.len, "RX packet:");
+        // the bytes are passed in place, one contiguous span at a time
+        struct app_uart_rx_view view = {
+            .uart = uart,
+            .buf = len ? data : NULL,
+            .offset = 0,
+            .len = len,
+            .flags = flags,
+        };
 
-        // the user callback is in thread context
-        if (user_callback == NULL) {
-            LOG_WRN("No user callback registered for RX packets");
-            k_free(packet.data);
-            continue;
-        } 
-        user_callback(packet.data, packet.len);
-        k_free(packet.data);
+        rx_dispatch_measured(&view);
+        spsc_ring_consume(uart->ring, len);
 
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+        if (flags & APP_UART_RX_FRAME_END) {
+            atomic_inc(&uart->gap_mark_tail);
+        }
+#endif
     }
 }
+#endif /* CONFIG_APP_UART_RX_ZERO_COPY */
 
-static void app_uart_tx_thread()
+/* RX context: rearm every port that asked for it, without waiting for a block,
+ * one port whose blocks are all held must not stop the others.
+ * Returns true if a port is still starved, to retry after RX_REARM_RETRY.
+ */
+static bool rx_rearm_ports(void)
 {
-    while(1) {
-        struct uart_data_t packet = {0};
-        int err;
-        err = k_msgq_get(&tx_queue, &packet, K_FOREVER);
+    bool starved = false;
 
-        if (err) {
-            LOG_ERR("Failed to get packet from TX queue");
-            continue;
+    for (size_t i = 0; i < ARRAY_SIZE(ports); i++) {
+        if (rx_rearm(ports[i]) == -EAGAIN) {
+            starved = true;
         }
+    }
+    return starved;
+}
 
-        err = uart_tx(uart_dev, packet.data, packet.len, 0);
-        if (err) {
-            LOG_ERR("Failed to send tx data");
-            k_free(packet.data);
-            continue;
+#if IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_WORKQUEUE)
+static void rx_work_handler(struct k_work *work)
+{
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    struct app_uart_rx_view view;
+    // only what is queued now, the views queued meanwhile kick the work again
+    // and the other work items get their turn
+    uint32_t n = k_msgq_num_used_get(&rx_queue);
+
+    while (n-- > 0 && k_msgq_get(&rx_queue, &view, K_NO_WAIT) == 0) {
+        rx_process(&view);
+    }
+#endif
+
+#if !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    for (size_t i = 0; i < ARRAY_SIZE(ports); i++) {
+        rx_drain_ring(ports[i]);
+    }
+#endif
+
+    // poll until the application releases a block
+    if (rx_rearm_ports()) {
+        k_work_schedule(&rx_work, RX_REARM_RETRY);
+    }
+}
+#elif IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+static void app_uart_rx_thread()
+{
+    struct app_uart_rx_view view;
+    k_timeout_t wait = K_FOREVER;
+
+    while(1) {
+        // times out only to retry a rearm
+        if (k_msgq_get(&rx_queue, &view, wait) == 0) {
+            rx_process(&view);
         }
 
-        // wait for TX done
-        k_sem_take(&tx_done, K_FOREVER);
-        k_free(packet.data);
+        // the queued views hold blocks, drain them first
+        if (k_msgq_num_used_get(&rx_queue) == 0) {
+            wait = rx_rearm_ports() ? RX_REARM_RETRY : K_FOREVER;
+        }
     }
 }
+#else
+static void app_uart_rx_thread()
+{
+    k_timeout_t wait = K_FOREVER;
 
-static int app_uart_init(void)
+    while(1) {
+        // times out only to retry a rearm
+        (void)k_sem_take(&rx_ready, wait);
+
+        for (size_t i = 0; i < ARRAY_SIZE(ports); i++) {
+            rx_drain_ring(ports[i]);
+        }
+        wait = rx_rearm_ports() ? RX_REARM_RETRY : K_FOREVER;
+    }
+}
+#endif /* CONFIG_APP_UART_RX_CONTEXT_WORKQUEUE */
+
+static int app_uart_port_init(struct app_uart *uart)
 {
     int err;
     uint8_t *buf;
 
-	if (!device_is_ready(uart_dev)) {
-        LOG_ERR("device %s is not ready; exiting", uart_dev->name);
+	if (!device_is_ready(uart->dev)) {
+        LOG_ERR("device %s is not ready; exiting", uart->dev->name);
         return -ENODEV;
     }
 
+    err = k_mem_slab_init(&uart->slab, uart->slab_buf, uart->block_size, uart->block_num);
+    __ASSERT(err == 0, "Failed to init slab");
+    k_sem_init(&uart->rx_stopped, 0, 1);
+    k_sem_init(&uart->tx_settled, 0, 1);
+    k_mutex_init(&uart->rx_ctl);
+#if IS_ENABLED(CONFIG_APP_UART_RX_SUBSCRIBERS)
+    k_mutex_init(&uart->sub_lock);
+    k_condvar_init(&uart->sub_done);
+#endif
+
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE) || IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
+    const struct uart_driver_api *api = (const struct uart_driver_api *)uart->dev->api;
+#endif
+
+#if IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+	if (api->callback_set == NULL) {
+        /* No async API, drive the FIFO directly */
+        uart->irq_mode = true;
+        err = uart_irq_callback_user_data_set(uart->dev, irq_callback, uart);
+	} else {
+        err = uart_callback_set(uart->dev, uart_callback, uart);
+	}
+#else
 #if IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER)
-    
-    const struct uart_driver_api *api = (const struct uart_driver_api *)uart_dev->api;
 	if (api->callback_set == NULL) {
         /* Implement API adapter */
-        uart_async_adapter_init(async_adapter, uart_dev);
-        uart_dev = async_adapter;
+        uart_async_adapter_init(*uart->adapter, uart->dev);
+        uart->dev = *uart->adapter;
 	}
-
 #endif
-
-	err = uart_callback_set(uart_dev, uart_callback, (void *)uart_dev);
+	err = uart_callback_set(uart->dev, uart_callback, uart);
+#endif /* CONFIG_APP_UART_CDC_ACM_NATIVE */
 	__ASSERT(err == 0, "Failed to set callback");
 
     // allocate buffer and start rx
-    err = k_mem_slab_alloc(&uart_slab, (void **)&buf, K_NO_WAIT);
+    err = rx_buf_alloc(uart, &buf, K_NO_WAIT);
 	__ASSERT(err == 0, "Failed to alloc slab");
 
 #if IS_ENABLED(CONFIG_APP_UART_GPIO_CROSS_DOMAIN)
@@ -317,18 +2499,49 @@ static int app_uart_init(void)
     nrf_sys_event_request_global_constlat();
 #endif /* CONFIG_APP_UART_GPIO_CROSS_DOMAIN */
 
+#if IS_ENABLED(CONFIG_APP_UART_RX_ADAPTIVE)
+    rx_adapt_init(uart);
+#endif
+#if IS_ENABLED(CONFIG_APP_UART_RX_FRAME_GAP)
+    k_timer_init(&uart->gap_timer, rx_gap_expiry, NULL);
+#if IS_ENABLED(CONFIG_APP_UART_TX_FRAME_GAP)
+    k_timer_init(&uart->tx_gap_timer, tx_gap_expiry, NULL);
+#endif
+    rx_gap_update(uart);
+#endif
+
     // for the UARTE that have "frame-timeout-supported" property,
     // the RX_INACTIVE_TIMEOUT_US doesn't take effect if it is bigger than max FRAMETIMEOUT of UARTE.
-    // For example, nRF54L15
-    err = uart_rx_enable(uart_dev, buf, BUF_SIZE, RX_INACTIVE_TIMEOUT_US);
+    // For example, nRF54L15. The short frame gap is timed by that hardware.
+    err = port_rx_enable(uart, buf);
     __ASSERT(err == 0, "Failed to enable rx");
+
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+    pm_init(uart);
+#endif
     return 0;
 }
 
+static int app_uart_init(void)
+{
+    int ret = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(ports); i++) {
+        ports[i]->index = i;
+
+        // keep the other ports running if one of them fails
+        int err = app_uart_port_init(ports[i]);
+        if (err) {
+            ret = err;
+        }
+    }
+
+    return ret;
+}
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_CONTEXT_THREAD)
 K_THREAD_DEFINE(app_uart_rx_id, CONFIG_APP_UART_RX_THREAD_STACK_SIZE, app_uart_rx_thread, NULL, NULL, NULL,
 		CONFIG_APP_UART_RX_THREAD_PRIORITY, 0, 0);
-
-K_THREAD_DEFINE(app_uart_tx_id, CONFIG_APP_UART_TX_THREAD_STACK_SIZE, app_uart_tx_thread, NULL, NULL, NULL,
-        CONFIG_APP_UART_TX_THREAD_PRIORITY, 0, 0);
+#endif
 
 SYS_INIT(app_uart_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
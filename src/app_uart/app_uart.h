@@ -1,41 +1,537 @@
 #ifndef __APP_UART_H
 #define __APP_UART_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h> 
+#include <zephyr/toolchain.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys_clock.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef void (*packets_cb_t)(uint8_t *byte, size_t len);
+/* Default port, used by the loopback application */
+#if IS_ENABLED(CONFIG_UART_ASYNC_ADAPTER) || IS_ENABLED(CONFIG_APP_UART_CDC_ACM_NATIVE)
+#define APP_UART_DEFAULT_NODE DT_ALIAS(my_usb_serial)
+#else
+#define APP_UART_DEFAULT_NODE DT_ALIAS(learning_serial)
+#endif
+
+/*
+ * Ports are built from devicetree: one per "app,uart" node, which points to
+ * the serial device and may size its buffers (dts/bindings/app,uart.yaml).
+ * Without any "app,uart" node there is a single port on APP_UART_DEFAULT_NODE.
+ * APP_UART_FOREACH(fn) calls fn(serial_node, config_node) for every port.
+ */
+#if DT_HAS_COMPAT_STATUS_OKAY(app_uart)
+#define APP_UART_DT_PORT(node_id, fn) fn(DT_PHANDLE(node_id, uart), node_id)
+#define APP_UART_FOREACH(fn) DT_FOREACH_STATUS_OKAY_VARGS(app_uart, APP_UART_DT_PORT, fn)
+#elif IS_ENABLED(CONFIG_APP_BRIDGE)
+/* USB to UART bridge, the physical UART next to the USB port */
+#define APP_UART_FOREACH(fn)                            \
+    fn(APP_UART_DEFAULT_NODE, DT_INVALID_NODE)          \
+    fn(DT_ALIAS(learning_serial), DT_INVALID_NODE)
+#else
+#define APP_UART_FOREACH(fn) fn(APP_UART_DEFAULT_NODE, DT_INVALID_NODE)
+#endif
+
+/* instance symbol of a serial device node */
+#define APP_UART_NAME(serial_node) _CONCAT(app_uart_, DT_DEP_ORD(serial_node))
+
+#define APP_UART_DT_COUNT(serial_node, config_node) + 1
+/* number of ports */
+#define APP_UART_NUM (0 APP_UART_FOREACH(APP_UART_DT_COUNT))
+
+/* one UART port, private to app_uart.c */
+struct app_uart;
+struct uart_config;
+struct k_msgq;
+
+#define APP_UART_DT_DECLARE(serial_node, config_node) \
+    extern struct app_uart APP_UART_NAME(serial_node);
+APP_UART_FOREACH(APP_UART_DT_DECLARE)
+
+/**
+ * @brief Get the port of a serial device node, e.g. app_uart_get(DT_ALIAS(modem_serial))
+ *
+ * Resolved at build time, the build fails if the node is not a port.
+ */
+#define app_uart_get(serial_node) (&APP_UART_NAME(serial_node))
+
+/**
+ * @brief Get a port by index
+ * @param idx 0 .. APP_UART_NUM - 1
+ * @return Port, NULL if out of range
+ */
+struct app_uart *app_uart_at(size_t idx);
+
+/**
+ * @brief Index of a port, 0 .. APP_UART_NUM - 1
+ */
+size_t app_uart_index(const struct app_uart *uart);
+
+/**
+ * @brief Name of the serial device of a port
+ */
+const char *app_uart_name(const struct app_uart *uart);
+
+typedef void (*packets_cb_t)(struct app_uart *uart, uint8_t *byte, size_t len);
+
+/**
+ * @brief View into a received RX DMA block (zero-copy RX mode)
+ *
+ * The data is at @p buf[offset] .. @p buf[offset + len - 1].
+ * The block stays valid until every holder released its view.
+ */
+struct app_uart_rx_view {
+    struct app_uart *uart;
+    uint8_t *buf;
+    size_t offset;
+    size_t len;
+    uint32_t flags;         // APP_UART_RX_*
+};
+
+/* The line went idle after the view, CONFIG_APP_UART_RX_FRAME_GAP.
+ * A view with no data may carry it alone, buf is NULL then.
+ */
+#define APP_UART_RX_FRAME_END BIT(0)
+
+typedef void (*rx_view_cb_t)(const struct app_uart_rx_view *view);
+
+/**
+ * @brief One segment of a scatter-gather TX packet
+ */
+struct app_uart_iovec {
+    const uint8_t *data;
+    size_t len;
+};
+
+/**
+ * @brief RX blocks of a port (zero-copy RX mode)
+ *
+ * The RX memory of a port is its block_num blocks, whoever holds views of
+ * them: the driver, the RX callback or the subscribers.
+ */
+struct app_uart_rx_block_stats {
+    uint32_t block_num;
+    uint32_t block_size;
+    uint32_t used;          // held by the driver or by a view now
+    uint32_t high_watermark; // CONFIG_MEM_SLAB_TRACE_MAX_UTILIZATION, 0 without
+};
+
+/**
+ * @brief Statistics of the RX byte ring (copy RX mode)
+ */
+struct app_uart_rx_ring_stats {
+    uint32_t size;
+    uint32_t used;
+    uint32_t high_watermark;
+    uint32_t overflows;     // chunks dropped because the ring was full
+    uint32_t dropped_bytes;
+};
 
 /**
  * @brief Register callback function for received packets
+ * @param uart Port
  * @param cb Callback function pointer
  * @return 0 on success, negative error code on failure
  */
-int app_uart_rx_cb_register(packets_cb_t cb);
+int app_uart_rx_cb_register(struct app_uart *uart, packets_cb_t cb);
+
+/**
+ * @brief Tell if the line went idle after the bytes of the RX callback
+ *
+ * Only valid in the callback registered by app_uart_rx_cb_register().
+ * With CONFIG_APP_UART_RX_FRAME_GAP the callback may then be called with
+ * no bytes, when the end of the frame is only known after its last bytes
+ * were reported.
+ * @param uart Port
+ * @return true if a frame ends with these bytes, always false without
+ *         CONFIG_APP_UART_RX_FRAME_GAP
+ */
+bool app_uart_rx_frame_end(const struct app_uart *uart);
+
+/**
+ * @brief UART_RX_RDY time of the bytes of the RX callback
+ *
+ * Only valid in the callback registered by app_uart_rx_cb_register(). When
+ * several chunks were queued before the RX context got to them, only the
+ * oldest one is stamped.
+ * @param uart Port
+ * @param cycles Set to k_cycle_get_32() in the UART_RX_RDY event
+ * @return 0 on success, -ENODATA if these bytes have no stamp, -ENOTSUP
+ *         without CONFIG_APP_UART_STATS
+ */
+int app_uart_rx_rdy_ts(const struct app_uart *uart, uint32_t *cycles);
+
+/**
+ * @brief Gap between frames of a port, CONFIG_APP_UART_RX_FRAME_GAP
+ * @param uart Port
+ * @return Gap in us, at the current line settings, 0 without CONFIG_APP_UART_RX_FRAME_GAP
+ */
+uint32_t app_uart_frame_gap_us(const struct app_uart *uart);
+
+/**
+ * @brief Register callback function for received views (zero-copy RX mode)
+ *
+ * Takes precedence over the callback registered by app_uart_rx_cb_register().
+ * The view is released after the callback returns, call app_uart_rx_view_hold()
+ * to keep using the data afterwards.
+ * @param uart Port
+ * @param cb Callback function pointer
+ * @return 0 on success, negative error code on failure
+ */
+int app_uart_rx_view_cb_register(struct app_uart *uart, rx_view_cb_t cb);
+
+/**
+ * @brief Take one more reference on the RX block of a view
+ * @param view View received in the view callback
+ */
+void app_uart_rx_view_hold(const struct app_uart_rx_view *view);
+
+/**
+ * @brief Release a reference taken by app_uart_rx_view_hold()
+ *
+ * The block goes back to the RX slab when the driver and all views released it.
+ * @param view View to release
+ */
+void app_uart_rx_view_release(const struct app_uart_rx_view *view);
+
+/* What a subscriber gets when its queue is full, CONFIG_APP_UART_RX_SUBSCRIBERS */
+enum app_uart_rx_sub_policy {
+    /* The oldest queued view is released for the new one, RX goes on */
+    APP_UART_RX_SUB_DROP_OLDEST,
+    /* The RX context waits up to block_timeout for room, then the new view
+     * is dropped. Every port and every other consumer waits meanwhile, and
+     * the driver stops RX once the queued views hold all the RX blocks.
+     * Only with the RX thread, CONFIG_APP_UART_RX_CONTEXT_THREAD.
+     */
+    APP_UART_RX_SUB_BLOCK,
+};
+
+/**
+ * @brief Filter of a subscriber, called from the RX context
+ * @return true to queue the view for the subscriber
+ */
+typedef bool (*rx_sub_filter_t)(const struct app_uart_rx_view *view, void *user_data);
+
+/**
+ * @brief Subscriber to the RX views of a port, see APP_UART_RX_SUB_DEFINE()
+ *
+ * All the subscribers get the same views of the same RX blocks, nothing is
+ * copied. A queued view holds a reference on its block until the subscriber
+ * releases it.
+ */
+struct app_uart_rx_sub {
+    const char *name;
+    struct k_msgq *queue;           // of struct app_uart_rx_view
+    enum app_uart_rx_sub_policy policy;
+    k_timeout_t block_timeout;      // APP_UART_RX_SUB_BLOCK only, not K_FOREVER
+
+    /* set by app_uart_rx_subscribe() */
+    struct app_uart *uart;
+    rx_sub_filter_t filter;
+    void *user_data;
+
+    /* under the lock of the port */
+    bool waiting;                   // the RX context waits for room in the queue
+    uint32_t delivered;
+    uint32_t dropped;               // views released for want of room
+};
+
+/**
+ * @brief Define a subscriber and its queue of @p depth views
+ *
+ * APP_UART_RX_SUB_BLOCK waits CONFIG_APP_UART_RX_SUB_BLOCK_TIMEOUT_MS, set
+ * block_timeout before subscribing for another bound. Needs <zephyr/kernel.h>.
+ */
+#define APP_UART_RX_SUB_DEFINE(_name, _depth, _policy)                                     \
+    K_MSGQ_DEFINE(_name##_queue, sizeof(struct app_uart_rx_view), _depth, sizeof(void *)); \
+    struct app_uart_rx_sub _name = {                                                       \
+        .name = STRINGIFY(_name),                                                          \
+        .queue = &_name##_queue,                                                           \
+        .policy = _policy,                                                                 \
+        .block_timeout = K_MSEC(CONFIG_APP_UART_RX_SUB_BLOCK_TIMEOUT_MS),                  \
+    }
+
+/**
+ * @brief Subscribe to the RX views of a port (CONFIG_APP_UART_RX_SUBSCRIBERS)
+ *
+ * In addition to the RX callback. After the callback, every view the filter
+ * takes is held and queued for the subscriber, which gets it with
+ * app_uart_rx_sub_get(). A view may carry APP_UART_RX_FRAME_END with no data.
+ * @param uart Port
+ * @param sub Subscriber
+ * @param filter Filter, NULL for every view
+ * @param user_data Passed to the filter
+ * @return 0 on success, -EALREADY if @p sub is subscribed already,
+ *         -ENOMEM if the port has CONFIG_APP_UART_RX_SUBSCRIBERS_MAX subscribers,
+ *         -EINVAL if the queue isn't one of struct app_uart_rx_view,
+ *         -ENOTSUP for APP_UART_RX_SUB_BLOCK on the system workqueue or
+ *         with a block_timeout of K_FOREVER
+ */
+int app_uart_rx_subscribe(struct app_uart *uart, struct app_uart_rx_sub *sub,
+                          rx_sub_filter_t filter, void *user_data);
+
+/**
+ * @brief Unsubscribe, from thread context
+ *
+ * The views still queued are released. Not from the RX context.
+ * @param sub Subscriber
+ * @return 0 on success, -EALREADY if @p sub isn't subscribed
+ */
+int app_uart_rx_unsubscribe(struct app_uart_rx_sub *sub);
+
+/**
+ * @brief Get the next view queued for a subscriber
+ *
+ * Release it with app_uart_rx_view_release() once the data is used, the
+ * RX block of the port is busy until then.
+ * @param sub Subscriber
+ * @param view Set to the view
+ * @param timeout How long to wait for one
+ * @return 0 on success, -EAGAIN on timeout, -ENOMSG if none and K_NO_WAIT
+ */
+int app_uart_rx_sub_get(struct app_uart_rx_sub *sub, struct app_uart_rx_view *view,
+                        k_timeout_t timeout);
+
+/* Snapshot of one subscriber of a port */
+struct app_uart_rx_sub_stats {
+    const char *name;
+    enum app_uart_rx_sub_policy policy;
+    uint32_t queued;
+    uint32_t delivered;
+    uint32_t dropped;
+};
+
+/**
+ * @brief Read the counters of a subscriber of a port
+ * @param uart Port
+ * @param idx 0 .. number of subscribers - 1
+ * @param stats Set to the counters
+ * @return 0 on success, -ENOENT if there are not that many subscribers
+ */
+int app_uart_rx_sub_stats_get(struct app_uart *uart, size_t idx,
+                              struct app_uart_rx_sub_stats *stats);
+
+/**
+ * @brief Get the usage of the RX blocks (zero-copy RX mode)
+ * @param uart Port
+ * @param stats Filled with the current usage
+ */
+void app_uart_rx_block_stats_get(struct app_uart *uart, struct app_uart_rx_block_stats *stats);
+
+/**
+ * @brief Restart the high watermark of the RX blocks from the blocks used now
+ * @param uart Port
+ */
+void app_uart_rx_block_stats_reset(struct app_uart *uart);
+
+/**
+ * @brief Get the statistics of the RX byte ring (copy RX mode)
+ * @param uart Port
+ * @param stats Filled with the current statistics
+ */
+void app_uart_rx_ring_stats_get(struct app_uart *uart, struct app_uart_rx_ring_stats *stats);
+
+/**
+ * @brief Size of the TX staging buffer, the largest packet app_uart_tx() accepts
+ * @param uart Port
+ */
+size_t app_uart_tx_buf_size(const struct app_uart *uart);
+
+/**
+ * @brief Change the baud rate, parity, stop and data bits of a port
+ *
+ * Needs CONFIG_UART_USE_RUNTIME_CONFIGURE.
+ * @param uart Port
+ * @param cfg New configuration
+ * @return 0 on success, -ENOTSUP if the port can't be reconfigured,
+ *         other negative error code on failure
+ */
+int app_uart_configure(struct app_uart *uart, const struct uart_config *cfg);
+
+typedef void (*tx_done_cb_t)(struct app_uart *uart);
+
+/**
+ * @brief Register a callback for the end of every TX transfer
+ *
+ * Called from the UART ISR once a staging buffer is sent, after the next
+ * one was started. Lets a scheduler on top of app_uart_tx() keep the
+ * staging buffer short, see app_uart_tx_queued().
+ * @param uart Port
+ * @param cb Callback function pointer, NULL for none
+ * @return 0 on success
+ */
+int app_uart_tx_done_cb_register(struct app_uart *uart, tx_done_cb_t cb);
+
+/**
+ * @brief Bytes packed into the TX staging buffer and not started on the wire yet
+ * @param uart Port
+ */
+size_t app_uart_tx_queued(struct app_uart *uart);
+
+/**
+ * @brief Wait until every byte handed to app_uart_tx() went to the driver
+ *
+ * Sleeps until the TX done interrupt leaves TX idle, or the timeout.
+ * @param uart Port
+ * @param timeout How long to wait
+ * @return 0 once TX is idle, -EAGAIN on timeout
+ */
+int app_uart_tx_drain(struct app_uart *uart, k_timeout_t timeout);
+
+/**
+ * @brief Current baud rate of a port
+ *
+ * Needs CONFIG_UART_USE_RUNTIME_CONFIGURE.
+ * @param uart Port
+ * @return Baud rate, 0 if unknown
+ */
+uint32_t app_uart_baudrate(const struct app_uart *uart);
+
+/**
+ * @brief Switch the baud rate of a running port, from thread context
+ *
+ * Drains TX, stops RX, reconfigures the device and starts RX again, so no
+ * byte is sent or received across the switch. Bytes the peer sends
+ * meanwhile are lost. Needs CONFIG_UART_USE_RUNTIME_CONFIGURE.
+ * @param uart Port
+ * @param baudrate New baud rate
+ * @return 0 on success, -ENOTSUP if the port can't be reconfigured,
+ *         -EAGAIN if TX didn't drain, other negative error code on failure.
+ *         RX runs again in every case but -EAGAIN.
+ */
+int app_uart_set_baudrate(struct app_uart *uart, uint32_t baudrate);
 
 /**
  * @brief Send data via UART
+ *
+ * The data is copied into the TX staging buffer and sent together with
+ * the other packets queued meanwhile.
+ * @param uart Port
  * @param byte Pointer to data buffer
  * @param len Length of data to send
- * @return 0 on success, negative error code on failure
+ * @return 0 on success, -EMSGSIZE if @p len exceeds the staging buffer,
+ *         -ENOMEM if there is no space left, other negative error code on failure
+ */
+int app_uart_tx(struct app_uart *uart, const uint8_t *byte, size_t len);
+
+/**
+ * @brief Send a packet gathered from several segments via UART
+ *
+ * The segments are copied back to back into the TX staging buffer, as one packet.
+ * @param uart Port
+ * @param iov Array of segments
+ * @param cnt Number of segments
+ * @return 0 on success, negative error code on failure, see app_uart_tx()
+ */
+int app_uart_txv(struct app_uart *uart, const struct app_uart_iovec *iov, size_t cnt);
+
+/**
+ * @brief Reserve space in the TX staging buffer to build a packet in place
+ *
+ * Only one reservation can be open at a time. It must be closed quickly by
+ * app_uart_tx_commit(), since nothing is started on the wire meanwhile.
+ * @param uart Port
+ * @param buf Set to the reserved DMA-able memory
+ * @param len Number of bytes to reserve
+ * @return 0 on success, -EBUSY if another reservation is open,
+ *         other negative error code on failure, see app_uart_tx()
+ */
+int app_uart_tx_reserve(struct app_uart *uart, uint8_t **buf, size_t len);
+
+/**
+ * @brief Reserve all the space left in the TX staging buffer
+ *
+ * For a packet whose length is only known once it is built, see
+ * app_uart_tx_reserve(). Nothing else can be packed until app_uart_tx_commit()
+ * gives the unused tail back.
+ * @param uart Port
+ * @param buf Set to the reserved DMA-able memory
+ * @param len Set to the number of bytes reserved
+ * @return 0 on success, -EBUSY if another reservation is open,
+ *         -ENOMEM if the staging buffer is full
  */
-int app_uart_tx(const uint8_t *byte, size_t len);
+int app_uart_tx_reserve_avail(struct app_uart *uart, uint8_t **buf, size_t *len);
+
+/**
+ * @brief Send the packet built in the reserved space
+ * @param uart Port
+ * @param len Number of bytes written, up to the reserved length; 0 cancels
+ * @return 0 on success, -EINVAL if no reservation is open or @p len is too long
+ */
+int app_uart_tx_commit(struct app_uart *uart, size_t len);
+
+/* RX operating point of one port, adapted with CONFIG_APP_UART_RX_ADAPTIVE */
+struct app_uart_rx_point {
+    uint32_t rx_len;            // bytes the driver fills per RX block
+    uint32_t timeout_us;        // RX inactivity timeout
+    uint32_t bytes_per_sec;     // received in the last period
+    uint32_t events_per_sec;    // UART_RX_RDY in the last period
+    uint32_t len_changes;
+    uint32_t restarts;          // RX restarts for a new timeout
+};
+
+/**
+ * @brief Read the RX operating point of a port
+ *
+ * Without CONFIG_APP_UART_RX_ADAPTIVE it is the fixed block size and
+ * timeout, and the traffic fields are 0.
+ * @param uart Port
+ * @param point Set to the operating point
+ * @return 0 on success
+ */
+int app_uart_rx_point_get(struct app_uart *uart, struct app_uart_rx_point *point);
 
 /**
  * @brief disable the UART and put it to sleep
- * @return 0 on success, negative error code on failure
+ *
+ * With CONFIG_APP_UART_PM_IDLE, app_uart_tx() and the wake GPIO resume it.
+ * @param uart Port
+ * @return 0 on success, -EALREADY if it is suspended already,
+ *         other negative error code on failure
  */
-int app_uart_sleep(void);
+int app_uart_sleep(struct app_uart *uart);
 
 /**
  * @brief wake up the UART from sleep
- * @return 0 on success, negative error code on failure
+ * @param uart Port
+ * @return 0 on success, -EALREADY if it is not suspended,
+ *         other negative error code on failure
+ */
+int app_uart_wakeup(struct app_uart *uart);
+
+/* Power management of one port, CONFIG_APP_UART_PM_IDLE */
+struct app_uart_pm_stats {
+    bool suspended;
+    uint32_t active_ms;         // time running
+    uint32_t suspended_ms;      // time suspended, resuming included
+    uint32_t suspends;
+    uint32_t rx_wakeups;        // resumes requested by the wake GPIO
+    uint32_t tx_wakeups;        // resumes requested by app_uart_tx() or app_uart_wakeup()
+    uint32_t resume_us_avg;     // resume request to RX running
+    uint32_t resume_us_max;
+    uint32_t first_byte_us_avg; // wake GPIO edge to the first byte received
+    uint32_t first_byte_us_max;
+};
+
+/**
+ * @brief Read the power management statistics of a port
+ * @param uart Port
+ * @param stats Set to the statistics
+ * @return 0 on success
+ */
+int app_uart_pm_stats_get(struct app_uart *uart, struct app_uart_pm_stats *stats);
+
+/**
+ * @brief Reset the power management statistics of a port
+ * @param uart Port
  */
-int app_uart_wakeup(void);
+void app_uart_pm_stats_reset(struct app_uart *uart);
 
 
 
@@ -0,0 +1,322 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/byteorder.h>
+
+#include "app_uart.h"
+#include "app_uart_stats.h"
+#include "app_uart_trace.h"
+
+/* "uart" root command, the other commands are added as subcommands */
+SHELL_SUBCMD_SET_CREATE(app_uart_cmds, (uart));
+SHELL_CMD_REGISTER(uart, &app_uart_cmds, "Application UART commands", NULL);
+
+/* "uart <cmd> [port]", every port if there is no port argument */
+static int port_range(const struct shell *sh, size_t argc, char **argv,
+                      size_t *first, size_t *end)
+{
+    if (argc < 2) {
+        *first = 0;
+        *end = APP_UART_NUM;
+        return 0;
+    }
+
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        if (strcmp(argv[1], app_uart_name(app_uart_at(i))) == 0) {
+            *first = i;
+            *end = i + 1;
+            return 0;
+        }
+    }
+
+    shell_error(sh, "Unknown port %s", argv[1]);
+    return -EINVAL;
+}
+
+static int cmd_rx(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t first, end;
+    int err = port_range(sh, argc, argv, &first, &end);
+
+    if (err) {
+        return err;
+    }
+
+    shell_print(sh, "%-16s %6s %10s %10s %8s %8s %8s", "port", "len", "timeout us",
+                "bytes/s", "events/s", "len chg", "restarts");
+    for (size_t i = first; i < end; i++) {
+        struct app_uart_rx_point pt;
+
+        app_uart_rx_point_get(app_uart_at(i), &pt);
+        shell_print(sh, "%-16s %6u %10u %10u %8u %8u %8u", app_uart_name(app_uart_at(i)),
+                    pt.rx_len, pt.timeout_us, pt.bytes_per_sec, pt.events_per_sec,
+                    pt.len_changes, pt.restarts);
+    }
+    return 0;
+}
+
+SHELL_SUBCMD_ADD((uart), rx, NULL, "RX DMA length, timeout and traffic [port]", cmd_rx, 1, 1);
+
+#if IS_ENABLED(CONFIG_APP_UART_STATS)
+static void print_stats(const struct shell *sh, size_t port)
+{
+    struct app_uart_stats stats;
+
+    app_uart_stats_get(port, &stats);
+
+    shell_print(sh, "%s:", app_uart_name(app_uart_at(port)));
+    for (int i = 0; i < APP_UART_CNT_COUNT; i++) {
+        shell_print(sh, "%-18s %u", app_uart_counter_name(i), stats.counters[i]);
+    }
+
+#if !IS_ENABLED(CONFIG_APP_UART_RX_ZERO_COPY)
+    struct app_uart_rx_ring_stats ring;
+
+    app_uart_rx_ring_stats_get(app_uart_at(port), &ring);
+    shell_print(sh, "%-18s %u/%u, high watermark %u",
+                "rx_ring", ring.used, ring.size, ring.high_watermark);
+#endif
+
+    shell_print(sh, "\n%-12s %8s %8s %8s %8s  (us)", "stage", "count", "min", "avg", "max");
+    for (int i = 0; i < APP_UART_STAGE_COUNT; i++) {
+        const struct app_uart_stage_stats *st = &stats.stages[i];
+
+        if (st->count == 0) {
+            shell_print(sh, "%-12s %8u %8s %8s %8s", app_uart_stage_name(i), 0, "-", "-", "-");
+            continue;
+        }
+
+        shell_print(sh, "%-12s %8u %8u %8u %8u", app_uart_stage_name(i), st->count,
+                    k_cyc_to_us_floor32(st->min),
+                    (uint32_t)k_cyc_to_us_floor64(st->sum / st->count),
+                    k_cyc_to_us_floor32(st->max));
+    }
+    shell_print(sh, "");
+}
+
+static int cmd_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t first, end;
+    int err = port_range(sh, argc, argv, &first, &end);
+
+    for (size_t i = first; !err && i < end; i++) {
+        print_stats(sh, i);
+    }
+    return err;
+}
+
+static void print_hist(const struct shell *sh, size_t port)
+{
+    struct app_uart_stats stats;
+
+    app_uart_stats_get(port, &stats);
+
+    shell_print(sh, "%s:", app_uart_name(app_uart_at(port)));
+    for (int i = 0; i < APP_UART_STAGE_COUNT; i++) {
+        const struct app_uart_stage_stats *st = &stats.stages[i];
+
+        shell_print(sh, "%s:", app_uart_stage_name(i));
+        for (int b = 0; b < APP_UART_STATS_HIST_BUCKETS; b++) {
+            if (st->hist[b] == 0) {
+                continue;
+            }
+            if (b == 0) {
+                shell_print(sh, "  < 1 us: %u", st->hist[b]);
+            } else if (b == APP_UART_STATS_HIST_BUCKETS - 1) {
+                shell_print(sh, "  >= %u us: %u", 1U << (b - 1), st->hist[b]);
+            } else {
+                shell_print(sh, "  %u..%u us: %u", 1U << (b - 1), (1U << b) - 1, st->hist[b]);
+            }
+        }
+    }
+}
+
+static int cmd_stats_hist(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t first, end;
+    int err = port_range(sh, argc, argv, &first, &end);
+
+    for (size_t i = first; !err && i < end; i++) {
+        print_hist(sh, i);
+    }
+    return err;
+}
+
+static int cmd_stats_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t first, end;
+    int err = port_range(sh, argc, argv, &first, &end);
+
+    for (size_t i = first; !err && i < end; i++) {
+        app_uart_stats_reset(i);
+    }
+    if (!err) {
+        shell_print(sh, "Statistics reset");
+    }
+    return err;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_uart_stats,
+    SHELL_CMD_ARG(hist, NULL, "Latency histograms [port]", cmd_stats_hist, 1, 1),
+    SHELL_CMD_ARG(reset, NULL, "Reset statistics [port]", cmd_stats_reset, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((uart), stats, &sub_uart_stats, "Counters and latency statistics [port]",
+                 cmd_stats, 1, 1);
+#endif /* CONFIG_APP_UART_STATS */
+
+#if IS_ENABLED(CONFIG_APP_UART_PM_IDLE)
+static int cmd_pm(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t first, end;
+    int err = port_range(sh, argc, argv, &first, &end);
+
+    if (err) {
+        return err;
+    }
+
+    shell_print(sh, "%-16s %-9s %10s %10s %6s %6s %6s %13s %15s", "port", "state",
+                "active ms", "asleep ms", "sleeps", "rx wk", "tx wk",
+                "resume us", "first byte us");
+    for (size_t i = first; i < end; i++) {
+        struct app_uart_pm_stats st;
+
+        app_uart_pm_stats_get(app_uart_at(i), &st);
+        shell_print(sh, "%-16s %-9s %10u %10u %6u %6u %6u %6u/%6u %7u/%7u",
+                    app_uart_name(app_uart_at(i)), st.suspended ? "suspended" : "active",
+                    st.active_ms, st.suspended_ms, st.suspends, st.rx_wakeups, st.tx_wakeups,
+                    st.resume_us_avg, st.resume_us_max,
+                    st.first_byte_us_avg, st.first_byte_us_max);
+    }
+    shell_print(sh, "latencies are avg/max");
+    return 0;
+}
+
+static int cmd_pm_reset(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t first, end;
+    int err = port_range(sh, argc, argv, &first, &end);
+
+    for (size_t i = first; !err && i < end; i++) {
+        app_uart_pm_stats_reset(app_uart_at(i));
+    }
+    if (!err) {
+        shell_print(sh, "Statistics reset");
+    }
+    return err;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_uart_pm,
+    SHELL_CMD_ARG(reset, NULL, "Reset power statistics [port]", cmd_pm_reset, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((uart), pm, &sub_uart_pm, "Idle power management, time per state and wake-up latency [port]",
+                 cmd_pm, 1, 1);
+#endif /* CONFIG_APP_UART_PM_IDLE */
+
+#if IS_ENABLED(CONFIG_APP_UART_RX_SUBSCRIBERS)
+static int cmd_subs(const struct shell *sh, size_t argc, char **argv)
+{
+    size_t first, end;
+    int err = port_range(sh, argc, argv, &first, &end);
+
+    if (err) {
+        return err;
+    }
+
+    shell_print(sh, "%-16s %-16s %-11s %6s %10s %10s", "port", "subscriber", "policy",
+                "queued", "delivered", "dropped");
+    for (size_t i = first; i < end; i++) {
+        struct app_uart_rx_sub_stats st;
+
+        for (size_t s = 0; app_uart_rx_sub_stats_get(app_uart_at(i), s, &st) == 0; s++) {
+            shell_print(sh, "%-16s %-16s %-11s %6u %10u %10u", app_uart_name(app_uart_at(i)),
+                        st.name,
+                        (st.policy == APP_UART_RX_SUB_BLOCK) ? "block" : "drop-oldest",
+                        st.queued, st.delivered, st.dropped);
+        }
+    }
+    return 0;
+}
+
+SHELL_SUBCMD_ADD((uart), subs, NULL, "RX subscribers, queued views and drops [port]",
+                 cmd_subs, 1, 1);
+#endif /* CONFIG_APP_UART_RX_SUBSCRIBERS */
+
+#if IS_ENABLED(CONFIG_APP_UART_TRACE)
+/* records per dump line */
+#define TRACE_LINE_RECORDS 4
+
+/* The dump is decoded offline by scripts/uart_trace_decode.py:
+ *   TRACE BEGIN v1 hz=<cycle frequency> records=<n> lost=<n>
+ *   TRACE <hex of up to TRACE_LINE_RECORDS little endian records>
+ *   TRACE END
+ */
+static int cmd_trace_dump(const struct shell *sh, size_t argc, char **argv)
+{
+    struct app_uart_trace_record rec[TRACE_LINE_RECORDS];
+    char line[TRACE_LINE_RECORDS * sizeof(rec[0]) * 2 + 1];
+    bool enabled = app_uart_trace_enabled();
+    uint32_t lost;
+    size_t total;
+    size_t n;
+
+    // freeze the ring while it is dumped
+    app_uart_trace_enable(false);
+    total = app_uart_trace_stored(&lost);
+
+    shell_print(sh, "TRACE BEGIN v1 hz=%u records=%u lost=%u",
+                sys_clock_hw_cycles_per_sec(), (uint32_t)total, lost);
+
+    for (size_t done = 0; done < total; done += n) {
+        uint8_t raw[sizeof(rec)];
+        uint8_t *p = raw;
+
+        n = app_uart_trace_read(done, rec, TRACE_LINE_RECORDS);
+        for (size_t i = 0; i < n; i++) {
+            sys_put_le32(rec[i].ts, p);
+            p[4] = rec[i].event;
+            p[5] = rec[i].port;
+            sys_put_le16(rec[i].arg, &p[6]);
+            p += sizeof(rec[0]);
+        }
+        bin2hex(raw, p - raw, line, sizeof(line));
+        shell_print(sh, "TRACE %s", line);
+    }
+
+    shell_print(sh, "TRACE END");
+
+    app_uart_trace_enable(enabled);
+    return 0;
+}
+
+static int cmd_trace_start(const struct shell *sh, size_t argc, char **argv)
+{
+    app_uart_trace_enable(true);
+    return 0;
+}
+
+static int cmd_trace_stop(const struct shell *sh, size_t argc, char **argv)
+{
+    app_uart_trace_enable(false);
+    return 0;
+}
+
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv)
+{
+    app_uart_trace_clear();
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_uart_trace,
+    SHELL_CMD(dump, NULL, "Dump the trace for scripts/uart_trace_decode.py", cmd_trace_dump),
+    SHELL_CMD(start, NULL, "Start recording", cmd_trace_start),
+    SHELL_CMD(stop, NULL, "Stop recording", cmd_trace_stop),
+    SHELL_CMD(clear, NULL, "Drop all the records", cmd_trace_clear),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_SUBCMD_ADD((uart), trace, &sub_uart_trace, "Binary event trace", NULL, 2, 0);
+#endif /* CONFIG_APP_UART_TRACE */
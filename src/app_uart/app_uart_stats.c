@@ -0,0 +1,100 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_uart.h"
+#include "app_uart_stats.h"
+
+static struct app_uart_stats stats[APP_UART_NUM];
+static struct k_spinlock stats_lock;
+
+static const char *const stage_names[APP_UART_STAGE_COUNT] = {
+    [APP_UART_STAGE_RX_ISR] = "rx_isr",
+    [APP_UART_STAGE_RX_QUEUE] = "rx_queue",
+    [APP_UART_STAGE_RX_DISPATCH] = "rx_dispatch",
+    [APP_UART_STAGE_RX_CALLBACK] = "rx_callback",
+    [APP_UART_STAGE_RX_LATENCY] = "rx_latency",
+    [APP_UART_STAGE_TX_WIRE] = "tx_wire",
+};
+
+static const char *const counter_names[APP_UART_CNT_COUNT] = {
+    [APP_UART_CNT_RX_BYTES] = "rx_bytes",
+    [APP_UART_CNT_RX_DROPPED] = "rx_dropped",
+    [APP_UART_CNT_RX_DROPPED_BYTES] = "rx_dropped_bytes",
+    [APP_UART_CNT_RX_SLAB_EXHAUSTED] = "rx_slab_exhausted",
+    [APP_UART_CNT_RX_REARMS] = "rx_rearms",
+    [APP_UART_CNT_RX_ERRORS] = "rx_errors",
+    [APP_UART_CNT_TX_BYTES] = "tx_bytes",
+    [APP_UART_CNT_TX_NO_SPACE] = "tx_no_space",
+    [APP_UART_CNT_TX_ERRORS] = "tx_errors",
+    [APP_UART_CNT_TX_ABORTS] = "tx_aborts",
+};
+
+const char *app_uart_stage_name(enum app_uart_stage stage)
+{
+    return stage_names[stage];
+}
+
+const char *app_uart_counter_name(enum app_uart_counter counter)
+{
+    return counter_names[counter];
+}
+
+static void stage_reset(struct app_uart_stage_stats *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->min = UINT32_MAX;
+}
+
+void app_uart_stats_reset(size_t port)
+{
+    K_SPINLOCK(&stats_lock) {
+        memset(stats[port].counters, 0, sizeof(stats[port].counters));
+        for (int i = 0; i < APP_UART_STAGE_COUNT; i++) {
+            stage_reset(&stats[port].stages[i]);
+        }
+    }
+}
+
+void app_uart_stats_get(size_t port, struct app_uart_stats *out)
+{
+    K_SPINLOCK(&stats_lock) {
+        *out = stats[port];
+    }
+}
+
+void app_uart_stats_add(size_t port, enum app_uart_counter counter, uint32_t value)
+{
+    K_SPINLOCK(&stats_lock) {
+        stats[port].counters[counter] += value;
+    }
+}
+
+void app_uart_stats_stage(size_t port, enum app_uart_stage stage, uint32_t start, uint32_t end)
+{
+    uint32_t cycles = end - start;
+    uint32_t us = k_cyc_to_us_floor32(cycles);
+    // position of the highest bit set is the bucket
+    int bucket = (us == 0) ? 0 : 32 - __builtin_clz(us);
+
+    bucket = MIN(bucket, APP_UART_STATS_HIST_BUCKETS - 1);
+
+    K_SPINLOCK(&stats_lock) {
+        struct app_uart_stage_stats *st = &stats[port].stages[stage];
+
+        st->count++;
+        st->sum += cycles;
+        st->min = MIN(st->min, cycles);
+        st->max = MAX(st->max, cycles);
+        st->hist[bucket]++;
+    }
+}
+
+static int app_uart_stats_init(void)
+{
+    for (size_t i = 0; i < APP_UART_NUM; i++) {
+        app_uart_stats_reset(i);
+    }
+    return 0;
+}
+
+SYS_INIT(app_uart_stats_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
@@ -0,0 +1,99 @@
+#ifndef __APP_UART_STATS_H
+#define __APP_UART_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Latency stages of the data path, measured with k_cycle_get_32() */
+enum app_uart_stage {
+    APP_UART_STAGE_RX_ISR,      // UART_RX_RDY to enqueued for the RX thread
+    APP_UART_STAGE_RX_QUEUE,    // enqueued to dequeued by the RX thread
+    APP_UART_STAGE_RX_DISPATCH, // dequeued to user callback entry
+    APP_UART_STAGE_RX_CALLBACK, // user callback entry to exit
+    APP_UART_STAGE_RX_LATENCY,  // UART_RX_RDY to user callback entry
+    APP_UART_STAGE_TX_WIRE,     // uart_tx() to UART_TX_DONE
+    APP_UART_STAGE_COUNT,
+};
+
+/* log2 histogram in us: bucket 0 is < 1 us, bucket n is [2^(n-1), 2^n) us,
+ * the last one collects everything above */
+#define APP_UART_STATS_HIST_BUCKETS 16
+
+struct app_uart_stage_stats {
+    uint32_t count;
+    uint32_t min;   // cycles
+    uint32_t max;   // cycles
+    uint64_t sum;   // cycles
+    uint32_t hist[APP_UART_STATS_HIST_BUCKETS];
+};
+
+enum app_uart_counter {
+    APP_UART_CNT_RX_BYTES,
+    APP_UART_CNT_RX_DROPPED,        // chunks dropped, RX queue or ring full
+    APP_UART_CNT_RX_DROPPED_BYTES,
+    APP_UART_CNT_RX_SLAB_EXHAUSTED, // no free RX DMA block on UART_RX_BUF_REQUEST
+    APP_UART_CNT_RX_REARMS,         // RX enabled again after exhaustion
+    APP_UART_CNT_RX_ERRORS,         // UART_RX_STOPPED
+    APP_UART_CNT_TX_BYTES,
+    APP_UART_CNT_TX_NO_SPACE,       // TX staging buffer full
+    APP_UART_CNT_TX_ERRORS,         // uart_tx() failed
+    APP_UART_CNT_TX_ABORTS,
+    APP_UART_CNT_COUNT,
+};
+
+struct app_uart_stats {
+    uint32_t counters[APP_UART_CNT_COUNT];
+    struct app_uart_stage_stats stages[APP_UART_STAGE_COUNT];
+};
+
+#if IS_ENABLED(CONFIG_APP_UART_STATS)
+
+/**
+ * @brief Get a snapshot of the statistics of a port
+ * @param port Port index, see app_uart_index()
+ * @param stats Filled with the statistics
+ */
+void app_uart_stats_get(size_t port, struct app_uart_stats *stats);
+
+/**
+ * @brief Reset all the statistics of a port
+ * @param port Port index, see app_uart_index()
+ */
+void app_uart_stats_reset(size_t port);
+
+const char *app_uart_stage_name(enum app_uart_stage stage);
+const char *app_uart_counter_name(enum app_uart_counter counter);
+
+/* used by app_uart, ISR safe */
+void app_uart_stats_add(size_t port, enum app_uart_counter counter, uint32_t value);
+void app_uart_stats_stage(size_t port, enum app_uart_stage stage, uint32_t start, uint32_t end);
+
+static inline uint32_t app_uart_stats_ts(void)
+{
+    return k_cycle_get_32();
+}
+
+#else
+
+/* compiled out */
+static inline void app_uart_stats_add(size_t port, enum app_uart_counter counter,
+                                      uint32_t value) {}
+static inline void app_uart_stats_stage(size_t port, enum app_uart_stage stage,
+                                        uint32_t start, uint32_t end) {}
+static inline uint32_t app_uart_stats_ts(void)
+{
+    return 0;
+}
+
+#endif /* CONFIG_APP_UART_STATS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_UART_STATS_H
@@ -0,0 +1,53 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#include "app_uart_trace.h"
+
+struct app_uart_trace_ring app_uart_trace_ring = {
+    .enabled = ATOMIC_INIT(IS_ENABLED(CONFIG_APP_UART_TRACE_AUTOSTART)),
+};
+
+void app_uart_trace_enable(bool enable)
+{
+    atomic_set(&app_uart_trace_ring.enabled, enable);
+}
+
+bool app_uart_trace_enabled(void)
+{
+    return atomic_get(&app_uart_trace_ring.enabled) != 0;
+}
+
+void app_uart_trace_clear(void)
+{
+    bool enabled = app_uart_trace_enabled();
+
+    app_uart_trace_enable(false);
+    atomic_clear(&app_uart_trace_ring.head);
+    memset(app_uart_trace_ring.records, 0, sizeof(app_uart_trace_ring.records));
+    app_uart_trace_enable(enabled);
+}
+
+size_t app_uart_trace_stored(uint32_t *lost)
+{
+    uint32_t head = (uint32_t)atomic_get(&app_uart_trace_ring.head);
+    uint32_t stored = MIN(head, APP_UART_TRACE_RECORDS);
+
+    if (lost != NULL) {
+        *lost = head - stored;
+    }
+    return stored;
+}
+
+size_t app_uart_trace_read(size_t skip, struct app_uart_trace_record *out, size_t max)
+{
+    uint32_t head = (uint32_t)atomic_get(&app_uart_trace_ring.head);
+    uint32_t stored = MIN(head, APP_UART_TRACE_RECORDS);
+    uint32_t first = head - stored;
+    size_t n = 0;
+
+    for (uint32_t i = skip; i < stored && n < max; i++, n++) {
+        out[n] = app_uart_trace_ring.records[(first + i) & (APP_UART_TRACE_RECORDS - 1)];
+    }
+
+    return n;
+}
@@ -0,0 +1,123 @@
+#ifndef __APP_UART_TRACE_H
+#define __APP_UART_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Trace events, the values are part of the dump format,
+ * keep them in sync with scripts/uart_trace_decode.py */
+enum app_uart_trace_event {
+    APP_UART_TRACE_TX_START = 1,    // arg: bytes
+    APP_UART_TRACE_TX_DONE,         // arg: bytes
+    APP_UART_TRACE_TX_ABORTED,      // arg: bytes
+    APP_UART_TRACE_TX_ERROR,        // arg: bytes dropped
+    APP_UART_TRACE_RX_RDY,          // arg: bytes
+    APP_UART_TRACE_RX_DROP,         // arg: bytes dropped
+    APP_UART_TRACE_RX_BUF_REQUEST,  // arg: block index, 0xffff if exhausted
+    APP_UART_TRACE_RX_BUF_RELEASED, // arg: block index
+    APP_UART_TRACE_RX_DISABLED,
+    APP_UART_TRACE_RX_STOPPED,      // arg: reason
+    APP_UART_TRACE_RX_DISPATCH,     // arg: bytes, user callback entry
+    APP_UART_TRACE_RX_DISPATCHED,   // arg: bytes, user callback exit
+    APP_UART_TRACE_RX_REARM,        // RX enabled again after buffer exhaustion
+    APP_UART_TRACE_PM_SUSPEND,      // suspended when idle or by app_uart_sleep()
+    APP_UART_TRACE_PM_RESUME,       // arg: 1 if woken up by RX, 0 by TX
+    APP_UART_TRACE_RX_POINT,        // arg: new RX DMA length, CONFIG_APP_UART_RX_ADAPTIVE
+    APP_UART_TRACE_RX_FRAME_END,    // arg: 1 if found after the chunk, CONFIG_APP_UART_RX_FRAME_GAP
+};
+
+/* One fixed-size record, little endian in the dump */
+struct app_uart_trace_record {
+    uint32_t ts;    // k_cycle_get_32()
+    uint8_t event;
+    uint8_t port;   // app_uart_index()
+    uint16_t arg;
+};
+
+#if IS_ENABLED(CONFIG_APP_UART_TRACE)
+
+#define APP_UART_TRACE_RECORDS CONFIG_APP_UART_TRACE_RECORDS
+
+BUILD_ASSERT((APP_UART_TRACE_RECORDS & (APP_UART_TRACE_RECORDS - 1)) == 0,
+             "Trace record number must be a power of two");
+
+struct app_uart_trace_ring {
+    atomic_t head;      // free running, next record to write
+    atomic_t enabled;
+    struct app_uart_trace_record records[APP_UART_TRACE_RECORDS];
+};
+
+extern struct app_uart_trace_ring app_uart_trace_ring;
+
+/**
+ * @brief Record an event, ISR safe
+ *
+ * Claims a slot with one atomic increment and overwrites the oldest record
+ * when the ring is full.
+ */
+static inline void app_uart_trace(size_t port, enum app_uart_trace_event event, uint32_t arg)
+{
+    if (!atomic_get(&app_uart_trace_ring.enabled)) {
+        return;
+    }
+
+    uint32_t idx = (uint32_t)atomic_inc(&app_uart_trace_ring.head);
+    struct app_uart_trace_record *rec =
+        &app_uart_trace_ring.records[idx & (APP_UART_TRACE_RECORDS - 1)];
+
+    rec->ts = k_cycle_get_32();
+    rec->event = event;
+    rec->port = port;
+    rec->arg = (uint16_t)MIN(arg, UINT16_MAX);
+}
+
+/**
+ * @brief Start or stop recording
+ */
+void app_uart_trace_enable(bool enable);
+
+/**
+ * @brief Drop all the records
+ */
+void app_uart_trace_clear(void);
+
+/**
+ * @brief Check if recording is on
+ */
+bool app_uart_trace_enabled(void);
+
+/**
+ * @brief Number of records stored
+ * @param lost Set to the number of records overwritten since the last clear, may be NULL
+ */
+size_t app_uart_trace_stored(uint32_t *lost);
+
+/**
+ * @brief Copy records out, oldest first
+ *
+ * Stop the recording first for a consistent snapshot.
+ * @param skip Number of the oldest records to skip
+ * @param out Buffer for the records
+ * @param max Capacity of out, in records
+ * @return Number of records copied
+ */
+size_t app_uart_trace_read(size_t skip, struct app_uart_trace_record *out, size_t max);
+
+#else
+
+/* compiled out */
+static inline void app_uart_trace(size_t port, enum app_uart_trace_event event, uint32_t arg) {}
+
+#endif /* CONFIG_APP_UART_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__APP_UART_TRACE_H
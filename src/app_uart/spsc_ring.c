@@ -0,0 +1,50 @@
+#include <errno.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/__assert.h>
+
+#include "spsc_ring.h"
+
+int spsc_ring_put(struct spsc_ring *ring, const uint8_t *data, size_t len)
+{
+    uint32_t head = (uint32_t)atomic_get(&ring->head);
+    uint32_t used = head - (uint32_t)atomic_get(&ring->tail);
+
+    if (len > ring->size - used) {
+        ring->overflows++;
+        ring->dropped_bytes += len;
+        return -ENOMEM;
+    }
+
+    // copy in up to two pieces, the second one after wrap around
+    uint32_t idx = head & (ring->size - 1);
+    uint32_t first = MIN(len, ring->size - idx);
+
+    memcpy(&ring->buf[idx], data, first);
+    memcpy(&ring->buf[0], &data[first], len - first);
+
+    // atomic_set is a full barrier, the data is visible before the new head
+    atomic_set(&ring->head, (atomic_val_t)(head + len));
+
+    used += len;
+    if (used > ring->high_watermark) {
+        ring->high_watermark = used;
+    }
+    return 0;
+}
+
+uint32_t spsc_ring_peek(struct spsc_ring *ring, uint8_t **data)
+{
+    uint32_t tail = (uint32_t)atomic_get(&ring->tail);
+    uint32_t used = (uint32_t)atomic_get(&ring->head) - tail;
+    uint32_t idx = tail & (ring->size - 1);
+
+    *data = &ring->buf[idx];
+    return MIN(used, ring->size - idx);
+}
+
+void spsc_ring_consume(struct spsc_ring *ring, uint32_t len)
+{
+    __ASSERT(len <= spsc_ring_used(ring), "Consuming more than stored");
+    atomic_add(&ring->tail, (atomic_val_t)len);
+}
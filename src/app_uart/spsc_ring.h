@@ -0,0 +1,72 @@
+#ifndef __SPSC_RING_H
+#define __SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Lock-free single-producer/single-consumer byte ring
+ *
+ * head is only written by the producer and tail only by the consumer,
+ * both run freely and are masked with (size - 1), so size must be a power of two.
+ * The producer is typically the UART ISR and the consumer a thread.
+ */
+struct spsc_ring {
+    uint8_t *buf;
+    uint32_t size;
+    atomic_t head;
+    atomic_t tail;
+
+    /* statistics, written by the producer */
+    uint32_t high_watermark;
+    uint32_t overflows;
+    uint32_t dropped_bytes;
+};
+
+/**
+ * @brief Number of bytes stored in the ring
+ */
+static inline uint32_t spsc_ring_used(const struct spsc_ring *ring)
+{
+    return (uint32_t)atomic_get(&ring->head) - (uint32_t)atomic_get(&ring->tail);
+}
+
+/**
+ * @brief Producer: copy a chunk into the ring
+ *
+ * The chunk is stored completely or not at all,
+ * a chunk that doesn't fit is counted as an overflow.
+ * @param ring Ring
+ * @param data Data to store
+ * @param len Length of data
+ * @return 0 on success, -ENOMEM if there is not enough space
+ */
+int spsc_ring_put(struct spsc_ring *ring, const uint8_t *data, size_t len);
+
+/**
+ * @brief Consumer: get the longest contiguous span of stored bytes
+ *
+ * The span stays valid until it is consumed.
+ * @param ring Ring
+ * @param data Set to the first stored byte
+ * @return Length of the span, 0 if the ring is empty
+ */
+uint32_t spsc_ring_peek(struct spsc_ring *ring, uint8_t **data);
+
+/**
+ * @brief Consumer: release bytes returned by spsc_ring_peek()
+ * @param ring Ring
+ * @param len Number of bytes to release
+ */
+void spsc_ring_consume(struct spsc_ring *ring, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__SPSC_RING_H
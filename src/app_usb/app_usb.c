@@ -19,9 +19,21 @@ LOG_MODULE_REGISTER(app_usb, CONFIG_APP_USB_LOG_LEVEL);
 /*
  * This is intended for use with cdc-acm-snippet or as a default serial backend
  * only in applications where no other USB features are required, configured,
- * and enabled. This code only registers the first CDC-ACM instance.
+ * and enabled. Every enabled "zephyr,cdc-acm-uart" node is one CDC-ACM
+ * function of the composite device, see usb_multi.overlay.
  */
 
+#define DT_DRV_COMPAT zephyr_cdc_acm_uart
+
+/* the CDC-ACM class instances are named after the devicetree instances */
+#define CDC_ACM_CLASS_NAME(inst) "cdc_acm_" #inst,
+
+static const char *const cdc_acm_classes[] = {
+	DT_INST_FOREACH_STATUS_OKAY(CDC_ACM_CLASS_NAME)
+};
+
+BUILD_ASSERT(ARRAY_SIZE(cdc_acm_classes) > 0, "No zephyr,cdc-acm-uart node enabled");
+
 USBD_DEVICE_DEFINE(cdc_acm_serial,
 		   DEVICE_DT_GET(DT_NODELABEL(zephyr_udc0)),
 		   CONFIG_APP_USB_CDC_ACM_SERIAL_VID, CONFIG_APP_USB_CDC_ACM_SERIAL_PID);
@@ -47,8 +59,8 @@ USBD_CONFIGURATION_DEFINE(cdc_acm_serial_hs_config,
 
 static struct usbd_context *usbd_ctx = &cdc_acm_serial;
 
-static int register_cdc_acm_0(struct usbd_context *const uds_ctx,
-			      const enum usbd_speed speed)
+static int register_cdc_acm(struct usbd_context *const uds_ctx,
+			    const enum usbd_speed speed)
 {
 	struct usbd_config_node *cfg_nd;
 	int err;
@@ -65,12 +77,16 @@ static int register_cdc_acm_0(struct usbd_context *const uds_ctx,
 		return err;
 	}
 
-	err = usbd_register_class(usbd_ctx, "cdc_acm_0", speed, 1);
-	if (err) {
-		LOG_ERR("Failed to register classes");
-		return err;
+	// one function each, the class adds its interface association descriptor
+	for (size_t i = 0; i < ARRAY_SIZE(cdc_acm_classes); i++) {
+		err = usbd_register_class(uds_ctx, cdc_acm_classes[i], speed, 1);
+		if (err) {
+			LOG_ERR("Failed to register class %s (%d)", cdc_acm_classes[i], err);
+			return err;
+		}
 	}
 
+	// IAD code triple, required once there is more than one function
 	return usbd_device_set_code_triple(uds_ctx, speed,
 					   USB_BCC_MISCELLANEOUS, 0x02, 0x01);
 }
@@ -108,17 +124,19 @@ static int cdc_acm_serial_init_device(void)
 
 	if (USBD_SUPPORTS_HIGH_SPEED &&
 	    usbd_caps_speed(usbd_ctx) == USBD_SPEED_HS) {
-		err = register_cdc_acm_0(usbd_ctx, USBD_SPEED_HS);
+		err = register_cdc_acm(usbd_ctx, USBD_SPEED_HS);
 		if (err) {
 			return err;
 		}
 	}
 
-	err = register_cdc_acm_0(usbd_ctx, USBD_SPEED_FS);
+	err = register_cdc_acm(usbd_ctx, USBD_SPEED_FS);
 	if (err) {
 		return err;
 	}
 
+	LOG_INF("%u CDC-ACM channels", (unsigned int)ARRAY_SIZE(cdc_acm_classes));
+
 	err = usbd_init(usbd_ctx);
 	if (err) {
 		LOG_ERR("Failed to initialize %s (%d)", "device support", err);
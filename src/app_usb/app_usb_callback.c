@@ -18,6 +18,10 @@ LOG_MODULE_DECLARE(app_usb);
 
 #include "app_usb.h"
 
+#if defined(CONFIG_APP_BRIDGE)
+#include "app_bridge.h"
+#endif
+
 struct usb_smf_ctx {
 	struct smf_ctx ctx;
 	const struct usbd_msg *msg;
@@ -196,6 +200,9 @@ static enum smf_state_result usb_state_configured_run(void *obj)
                 LOG_INF("\tBaudrate %u", baudrate);
             }
             
+#if defined(CONFIG_APP_BRIDGE)
+            app_bridge_line_coding(msg->dev);
+#endif
         }
         return SMF_EVENT_HANDLED;
 	default:
@@ -1,5 +1,8 @@
 #include <zephyr/kernel.h>
+
+#if defined(CONFIG_DK_LIBRARY)
 #include <dk_buttons_and_leds.h>
+#endif
 
 // nRF91 Series modem library
 #if defined(CONFIG_NRF_MODEM_LIB)
@@ -10,116 +13,274 @@
 LOG_MODULE_REGISTER(app, CONFIG_APP_LOG_LEVEL);
 
 #include "app_uart.h"
+#include "app_framer.h"
 
-/* RX packets buffer */
-static uint8_t serial_cmd_buf[256];
+#if defined(CONFIG_APP_BENCH)
+#include "app_bench.h"
+#endif
+
+#if defined(CONFIG_APP_BRIDGE)
+#include "app_bridge.h"
+#endif
+
+#if defined(CONFIG_APP_BAUD)
+#include "app_baud.h"
+#endif
+
+#if defined(CONFIG_APP_MUX)
+#include "app_mux.h"
+#endif
+
+#if defined(CONFIG_APP_ARQ)
+#include "app_arq.h"
+#endif
+
+#if defined(CONFIG_APP_LZ)
+#include "app_lz.h"
+#endif
 
-/* RX FSM states */
-enum protocol_state {
-    S_DATA_RECEIVED, // normal data state
-    S_CR_RECEIVED, // received '\r' last time
+#if defined(CONFIG_APP_POOL)
+#include <string.h>
+#include "app_pool.h"
+#endif
+
+#define SERIAL_PORT app_uart_get(APP_UART_DEFAULT_NODE)
+
+#if defined(CONFIG_APP_POOL)
+/* Packets waiting for main() to loop them back, out of the shared RX context */
+struct loopback_packet {
+    uint8_t *buf;           // of app_pool_alloc()
+    size_t len;
 };
 
-static void bytes_to_packet(uint8_t byte)
-{
-    static uint32_t len = 0;
-    static enum protocol_state state = S_DATA_RECEIVED; 
-
-    if (len >= sizeof(serial_cmd_buf)) {
-        LOG_WRN("Serial command buffer overflow, resetting");
-        // reset
-        len = 0;
-        state = S_DATA_RECEIVED;
-        return;
-    }
+#define LOOPBACK_QUEUE_DEPTH 8
 
-    serial_cmd_buf[len++] = byte;
+K_MSGQ_DEFINE(loopback_queue, sizeof(struct loopback_packet), LOOPBACK_QUEUE_DEPTH, sizeof(void *));
 
-    switch(state) {
+BUILD_ASSERT(CONFIG_APP_FRAMER_MAX_FRAME_LEN <= APP_POOL_MAX_LEN,
+             "a frame must fit in the largest pool class");
+#endif
 
-    case S_DATA_RECEIVED:
-        if ('\r' == byte) {
-            state = S_CR_RECEIVED;  
-        }
-        break;
+static void loopback(const uint8_t *packet, size_t len)
+{
+    LOG_HEXDUMP_INF(packet, len, "Received packets:");
 
+    int err = app_framer_send(SERIAL_PORT, packet, len);
+    if (err) {
+        LOG_ERR("Failed to send loopback data: %d", err);
+    }
+}
 
-    case S_CR_RECEIVED:
-    {   
-        if ('\n' == byte) {
-            LOG_HEXDUMP_INF(serial_cmd_buf, len, "Received packets:");
+static void packet_handler(struct app_framer *framer, uint8_t *packet, size_t len)
+{
+#if defined(CONFIG_APP_BAUD)
+    // baud rate negotiation messages are not looped back
+    if (app_baud_frame(SERIAL_PORT, packet, len)) {
+        return;
+    }
+#endif
 
-            // loopback
-            int err = app_uart_tx(serial_cmd_buf, len);
-            if (err) {
-                LOG_ERR("Failed to send loopback data: %d", err);
-            }
+#if defined(CONFIG_APP_MUX)
+    // channel frames go to the channel callbacks
+    if (app_mux_frame(SERIAL_PORT, packet, len)) {
+        return;
+    }
+#endif
 
-            // clear
-            len = 0;
-            state = S_DATA_RECEIVED;
+#if defined(CONFIG_APP_ARQ)
+    // reliable transport frames are delivered in order to arq_handler()
+    if (app_arq_frame(SERIAL_PORT, packet, len)) {
+        return;
+    }
+#endif
 
-        } else {
-            LOG_WRN("Received \\r, but no \\n after!!!");
-            // reset
-            len = 0;
-            state = S_DATA_RECEIVED;
-        }
-        break;
+#if defined(CONFIG_APP_LZ)
+    // compressed frames are delivered decompressed to lz_handler()
+    if (app_lz_frame(SERIAL_PORT, packet, len)) {
+        return;
     }
+#endif
+
+#if defined(CONFIG_APP_POOL)
+    // the packet is only valid until we return, keep a copy for main()
+    struct loopback_packet pkt = {
+        .buf = app_pool_alloc(len),
+        .len = len,
+    };
 
-    default:
-        LOG_ERR("Unknown state!");
-        // reset state to prevent infinite error logging
-        len = 0;
-        state = S_DATA_RECEIVED;
-        break;
+    if (pkt.buf == NULL) {
+        LOG_WRN("No pool block for a %u byte packet", (uint32_t)len);
+        return;
     }
+    memcpy(pkt.buf, packet, len);
+    if (k_msgq_put(&loopback_queue, &pkt, K_NO_WAIT)) {
+        LOG_WRN("Loopback queue full, packet dropped");
+        app_pool_free(pkt.buf);
+    }
+#else
+    loopback(packet, len);
+#endif
 }
 
-static void uart_callback(uint8_t *byte, size_t len)
+/* RX packets buffer */
+APP_FRAMER_DEFINE(serial_framer, CONFIG_APP_FRAMER_MAX_FRAME_LEN, packet_handler);
+
+static void uart_callback(struct app_uart *uart, uint8_t *byte, size_t len)
 {
+    if (app_uart_rx_frame_end(uart)) {
+        // the line went idle, the gap framer ends the frame, the bytes may be none
+        app_framer_feed_end(&serial_framer, byte, len);
+        return;
+    }
+
     if (byte == NULL || len == 0) {
         LOG_WRN("Invalid callback parameters");
         return;
     }
     
     // received are byte streams, we need to transform them into packets
-    for (size_t i = 0; i < len; i++) {
-        bytes_to_packet(byte[i]);
+    app_framer_feed(&serial_framer, byte, len);
+}
+
+#if defined(CONFIG_APP_MUX)
+static void mux_handler(uint8_t ch, const uint8_t *data, size_t len, void *user_data)
+{
+    // loopback on the same channel
+    int err = app_mux_send(ch, data, len, K_NO_WAIT);
+    if (err) {
+        LOG_ERR("Failed to send loopback data on channel %u: %d", ch, err);
     }
 }
 
+static int mux_start(void)
+{
+    int err = app_mux_attach(SERIAL_PORT);
+    if (err) {
+        return err;
+    }
+
+    // channel 0 carries the commands, ahead of the others
+    for (uint8_t ch = 0; ch < CONFIG_APP_MUX_CHANNELS; ch++) {
+        const struct app_mux_chan_cfg cfg = {
+            .priority = (ch == 0) ? 0 : 1,
+            .weight = 1,
+            .cb = mux_handler,
+        };
+
+        err = app_mux_open(ch, &cfg);
+        if (err) {
+            return err;
+        }
+    }
+    return 0;
+}
+#endif /* CONFIG_APP_MUX */
+
+#if defined(CONFIG_APP_ARQ)
+static void arq_handler(struct app_uart *uart, const uint8_t *data, size_t len)
+{
+    LOG_HEXDUMP_INF(data, len, "Received reliably:");
+
+    // loopback, reliable as well
+    int err = app_arq_send(uart, data, len, K_NO_WAIT);
+    if (err) {
+        LOG_ERR("Failed to send loopback data: %d", err);
+    }
+}
+#endif /* CONFIG_APP_ARQ */
+
+#if defined(CONFIG_APP_LZ)
+static void lz_handler(struct app_uart *uart, const uint8_t *data, size_t len)
+{
+    LOG_HEXDUMP_INF(data, len, "Received compressed:");
+
+    // loopback, compressed as well
+    int err = app_lz_send(uart, data, len);
+    if (err) {
+        LOG_ERR("Failed to send loopback data: %d", err);
+    }
+}
+#endif /* CONFIG_APP_LZ */
+
+#if defined(CONFIG_DK_LIBRARY)
 void button_handler(uint32_t button_state, uint32_t has_changed)
 {
     uint32_t button = button_state & has_changed;
     if (DK_BTN1_MSK & button) {
         LOG_INF("Suspend UART");
-        int err = app_uart_sleep();
+        int err = app_uart_sleep(SERIAL_PORT);
         if (err) {
             LOG_ERR("Failed to suspend UART: %d", err);
         }
     }
     if (DK_BTN2_MSK & button) {
         LOG_INF("Resume UART");
-        int err = app_uart_wakeup();
+        int err = app_uart_wakeup(SERIAL_PORT);
         if (err) {
             LOG_ERR("Failed to resume UART: %d", err);
         }
     }
 }
+#endif /* CONFIG_DK_LIBRARY */
 
 int main()
 {
     int err;
     
     LOG_INF("Starting UART application");
-    
+
+#if defined(CONFIG_APP_BENCH)
+    /* benchmark instead of loopback */
+    return app_bench_run();
+#endif
+
+#if defined(CONFIG_APP_BRIDGE)
+    /* USB to UART bridge instead of loopback */
+    return app_bridge_start();
+#endif
+
+#if defined(CONFIG_DK_LIBRARY)
     /* application buttons */
     dk_buttons_init(button_handler);
+#endif
+
+#if defined(CONFIG_APP_BAUD_AUTO)
+    /* before the RX callback, auto-baud takes it over meanwhile */
+    uint32_t baudrate;
+
+    err = app_baud_auto(SERIAL_PORT, K_MSEC(CONFIG_APP_BAUD_AUTO_TIMEOUT_MS), &baudrate);
+    if (err) {
+        LOG_WRN("No baud rate detected: %d", err);
+    }
+#endif
+
+#if defined(CONFIG_APP_MUX)
+    /* virtual channels over the port */
+    err = mux_start();
+    if (err) {
+        LOG_ERR("Failed to start the multiplexer: %d", err);
+        return err;
+    }
+#endif
+
+#if defined(CONFIG_APP_ARQ)
+    err = app_arq_open(SERIAL_PORT, arq_handler);
+    if (err) {
+        LOG_ERR("Failed to open the reliable transport: %d", err);
+        return err;
+    }
+#endif
+
+#if defined(CONFIG_APP_LZ)
+    err = app_lz_open(SERIAL_PORT, lz_handler);
+    if (err) {
+        LOG_ERR("Failed to open compression: %d", err);
+        return err;
+    }
+#endif
 
     /* UART RX init */
-    err = app_uart_rx_cb_register(uart_callback);
+    err = app_uart_rx_cb_register(SERIAL_PORT, uart_callback);
     if (err) {
         LOG_ERR("Failed to register RX callback: %d", err);
         return err;
@@ -133,8 +294,17 @@ int main()
     nrf_modem_lib_init();
 #endif
 
-    uint8_t start_msg[] = "UART EXAMPLE START\r\n";
-    app_uart_tx(start_msg, sizeof(start_msg) - 1);
+    uint8_t start_msg[] = "UART EXAMPLE START";
+    app_framer_send(SERIAL_PORT, start_msg, sizeof(start_msg) - 1);
+
+#if defined(CONFIG_APP_POOL)
+    struct loopback_packet pkt;
+
+    while (k_msgq_get(&loopback_queue, &pkt, K_FOREVER) == 0) {
+        loopback(pkt.buf, pkt.len);
+        app_pool_free(pkt.buf);
+    }
+#endif
 
     k_sleep(K_FOREVER);
     return 0;